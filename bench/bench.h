@@ -0,0 +1,108 @@
+// Copyright (c) 2014-2015, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+
+#ifndef BENCH_BENCH_H_
+#define BENCH_BENCH_H_
+
+#include <cstdio>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <yeti/yeti.h>
+
+namespace bench {
+
+/** @brief Percentiles of samples in nanoseconds. */
+struct Percentiles {
+  std::int64_t p50;
+  std::int64_t p90;
+  std::int64_t p99;
+  std::int64_t p999;
+  std::int64_t max;
+};
+
+/** @brief Returns percentiles of samples (they are sorted in place). */
+inline Percentiles GetPercentiles(std::vector<std::int64_t>* samples) {
+  if (samples->empty()) return Percentiles{0, 0, 0, 0, 0};
+  std::sort(samples->begin(), samples->end());
+  auto at = [samples](double quantile) {
+    std::size_t index = static_cast<std::size_t>(quantile * samples->size());
+    return (*samples)[std::min(index, samples->size() - 1)];
+  };
+  return Percentiles{at(0.5), at(0.9), at(0.99), at(0.999), samples->back()};
+}
+
+/** @brief Returns nanoseconds elapsed since start. */
+inline std::int64_t NanosSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+inline ssize_t DiscardWrite(void*, const char*, size_t size) {
+  return size;
+}
+
+/**
+ * @brief Opens sink by name: "null" discards records without system calls,
+ * "devnull" is /dev/null, anything else is path of file to truncate.
+ */
+inline FILE* OpenSink(const std::string& name) {
+  if (name == "null") {
+    cookie_io_functions_t funcs = { nullptr, &DiscardWrite, nullptr,
+                                    nullptr };
+    return fopencookie(nullptr, "w", funcs);
+  }
+  return std::fopen(name == "devnull" ? "/dev/null" : name.c_str(), "w");
+}
+
+/** @brief Parses engine name: "thread" or "combining". */
+inline bool ParseEngine(const std::string& name, yeti::LogEngine* engine) {
+  if (name == "thread") {
+    *engine = yeti::LOG_ENGINE_THREAD;
+  } else if (name == "combining") {
+    *engine = yeti::LOG_ENGINE_COMBINING;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/** @brief Prints warning if benchmark is built without optimization. */
+inline void WarnIfNotOptimized() {
+#ifndef __OPTIMIZE__
+  std::printf("warning: built without optimization, configure with "
+              "-DCMAKE_BUILD_TYPE=Release\n");
+#endif  // __OPTIMIZE__
+}
+
+}  // namespace bench
+
+#endif  // BENCH_BENCH_H_
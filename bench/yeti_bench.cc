@@ -0,0 +1,185 @@
+// Copyright (c) 2014-2015, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+
+// Benchmark of producer cost of logging calls: every call is timed alone,
+// and percentiles of calls are compared with snprintf+write baseline. Cases
+// are run with every engine of the list.
+//
+// usage: yeti_bench [--iterations N] [--sink devnull|null|PATH]
+//                   [--engines thread,combining]
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <yeti/yeti.h>
+
+#include "bench.h"
+
+namespace {
+
+// returns durations of calls of func in nanoseconds minus timer overhead
+std::vector<std::int64_t> MeasureCalls(const std::function<void(int)>& func,
+                                       int iterations,
+                                       std::int64_t overhead) {
+  std::vector<std::int64_t> samples(iterations);
+  for (int i = 0; i < iterations; ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    func(i);
+    samples[i] = std::max<std::int64_t>(bench::NanosSince(start) - overhead,
+                                        0);
+  }
+  return samples;
+}
+
+// median cost of reading clock twice
+std::int64_t MeasureTimerOverhead() {
+  std::vector<std::int64_t> samples = MeasureCalls([](int) {}, 100000, 0);
+  return bench::GetPercentiles(&samples).p50;
+}
+
+struct Case {
+  const char* name;
+  std::function<void(int)> func;
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int iterations = 200000;
+  std::string sink_name = "devnull";
+  std::vector<std::string> engines = {"thread", "combining"};
+  bool is_valid = argc % 2 == 1;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--iterations") == 0) {
+      iterations = std::max(std::atoi(argv[i + 1]), 1);
+    } else if (std::strcmp(argv[i], "--sink") == 0) {
+      sink_name = argv[i + 1];
+    } else if (std::strcmp(argv[i], "--engines") == 0) {
+      engines.clear();
+      std::istringstream input(argv[i + 1]);
+      yeti::LogEngine engine;
+      for (std::string name; std::getline(input, name, ','); ) {
+        is_valid = is_valid && bench::ParseEngine(name, &engine);
+        engines.push_back(name);
+      }
+    } else {
+      is_valid = false;
+    }
+  }
+  if (!is_valid || engines.empty()) {
+    std::fprintf(stderr, "usage: %s [--iterations N] "
+                 "[--sink devnull|null|PATH] [--engines thread,combining]\n",
+                 argv[0]);
+    return 1;
+  }
+  FILE* sink = bench::OpenSink(sink_name);
+  if (sink == nullptr) {
+    std::fprintf(stderr, "can't open sink %s\n", sink_name.c_str());
+    return 1;
+  }
+  yeti::SetLogFileDesc(sink);
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+
+  const std::string word = "benchmark";
+  const std::string long_msg(1024, 'x');
+  // null sink has no descriptor, so baseline writes into /dev/null instead
+  int sink_fileno = fileno(sink);
+  if (sink_fileno < 0) sink_fileno = open("/dev/null", O_WRONLY);
+  std::vector<Case> cases = {
+    {"snprintf+write (baseline)", [&](int i) {
+      char buf[256];
+      int len = std::snprintf(buf, sizeof(buf), "value %d of %s\n", i,
+                              word.c_str());
+      if (write(sink_fileno, buf, len) < 0) std::abort();
+    }},
+    {"disabled level", [&](int i) { DBG("value %d", i); }},
+    {"enabled, int", [&](int i) { INF("value %d", i); }},
+    {"enabled, int and string", [&](int i) {
+      INF("value %d of %s", i, word.c_str());
+    }},
+    {"enabled {}, int", [&](int i) { INF_FMT("value {}", i); }},
+    {"enabled {}, int and string", [&](int i) {
+      INF_FMT("value {} of {}", i, word);
+    }},
+    {"enabled stream, int", [&](int i) { YETI_LOG(INF) << "value " << i; }},
+    {"enabled, 1 KB message", [&](int i) {
+      INF("%d %s", i, long_msg.c_str());
+    }},
+  };
+
+  bench::WarnIfNotOptimized();
+  const std::int64_t overhead = MeasureTimerOverhead();
+  std::printf("sink %s, %d calls per case, timer overhead %lld ns "
+              "subtracted\n", sink_name.c_str(), iterations,
+              static_cast<long long>(overhead));
+
+  for (const std::string& engine_name : engines) {
+    yeti::LogEngine engine;
+    bench::ParseEngine(engine_name, &engine);
+    yeti::SetLogEngine(engine);
+    std::printf("\nengine %s\n", engine_name.c_str());
+    std::printf("%-28s %8s %8s %8s %8s %10s %10s\n", "case (ns per call)",
+                "p50", "p90", "p99", "p99.9", "max", "p50/base");
+
+    double baseline = 0;
+    for (const Case& c : cases) {
+      // warm up caches, call sites and chunk pool of log queue
+      MeasureCalls(c.func, std::min(iterations, 1000), overhead);
+      yeti::FlushLog();
+      std::vector<std::int64_t> samples =
+          MeasureCalls(c.func, iterations, overhead);
+      yeti::FlushLog();
+
+      const bench::Percentiles p = bench::GetPercentiles(&samples);
+      if (baseline == 0) baseline = std::max<std::int64_t>(p.p50, 1);
+      std::printf("%-28s %8lld %8lld %8lld %8lld %10lld %10.2f\n", c.name,
+                  static_cast<long long>(p.p50),
+                  static_cast<long long>(p.p90),
+                  static_cast<long long>(p.p99),
+                  static_cast<long long>(p.p999),
+                  static_cast<long long>(p.max), p.p50 / baseline);
+    }
+  }
+
+  yeti::SetLogEngine(yeti::LOG_ENGINE_THREAD);
+  yeti::SetLogFileDesc(stderr);
+  yeti::FlushLog();
+  std::fclose(sink);
+  return 0;
+}
@@ -0,0 +1,343 @@
+// Copyright (c) 2014-2015, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+
+// Scalability benchmark: sweeps engine, number of producer threads, rate of
+// messages, payload size and sink, and records throughput, producer latency,
+// backend lag and dropped records of every case into CSV and JSON.
+//
+// usage: yeti_scale [--engines thread,combining] [--threads 1,2,4,...]
+//                   [--modes steady,burst,flood] [--payloads 16,256,1024]
+//                   [--sinks null,devnull,tmpfs,file]
+//                   [--messages N] [--rate N] [--burst N]
+//                   [--file-dir DIR] [--csv PATH] [--json PATH]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <yeti/yeti.h>
+
+#include "bench.h"
+
+namespace {
+
+/** @brief Settings of benchmark matrix. */
+struct Options {
+  std::vector<std::string> engines = {"thread", "combining"};
+  std::vector<std::string> threads = {"1", "2", "4", "8", "16", "32", "64"};
+  std::vector<std::string> modes = {"steady", "burst", "flood"};
+  std::vector<std::string> payloads = {"16", "256", "1024"};
+  std::vector<std::string> sinks = {"null", "devnull", "tmpfs", "file"};
+  long long messages = 100000;  // per case, split among threads
+  long long rate = 200000;      // messages per second of steady and burst
+  long long burst = 1000;       // messages of burst written back to back
+  std::string file_dir = ".";
+  std::string csv_path;
+  std::string json_path;
+};
+
+/** @brief Results of one case of matrix. */
+struct Result {
+  std::string engine;
+  int threads;
+  std::string mode;
+  int payload;
+  std::string sink;
+  long long messages;
+  double seconds;         // from start until all records are written
+  double throughput;      // records written per second
+  bench::Percentiles producer;  // nanoseconds per call
+  yeti::LogLatency lag;   // from call to write into sink
+  unsigned long long written;
+  unsigned long long dropped;
+  std::size_t peak_queue_depth;
+};
+
+std::vector<std::string> Split(const std::string& list) {
+  std::vector<std::string> items;
+  std::istringstream input(list);
+  for (std::string item; std::getline(input, item, ','); ) {
+    if (!item.empty()) items.push_back(item);
+  }
+  return items;
+}
+
+bool ParseOptions(int argc, char** argv, Options* options) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string key = argv[i];
+    const char* value = argv[i + 1];
+    if (key == "--engines") {
+      options->engines = Split(value);
+      yeti::LogEngine engine;
+      for (const std::string& name : options->engines) {
+        if (!bench::ParseEngine(name, &engine)) return false;
+      }
+    } else if (key == "--threads") {
+      options->threads = Split(value);
+    } else if (key == "--modes") {
+      options->modes = Split(value);
+    } else if (key == "--payloads") {
+      options->payloads = Split(value);
+    } else if (key == "--sinks") {
+      options->sinks = Split(value);
+    } else if (key == "--messages") {
+      options->messages = std::max(std::atoll(value), 1LL);
+    } else if (key == "--rate") {
+      options->rate = std::max(std::atoll(value), 1LL);
+    } else if (key == "--burst") {
+      options->burst = std::max(std::atoll(value), 1LL);
+    } else if (key == "--file-dir") {
+      options->file_dir = value;
+    } else if (key == "--csv") {
+      options->csv_path = value;
+    } else if (key == "--json") {
+      options->json_path = value;
+    } else {
+      return false;
+    }
+  }
+  return argc % 2 == 1;
+}
+
+// returns name of sink for bench::OpenSink()
+std::string GetSinkPath(const std::string& sink, const Options& options) {
+  if (sink == "tmpfs") return "/dev/shm/yeti_scale.log";
+  if (sink == "file") return options.file_dir + "/yeti_scale.log";
+  return sink;
+}
+
+Result RunCase(const std::string& engine, int threads, const std::string& mode,
+               int payload, const std::string& sink_name,
+               const Options& options) {
+  Result result = Result();
+  result.engine = engine;
+  result.threads = threads;
+  result.mode = mode;
+  result.payload = payload;
+  result.sink = sink_name;
+
+  const std::string path = GetSinkPath(sink_name, options);
+  FILE* sink = bench::OpenSink(path);
+  if (sink == nullptr) {
+    std::fprintf(stderr, "can't open sink %s\n", path.c_str());
+    std::exit(1);
+  }
+  yeti::LogHandleOptions handle_options;
+  handle_options.fd = sink;
+  bench::ParseEngine(engine, &handle_options.engine);
+  std::unique_ptr<yeti::LogHandle> handle(
+      new yeti::LogHandle(handle_options));
+
+  // every thread is paced to its share of rate: steady one writes messages
+  // evenly, burst one writes them back to back and then sleeps
+  const long long per_thread = std::max(options.messages / threads, 1LL);
+  result.messages = per_thread * threads;
+  const bool is_paced = mode != "flood";
+  const long long burst = mode == "burst" ? options.burst : 1;
+  const std::chrono::nanoseconds interval(
+      1000000000LL * threads / options.rate);
+  const std::string text(payload, 'x');
+
+  std::atomic<bool> is_started(false);
+  std::vector<std::vector<std::int64_t>> samples(threads);
+  std::vector<std::thread> producers;
+  for (int t = 0; t < threads; ++t) {
+    producers.emplace_back([&, t] {
+      std::vector<std::int64_t>& thread_samples = samples[t];
+      thread_samples.reserve(per_thread);
+      while (!is_started) std::this_thread::yield();
+      const auto start = std::chrono::steady_clock::now();
+      for (long long i = 0; i < per_thread; ++i) {
+        if (is_paced) {
+          std::this_thread::sleep_until(start + (i - i % burst) * interval);
+        }
+        const auto call_start = std::chrono::steady_clock::now();
+        INF_TO(*handle, "%lld %s", i, text.c_str());
+        thread_samples.push_back(bench::NanosSince(call_start));
+      }
+    });
+  }
+  const auto start = std::chrono::steady_clock::now();
+  is_started = true;
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+  handle->Flush();
+  const std::int64_t elapsed = bench::NanosSince(start);
+
+  std::vector<std::int64_t> all_samples;
+  all_samples.reserve(result.messages);
+  for (const auto& thread_samples : samples) {
+    all_samples.insert(all_samples.end(), thread_samples.begin(),
+                       thread_samples.end());
+  }
+  result.producer = bench::GetPercentiles(&all_samples);
+
+  const yeti::LogStats stats = handle->GetStats();
+  for (int level = 0; level < yeti::kLogLevelCount; ++level) {
+    result.written += stats.written[level];
+    result.dropped += stats.dropped[level];
+  }
+  result.lag = stats.write_latency[yeti::LOG_LEVEL_INFO];
+  result.peak_queue_depth = stats.peak_queue_depth;
+  result.seconds = elapsed / 1e9;
+  result.throughput = result.written / result.seconds;
+
+  handle.reset();
+  std::fclose(sink);
+  if (sink_name == "tmpfs" || sink_name == "file") std::remove(path.c_str());
+  return result;
+}
+
+const char kCsvHeader[] =
+    "engine,threads,mode,payload,sink,messages,seconds,throughput,"
+    "producer_p50_ns,producer_p90_ns,producer_p99_ns,producer_p999_ns,"
+    "producer_max_ns,lag_p50_ns,lag_p99_ns,lag_p999_ns,lag_max_ns,"
+    "written,dropped,peak_queue_depth";
+
+void WriteCsv(FILE* fd, const Result& r) {
+  std::fprintf(fd,
+               "%s,%d,%s,%d,%s,%lld,%.6f,%.0f,%lld,%lld,%lld,%lld,%lld,"
+               "%lld,%lld,%lld,%lld,%llu,%llu,%zu\n",
+               r.engine.c_str(), r.threads, r.mode.c_str(), r.payload,
+               r.sink.c_str(), r.messages, r.seconds, r.throughput,
+               static_cast<long long>(r.producer.p50),
+               static_cast<long long>(r.producer.p90),
+               static_cast<long long>(r.producer.p99),
+               static_cast<long long>(r.producer.p999),
+               static_cast<long long>(r.producer.max),
+               static_cast<long long>(r.lag.p50.count()),
+               static_cast<long long>(r.lag.p99.count()),
+               static_cast<long long>(r.lag.p999.count()),
+               static_cast<long long>(r.lag.max.count()),
+               r.written, r.dropped, r.peak_queue_depth);
+}
+
+void WriteJson(FILE* fd, const std::vector<Result>& results) {
+  std::fprintf(fd, "[\n");
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    const Result& r = results[i];
+    std::fprintf(
+        fd,
+        "  {\"engine\": \"%s\", \"threads\": %d, \"mode\": \"%s\", "
+        "\"payload\": %d, \"sink\": \"%s\", \"messages\": %lld, "
+        "\"seconds\": %.6f, \"throughput\": %.0f, "
+        "\"producer_ns\": {\"p50\": %lld, \"p90\": %lld, \"p99\": %lld, "
+        "\"p999\": %lld, \"max\": %lld}, "
+        "\"lag_ns\": {\"p50\": %lld, \"p99\": %lld, \"p999\": %lld, "
+        "\"max\": %lld}, "
+        "\"written\": %llu, \"dropped\": %llu, \"peak_queue_depth\": %zu}%s\n",
+        r.engine.c_str(), r.threads, r.mode.c_str(), r.payload,
+        r.sink.c_str(), r.messages, r.seconds, r.throughput,
+        static_cast<long long>(r.producer.p50),
+        static_cast<long long>(r.producer.p90),
+        static_cast<long long>(r.producer.p99),
+        static_cast<long long>(r.producer.p999),
+        static_cast<long long>(r.producer.max),
+        static_cast<long long>(r.lag.p50.count()),
+        static_cast<long long>(r.lag.p99.count()),
+        static_cast<long long>(r.lag.p999.count()),
+        static_cast<long long>(r.lag.max.count()), r.written, r.dropped,
+        r.peak_queue_depth, i + 1 < results.size() ? "," : "");
+  }
+  std::fprintf(fd, "]\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, &options)) {
+    std::fprintf(stderr,
+                 "usage: %s [--engines thread,combining] "
+                 "[--threads 1,2,4] [--modes steady,burst,flood] "
+                 "[--payloads 16,256] [--sinks null,devnull,tmpfs,file] "
+                 "[--messages N] [--rate N] [--burst N] [--file-dir DIR] "
+                 "[--csv PATH] [--json PATH]\n", argv[0]);
+    return 1;
+  }
+  bench::WarnIfNotOptimized();
+
+  std::printf("call latency and lag (from call to write) are in ns\n\n");
+  std::printf("%9s %7s %6s %7s %7s %12s %10s %10s %10s %10s %8s\n",
+              "engine", "threads", "mode", "payload", "sink", "records/s",
+              "call p50", "call p99", "lag p99", "lag max", "dropped");
+  std::vector<Result> results;
+  for (const std::string& sink : options.sinks) {
+    for (const std::string& payload : options.payloads) {
+      for (const std::string& mode : options.modes) {
+        for (const std::string& threads : options.threads) {
+          // engines are compared side by side in the same conditions
+          for (const std::string& engine : options.engines) {
+            const Result r = RunCase(
+                engine, std::max(std::atoi(threads.c_str()), 1), mode,
+                std::atoi(payload.c_str()), sink, options);
+            std::printf("%9s %7d %6s %7d %7s %12.0f %10lld %10lld %10lld "
+                        "%10lld %8llu\n", r.engine.c_str(), r.threads,
+                        r.mode.c_str(), r.payload, r.sink.c_str(),
+                        r.throughput,
+                        static_cast<long long>(r.producer.p50),
+                        static_cast<long long>(r.producer.p99),
+                        static_cast<long long>(r.lag.p99.count()),
+                        static_cast<long long>(r.lag.max.count()),
+                        r.dropped);
+            std::fflush(stdout);
+            results.push_back(r);
+          }
+        }
+      }
+    }
+  }
+
+  if (!options.csv_path.empty()) {
+    FILE* fd = std::fopen(options.csv_path.c_str(), "w");
+    if (fd == nullptr) return 1;
+    std::fprintf(fd, "%s\n", kCsvHeader);
+    for (const Result& r : results) {
+      WriteCsv(fd, r);
+    }
+    std::fclose(fd);
+  }
+  if (!options.json_path.empty()) {
+    FILE* fd = std::fopen(options.json_path.c_str(), "w");
+    if (fd == nullptr) return 1;
+    WriteJson(fd, results);
+    std::fclose(fd);
+  }
+  return 0;
+}
@@ -0,0 +1,198 @@
+/**
+ * @file backtrace.h
+ * @brief Capturing of filtered records into per-thread backtrace ring.
+ */
+
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+
+#ifndef INC_YETI_BACKTRACE_H_
+#define INC_YETI_BACKTRACE_H_
+
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <yeti/yeti.h>
+
+/// @cond
+
+namespace yeti {
+
+struct LogContextSnapshot;
+
+/** @brief Size of storage for format string and arguments of record. */
+const std::size_t kBacktraceArgsSize = 256;
+
+/**
+ * @brief Record captured into backtrace ring.
+ *
+ * Arguments are copied into record as is and message is formatted only when
+ * ring is flushed. If arguments don't fit into record, message is formatted
+ * at once and truncated to args storage.
+ */
+struct BacktraceRecord {
+  const LogSite* site;
+  std::size_t msg_id;
+  std::chrono::high_resolution_clock::time_point time;
+  // context of thread when record was captured (nullptr if it was empty)
+  std::shared_ptr<const LogContextSnapshot> context;
+  // formats message from args, nullptr if args contain formatted message
+  int (*format)(const char* args, char* msg, std::size_t size);
+  // args are arguments of {}-style call site to render by backend
+  bool is_encoded;
+  std::size_t args_size;
+  char args[kBacktraceArgsSize];
+};
+
+// ------------ auxiliary functions ------------
+BacktraceRecord* _NextBacktraceRecord();
+void _FlushBacktrace(const LogSite* trigger);
+// ---------------------------------------------
+
+/** @brief Stores arguments into buffer and formats message from them. */
+template <typename... Args> struct _ArgCodec;
+
+template <> struct _ArgCodec<> {
+  static bool Encode(char*& /* pos */, const char* /* end */) { return true; }
+
+  template <typename... Values>
+  static int Format(const char* /* pos */, char* msg, std::size_t size,
+                    const char* fmt, const Values&... values) {
+    return std::snprintf(msg, size, fmt, values...);
+  }
+};
+
+/** @brief Length stored for null string. */
+const std::size_t kNullStringLength = std::numeric_limits<std::size_t>::max();
+
+/** @brief Strings are copied with their content. */
+struct _StringCodec {
+  static bool Encode(char*& pos, const char* end, const char* value) {
+    std::size_t len = value ? std::strlen(value) : kNullStringLength;
+    std::size_t bytes = value ? len + 1 : 0;
+    if (static_cast<std::size_t>(end - pos) < sizeof(len) + bytes) {
+      return false;
+    }
+    std::memcpy(pos, &len, sizeof(len));
+    if (value) std::memcpy(pos + sizeof(len), value, bytes);
+    pos += sizeof(len) + bytes;
+    return true;
+  }
+
+  static const char* Decode(const char*& pos) {
+    std::size_t len = 0;
+    std::memcpy(&len, pos, sizeof(len));
+    pos += sizeof(len);
+    if (len == kNullStringLength) return nullptr;
+    const char* value = pos;
+    pos += len + 1;
+    return value;
+  }
+};
+
+template <typename T, typename... Rest> struct _ArgCodec<T, Rest...> {
+  static bool Encode(char*& pos, const char* end,
+                     const T& value, const Rest&... rest) {
+    if (static_cast<std::size_t>(end - pos) < sizeof(T)) return false;
+    std::memcpy(pos, &value, sizeof(T));
+    pos += sizeof(T);
+    return _ArgCodec<Rest...>::Encode(pos, end, rest...);
+  }
+
+  template <typename... Values>
+  static int Format(const char* pos, char* msg, std::size_t size,
+                    const char* fmt, const Values&... values) {
+    T value;
+    std::memcpy(&value, pos, sizeof(T));
+    return _ArgCodec<Rest...>::Format(pos + sizeof(T), msg, size, fmt,
+                                      values..., value);
+  }
+};
+
+template <typename... Rest> struct _StringArgCodec {
+  static bool Encode(char*& pos, const char* end,
+                     const char* value, const Rest&... rest) {
+    return _StringCodec::Encode(pos, end, value) &&
+           _ArgCodec<Rest...>::Encode(pos, end, rest...);
+  }
+
+  template <typename... Values>
+  static int Format(const char* pos, char* msg, std::size_t size,
+                    const char* fmt, const Values&... values) {
+    const char* value = _StringCodec::Decode(pos);
+    return _ArgCodec<Rest...>::Format(pos, msg, size, fmt, values..., value);
+  }
+};
+
+template <typename... Rest> struct _ArgCodec<const char*, Rest...>
+    : _StringArgCodec<Rest...> {};
+
+template <typename... Rest> struct _ArgCodec<char*, Rest...>
+    : _StringArgCodec<Rest...> {};
+
+template <typename... Args>
+int _FormatBacktraceRecord(const char* args, char* msg, std::size_t size) {
+  const char* fmt = _StringCodec::Decode(args);
+  return _ArgCodec<Args...>::Format(args, msg, size, fmt);
+}
+
+/**
+ * @brief Captures record into backtrace ring of current thread.
+ *
+ * Only arguments are copied here, message is formatted when ring is flushed.
+ */
+template <typename... Args>
+void _CaptureBacktrace(const LogSite* site, const char* fmt,
+                       const Args&... args) {
+  BacktraceRecord* record = _NextBacktraceRecord();
+  if (record == nullptr) return;
+  record->site = site;
+  record->msg_id = _NextMsgId();
+  record->time = std::chrono::high_resolution_clock::now();
+  record->is_encoded = false;
+
+  typedef _ArgCodec<typename std::decay<Args>::type...> Codec;
+  char* pos = record->args;
+  const char* end = record->args + sizeof(record->args);
+  if (_StringCodec::Encode(pos, end, fmt) &&
+      Codec::Encode(pos, end, args...)) {
+    record->format =
+        &_FormatBacktraceRecord<typename std::decay<Args>::type...>;
+  } else {
+    // too long arguments: format message right now
+    record->format = nullptr;
+    std::snprintf(record->args, sizeof(record->args), fmt, args...);
+  }
+}
+
+}  // namespace yeti
+
+/// @endcond
+
+#endif  // INC_YETI_BACKTRACE_H_
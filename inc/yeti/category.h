@@ -0,0 +1,80 @@
+/**
+ * @file category.h
+ * @brief Named categories of records with their own logging levels.
+ */
+
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+#ifndef INC_YETI_CATEGORY_H_
+#define INC_YETI_CATEGORY_H_
+
+#include <atomic>
+
+namespace yeti {
+
+/**
+ * @brief Named category of records (e.g. "net", "db.pool") with its own
+ * logging level.
+ *
+ * Category is defined once with static storage duration and is passed to
+ * <LEVEL>_CAT(), <LEVEL>_FMT_CAT() and YETI_LOG_CAT() macros:
+ *   yeti::LogCategory g_net_log("net");       // net.cc
+ *   extern yeti::LogCategory g_net_log;       // net.h
+ * Its level is set by the most specific of yeti::SetLogCategoryLevel()
+ * patterns matching its name or names of its parents ("net" for "net.tcp"),
+ * and follows the global logging level if there is no one. Actions of call
+ * sites are cached as usual, so category costs nothing at call site.
+ */
+class LogCategory {
+ public:
+  /** @brief Registers category, name must outlive it (string literal). */
+  explicit LogCategory(const char* name);
+
+  LogCategory(const LogCategory&) = delete;
+  LogCategory& operator=(const LogCategory&) = delete;
+
+  /** @brief Returns name of category. */
+  const char* GetName() const noexcept { return name_; }
+  /** @brief Returns current logging level of category. */
+  int GetLevel() const noexcept {
+    return level_.load(std::memory_order_relaxed);
+  }
+
+  /** @brief Sets resolved logging level of category (by registry only). */
+  void _SetLevel(int level) noexcept {
+    level_.store(level, std::memory_order_relaxed);
+  }
+
+ private:
+  const char* name_;
+  std::atomic<int> level_;
+};
+
+}  // namespace yeti
+
+#endif  // INC_YETI_CATEGORY_H_
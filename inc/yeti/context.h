@@ -0,0 +1,74 @@
+/**
+ * @file context.h
+ * @brief Per-thread context of key/value pairs attached to log records.
+ */
+
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+#ifndef INC_YETI_CONTEXT_H_
+#define INC_YETI_CONTEXT_H_
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace yeti {
+
+/** @brief Max number of pairs in per-thread context (extra ones are lost). */
+const std::size_t kLogContextCapacity = 16;
+
+/**
+ * @brief Pushes key/value pair onto context of current thread and pops it
+ * at the end of scope.
+ *
+ * Every record written by thread refers to its context: pairs are available
+ * as %(CTX:key) in format string and as members of JSON records. The inner
+ * pair wins if key is pushed twice. Record shares immutable snapshot of
+ * context with other records of thread, and the snapshot is copied only if
+ * context has been changed since the previous record.
+ */
+class LogContext {
+ public:
+  LogContext(const char* key, const char* value, std::size_t size);
+  LogContext(const char* key, const char* value)
+      : LogContext(key, value, std::strlen(value)) {}
+  LogContext(const char* key, const std::string& value)
+      : LogContext(key, value.data(), value.size()) {}
+  ~LogContext();
+
+  LogContext(const LogContext&) = delete;
+  LogContext& operator=(const LogContext&) = delete;
+};
+
+}  // namespace yeti
+
+/** @brief Attaches key/value pair to records of thread till end of scope. */
+#define YETI_CONTEXT(key, value) \
+  yeti::LogContext _YETI_CONCAT(__yeti_context_, __LINE__)(key, value)
+
+#endif  // INC_YETI_CONTEXT_H_
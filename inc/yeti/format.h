@@ -0,0 +1,605 @@
+/**
+ * @file format.h
+ * @brief Type-safe {}-style formatting and key/value fields of records.
+ */
+
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+
+#ifndef INC_YETI_FORMAT_H_
+#define INC_YETI_FORMAT_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <type_traits>
+#if __cplusplus >= 201703L
+#  include <string_view>
+#endif  // __cplusplus >= 201703L
+#include <yeti/yeti.h>
+
+namespace yeti {
+
+/// @cond
+template <typename T> struct _FmtAlwaysFalse : std::false_type {};
+/// @endcond
+
+/**
+ * @brief Formats values of user types for {}-style macros.
+ *
+ * Specialize it to log values of your own type T:
+ * ~~~~~~
+ * template <> struct yeti::Formatter<Point> {
+ *   static void Format(const Point& p, std::string* out) { ... }
+ * };
+ * ~~~~~~
+ * Value of user type is formatted by thread which logs it, values of
+ * built-in types and strings are copied into record and formatted by backend.
+ */
+template <typename T, typename Enable = void>
+struct Formatter {
+  static_assert(_FmtAlwaysFalse<T>::value,
+                "specialize yeti::Formatter<T> to log values of this type");
+  static void Format(const T& /* value */, std::string* /* out */) {}
+};
+
+/**
+ * @brief Key/value field of structured record, made by yeti::KV().
+ *
+ * Fields are passed to {}-style macros after (or among) the arguments of
+ * format and don't consume placeholders:
+ * ~~~~~~
+ * INF_FMT("request done", yeti::KV("user", name), yeti::KV("ms", elapsed));
+ * ~~~~~~
+ * In text output fields are appended to message as ` key=value`, in JSON
+ * output they become members of record object.
+ */
+template <typename T> struct LogField {
+  const char* key;
+  const T& value;
+};
+
+/** @brief Makes key/value field (key must be alive until macro returns). */
+template <typename T>
+LogField<T> KV(const char* key, const T& value) {
+  return LogField<T>{key, value};
+}
+
+/// @cond
+
+// ------------ compile-time parsing of format ------------
+
+/** @brief Number of placeholders returned for malformed format. */
+const std::size_t kFmtMalformed = static_cast<std::size_t>(-1);
+
+constexpr std::size_t _FmtScan(const char* fmt, std::size_t pos,
+                               std::size_t width);
+
+constexpr std::size_t _FmtScanRight(const char* fmt, std::size_t found,
+                                    std::size_t mid, std::size_t end) {
+  return found < mid ? found : _FmtScan(fmt, mid, end - mid);
+}
+
+/**
+ * @brief Returns position of the first brace (or of terminating zero) in
+ * [pos, pos + width), or pos + width if there is none.
+ *
+ * Range is split in halves, so recursion depth is logarithmic. Left half is
+ * scanned first, so characters after terminating zero are never read.
+ */
+constexpr std::size_t _FmtScan(const char* fmt, std::size_t pos,
+                               std::size_t width) {
+  return width == 1
+      ? (fmt[pos] == '\0' || fmt[pos] == '{' || fmt[pos] == '}'
+         ? pos : pos + 1)
+      : _FmtScanRight(fmt, _FmtScan(fmt, pos, width / 2), pos + width / 2,
+                      pos + width);
+}
+
+constexpr std::size_t _FmtNextBraceFrom(const char* fmt, std::size_t pos,
+                                        std::size_t width);
+
+constexpr std::size_t _FmtNextWindow(const char* fmt, std::size_t found,
+                                     std::size_t end, std::size_t width) {
+  return found < end ? found : _FmtNextBraceFrom(fmt, end, 2 * width);
+}
+
+/** @brief Scans windows of doubling width starting at pos. */
+constexpr std::size_t _FmtNextBraceFrom(const char* fmt, std::size_t pos,
+                                        std::size_t width) {
+  return _FmtNextWindow(fmt, _FmtScan(fmt, pos, width), pos + width, width);
+}
+
+/** @brief Returns position of the next brace (or of terminating zero). */
+constexpr std::size_t _FmtNextBrace(const char* fmt, std::size_t pos) {
+  return _FmtNextBraceFrom(fmt, pos, 1);
+}
+
+/** @brief Returns is brace at pos starts {} placeholder. */
+constexpr bool _FmtIsArg(const char* fmt, std::size_t pos) {
+  return fmt[pos] == '{' && fmt[pos + 1] == '}';
+}
+
+/** @brief Returns is brace at pos starts {}, {{ or }}. */
+constexpr bool _FmtIsValidBrace(const char* fmt, std::size_t pos) {
+  return fmt[pos] == '{' ? fmt[pos + 1] == '}' || fmt[pos + 1] == '{'
+                         : fmt[pos + 1] == '}';
+}
+
+constexpr std::size_t _FmtAdd(std::size_t n, std::size_t count) {
+  return count == kFmtMalformed ? kFmtMalformed : n + count;
+}
+
+/** @brief Counts placeholders (or all braces) starting from brace at pos. */
+constexpr std::size_t _FmtCountBraces(const char* fmt, std::size_t pos,
+                                      bool is_args_only) {
+  return fmt[pos] == '\0' ? 0
+      : !_FmtIsValidBrace(fmt, pos) ? kFmtMalformed
+      : _FmtAdd(_FmtIsArg(fmt, pos) || !is_args_only ? 1 : 0,
+                _FmtCountBraces(fmt, _FmtNextBrace(fmt, pos + 2),
+                                is_args_only));
+}
+
+/** @brief Returns number of {} placeholders (or kFmtMalformed). */
+constexpr std::size_t _FmtCountArgs(const char* fmt) {
+  return _FmtCountBraces(fmt, _FmtNextBrace(fmt, 0), true);
+}
+
+/** @brief Returns number of literal pieces of format. */
+constexpr std::size_t _FmtCountPieces(const char* fmt) {
+  return _FmtCountBraces(fmt, _FmtNextBrace(fmt, 0), false) == kFmtMalformed
+      ? 1 : _FmtCountBraces(fmt, _FmtNextBrace(fmt, 0), false) + 1;
+}
+
+/** @brief Piece ends with brace: escaped brace is kept, placeholder isn't. */
+constexpr _FormatPiece _FmtMakePiece(const char* fmt, std::size_t begin,
+                                     std::size_t end) {
+  return _FormatPiece{
+      begin, end - begin + (fmt[end] != '\0' && !_FmtIsArg(fmt, end) ? 1 : 0),
+      _FmtIsArg(fmt, end)};
+}
+
+template <std::size_t N> struct _FormatPieces {
+  _FormatPiece pieces[N];
+};
+
+template <std::size_t N, typename... Pieces>
+constexpr _FormatPieces<N> _FmtParseStep(const char* fmt, std::size_t begin,
+                                         std::size_t end, Pieces... pieces);
+
+template <std::size_t N, typename... Pieces>
+constexpr typename std::enable_if<sizeof...(Pieces) == N,
+                                  _FormatPieces<N>>::type
+_FmtParseFrom(const char*, std::size_t, Pieces... pieces) {
+  return _FormatPieces<N>{{ pieces... }};
+}
+
+/** @brief Parses pieces one by one, each one starts where previous ends. */
+template <std::size_t N, typename... Pieces>
+constexpr typename std::enable_if<sizeof...(Pieces) != N,
+                                  _FormatPieces<N>>::type
+_FmtParseFrom(const char* fmt, std::size_t begin, Pieces... pieces) {
+  return _FmtParseStep<N>(fmt, begin, _FmtNextBrace(fmt, begin), pieces...);
+}
+
+template <std::size_t N, typename... Pieces>
+constexpr _FormatPieces<N> _FmtParseStep(const char* fmt, std::size_t begin,
+                                         std::size_t end, Pieces... pieces) {
+  return _FmtParseFrom<N>(fmt, end + 2, pieces...,
+                          _FmtMakePiece(fmt, begin, end));
+}
+
+/** @brief Splits format into N literal pieces at compile time. */
+template <std::size_t N>
+constexpr _FormatPieces<N> _ParseFormat(const char* fmt) {
+  return _FmtParseFrom<N>(fmt, 0);
+}
+
+// ------------ arguments ------------
+
+/** @brief String argument which is not owned by record. */
+struct _FmtStr {
+  const char* data;
+  std::size_t size;
+};
+
+/**
+ * @brief Converts argument to one of stored types: std::int64_t,
+ * std::uint64_t, double, bool, char, const void*, _FmtStr or std::string
+ * (value of user type formatted by yeti::Formatter).
+ */
+template <typename T, typename Enable = void> struct _FmtArg {
+  typedef std::string type;
+  static type Prepare(const T& value) {
+    std::string out;
+    Formatter<T>::Format(value, &out);
+    return out;
+  }
+};
+
+template <> struct _FmtArg<bool> {
+  typedef bool type;
+  static type Prepare(bool value) { return value; }
+};
+
+template <> struct _FmtArg<char> {
+  typedef char type;
+  static type Prepare(char value) { return value; }
+};
+
+template <typename T> struct _FmtArg<T, typename std::enable_if<
+    (std::is_integral<T>::value && std::is_signed<T>::value &&
+     !std::is_same<T, char>::value) || std::is_enum<T>::value>::type> {
+  typedef std::int64_t type;
+  static type Prepare(T value) { return static_cast<type>(value); }
+};
+
+template <typename T> struct _FmtArg<T, typename std::enable_if<
+    std::is_integral<T>::value && std::is_unsigned<T>::value &&
+    !std::is_same<T, bool>::value && !std::is_same<T, char>::value>::type> {
+  typedef std::uint64_t type;
+  static type Prepare(T value) { return value; }
+};
+
+template <typename T> struct _FmtArg<T, typename std::enable_if<
+    std::is_floating_point<T>::value>::type> {
+  typedef double type;
+  static type Prepare(T value) { return static_cast<type>(value); }
+};
+
+template <typename T> struct _FmtArg<T*> {
+  typedef const void* type;
+  static type Prepare(const T* value) { return value; }
+};
+
+template <> struct _FmtArg<std::nullptr_t> {
+  typedef const void* type;
+  static type Prepare(std::nullptr_t) { return nullptr; }
+};
+
+template <> struct _FmtArg<const char*> {
+  typedef _FmtStr type;
+  static type Prepare(const char* value) {
+    return value ? _FmtStr{value, std::strlen(value)} : _FmtStr{"(null)", 6};
+  }
+};
+
+template <> struct _FmtArg<char*> : _FmtArg<const char*> {};
+
+template <> struct _FmtArg<std::string> {
+  typedef _FmtStr type;
+  static type Prepare(const std::string& value) {
+    return _FmtStr{value.data(), value.size()};
+  }
+};
+
+#if __cplusplus >= 201703L
+template <> struct _FmtArg<std::string_view> {
+  typedef _FmtStr type;
+  static type Prepare(std::string_view value) {
+    return _FmtStr{value.data(), value.size()};
+  }
+};
+#endif  // __cplusplus >= 201703L
+
+/** @brief Stored field: key and stored value. */
+template <typename P> struct _FmtField {
+  _FmtStr key;
+  P value;
+};
+
+template <typename T> struct _FmtArg<LogField<T>> {
+  typedef _FmtArg<typename std::decay<T>::type> ValueArg;
+  typedef _FmtField<typename ValueArg::type> type;
+  static type Prepare(const LogField<T>& field) {
+    return type{_FmtArg<const char*>::Prepare(field.key),
+                ValueArg::Prepare(field.value)};
+  }
+};
+
+template <typename T> struct _FmtIsField : std::false_type {};
+template <typename T> struct _FmtIsField<LogField<T>> : std::true_type {};
+
+template <typename... Ts> struct _FmtFieldCount {
+  static const std::size_t value = 0;
+};
+
+template <typename T, typename... Rest> struct _FmtFieldCount<T, Rest...> {
+  static const std::size_t value =
+      (_FmtIsField<T>::value ? 1 : 0) + _FmtFieldCount<Rest...>::value;
+};
+
+// appenders of stored values (used by backend)
+void _FmtAppend(std::int64_t value, std::string* out);
+void _FmtAppend(std::uint64_t value, std::string* out);
+void _FmtAppend(double value, std::string* out);
+void _FmtAppend(bool value, std::string* out);
+void _FmtAppend(char value, std::string* out);
+void _FmtAppend(const void* value, std::string* out);
+
+// appenders of stored values as JSON values
+void _FmtAppendJson(std::int64_t value, std::string* out);
+void _FmtAppendJson(std::uint64_t value, std::string* out);
+void _FmtAppendJson(double value, std::string* out);
+void _FmtAppendJson(bool value, std::string* out);
+void _FmtAppendJson(char value, std::string* out);
+void _FmtAppendJson(const void* value, std::string* out);
+void _FmtAppendJson(const char* data, std::size_t size, std::string* out);
+
+/** @brief Copies stored value into record and renders it from there. */
+template <typename P> struct _FmtValue {
+  static std::size_t Size(const P& /* value */) { return sizeof(P); }
+
+  static char* Encode(char* pos, const P& value) {
+    std::memcpy(pos, &value, sizeof(P));
+    return pos + sizeof(P);
+  }
+
+  static const char* Decode(const char* pos, std::string* out) {
+    P value;
+    std::memcpy(&value, pos, sizeof(P));
+    _FmtAppend(value, out);
+    return pos + sizeof(P);
+  }
+
+  static const char* DecodeJson(const char* pos, std::string* out) {
+    P value;
+    std::memcpy(&value, pos, sizeof(P));
+    _FmtAppendJson(value, out);
+    return pos + sizeof(P);
+  }
+
+  static const char* Skip(const char* pos) { return pos + sizeof(P); }
+};
+
+/** @brief Strings are copied with their content. */
+template <> struct _FmtValue<_FmtStr> {
+  static std::size_t Size(const _FmtStr& value) {
+    return sizeof(value.size) + value.size;
+  }
+
+  static char* Encode(char* pos, const _FmtStr& value) {
+    std::memcpy(pos, &value.size, sizeof(value.size));
+    std::memcpy(pos + sizeof(value.size), value.data, value.size);
+    return pos + sizeof(value.size) + value.size;
+  }
+
+  static const char* Decode(const char* pos, std::string* out) {
+    std::size_t size = 0;
+    std::memcpy(&size, pos, sizeof(size));
+    out->append(pos + sizeof(size), size);
+    return pos + sizeof(size) + size;
+  }
+
+  static const char* DecodeJson(const char* pos, std::string* out) {
+    std::size_t size = 0;
+    std::memcpy(&size, pos, sizeof(size));
+    _FmtAppendJson(pos + sizeof(size), size, out);
+    return pos + sizeof(size) + size;
+  }
+
+  static const char* Skip(const char* pos) {
+    std::size_t size = 0;
+    std::memcpy(&size, pos, sizeof(size));
+    return pos + sizeof(size) + size;
+  }
+};
+
+template <> struct _FmtValue<std::string> : _FmtValue<_FmtStr> {
+  static std::size_t Size(const std::string& value) {
+    return _FmtValue<_FmtStr>::Size(_FmtStr{value.data(), value.size()});
+  }
+
+  static char* Encode(char* pos, const std::string& value) {
+    return _FmtValue<_FmtStr>::Encode(pos,
+                                      _FmtStr{value.data(), value.size()});
+  }
+};
+
+/** @brief Field is rendered as ` key=value` or as `,"key":value`. */
+template <typename P> struct _FmtValue<_FmtField<P>> {
+  static std::size_t Size(const _FmtField<P>& field) {
+    return _FmtValue<_FmtStr>::Size(field.key) +
+           _FmtValue<P>::Size(field.value);
+  }
+
+  static char* Encode(char* pos, const _FmtField<P>& field) {
+    return _FmtValue<P>::Encode(_FmtValue<_FmtStr>::Encode(pos, field.key),
+                                field.value);
+  }
+
+  static const char* Decode(const char* pos, std::string* out) {
+    out->push_back(' ');
+    pos = _FmtValue<_FmtStr>::Decode(pos, out);
+    out->push_back('=');
+    return _FmtValue<P>::Decode(pos, out);
+  }
+
+  static const char* DecodeJson(const char* pos, std::string* out) {
+    out->push_back(',');
+    pos = _FmtValue<_FmtStr>::DecodeJson(pos, out);
+    out->push_back(':');
+    return _FmtValue<P>::DecodeJson(pos, out);
+  }
+
+  static const char* Skip(const char* pos) {
+    return _FmtValue<P>::Skip(_FmtValue<_FmtStr>::Skip(pos));
+  }
+};
+
+inline std::size_t _FmtSize() { return 0; }
+
+template <typename P, typename... Rest>
+std::size_t _FmtSize(const P& value, const Rest&... rest) {
+  return _FmtValue<P>::Size(value) + _FmtSize(rest...);
+}
+
+inline void _FmtEncode(char* /* pos */) {}
+
+template <typename P, typename... Rest>
+void _FmtEncode(char* pos, const P& value, const Rest&... rest) {
+  _FmtEncode(_FmtValue<P>::Encode(pos, value), rest...);
+}
+
+/** @brief Walks pieces of format and renders stored arguments. */
+template <typename... Ps> struct _FmtRender;
+
+template <> struct _FmtRender<> {
+  static void Render(const char* fmt, const _FormatPiece* piece,
+                     const _FormatPiece* end, const char* /* args */,
+                     std::string* out) {
+    for (; piece != end; ++piece) {
+      out->append(fmt + piece->offset, piece->length);
+    }
+  }
+};
+
+template <typename P, typename... Rest> struct _FmtRender<P, Rest...> {
+  static void Render(const char* fmt, const _FormatPiece* piece,
+                     const _FormatPiece* end, const char* args,
+                     std::string* out) {
+    // number of placeholders is checked at compile time
+    for (; !piece->has_arg; ++piece) {
+      out->append(fmt + piece->offset, piece->length);
+    }
+    out->append(fmt + piece->offset, piece->length);
+    args = _FmtValue<P>::Decode(args, out);
+    _FmtRender<Rest...>::Render(fmt, piece + 1, end, args, out);
+  }
+};
+
+template <typename P, typename... Rest>
+struct _FmtRender<_FmtField<P>, Rest...> {
+  static void Render(const char* fmt, const _FormatPiece* piece,
+                     const _FormatPiece* end, const char* args,
+                     std::string* out) {
+    _FmtRender<Rest...>::Render(fmt, piece, end,
+                                _FmtValue<_FmtField<P>>::Skip(args), out);
+  }
+};
+
+/** @brief Renders stored fields skipping arguments of format. */
+template <typename... Ps> struct _FmtRenderFields {
+  static void Render(const char* /* args */, std::string* /* out */,
+                     bool /* is_json */) {}
+};
+
+template <typename P, typename... Rest> struct _FmtRenderFields<P, Rest...> {
+  static void Render(const char* args, std::string* out, bool is_json) {
+    _FmtRenderFields<Rest...>::Render(_FmtValue<P>::Skip(args), out,
+                                      is_json);
+  }
+};
+
+template <typename P, typename... Rest>
+struct _FmtRenderFields<_FmtField<P>, Rest...> {
+  static void Render(const char* args, std::string* out, bool is_json) {
+    args = is_json ? _FmtValue<_FmtField<P>>::DecodeJson(args, out)
+                   : _FmtValue<_FmtField<P>>::Decode(args, out);
+    _FmtRenderFields<Rest...>::Render(args, out, is_json);
+  }
+};
+
+/** @brief Size of stack buffer to encode arguments of short record. */
+const std::size_t kFmtStackSize = 256;
+
+template <typename... Ps>
+void _FmtLog(Logger* logger, const LogSite* site, const Ps&... values) {
+  const std::size_t size = _FmtSize(values...);
+  if (size <= kFmtStackSize) {
+    char args[kFmtStackSize];
+    _FmtEncode(args, values...);
+    _EnqueueEncodedLog(logger, site, args, size);
+  } else {
+    // long arguments are encoded right into reserved record
+    LogRecord* record = nullptr;
+    _FmtEncode(_ReserveEncodedLog(logger, site, size, &record), values...);
+    _CommitEncodedLog(logger, record);
+  }
+}
+
+template <typename... Ps>
+void _FmtCapture(const LogSite* site, const Ps&... values) {
+  BacktraceRecord* record = _NextBacktraceRecord();
+  if (record == nullptr) return;
+  record->site = site;
+  record->msg_id = _NextMsgId();
+  record->time = std::chrono::high_resolution_clock::now();
+  record->format = nullptr;
+
+  const std::size_t size = _FmtSize(values...);
+  if (size <= sizeof(record->args)) {
+    _FmtEncode(record->args, values...);
+    record->is_encoded = true;
+    record->args_size = size;
+  } else {
+    // too long arguments: render message right now
+    std::string args(size, '\0');
+    _FmtEncode(&args[0], values...);
+    std::string msg;
+    site->render(site, args.data(), &msg, &msg, false);
+    std::snprintf(record->args, sizeof(record->args), "%s", msg.c_str());
+    record->is_encoded = false;
+  }
+}
+
+/** @brief Arguments of {}-style call site. */
+template <typename... Ts> struct _FmtArgs {
+  static const std::size_t kFieldCount = _FmtFieldCount<Ts...>::value;
+  static const std::size_t kSize = sizeof...(Ts) - kFieldCount;
+
+  static void Render(const LogSite* site, const char* args, std::string* msg,
+                     std::string* fields, bool is_json) {
+    _FmtRender<typename _FmtArg<Ts>::type...>::Render(
+        site->format, site->pieces, site->pieces + site->piece_count, args,
+        msg);
+    if (kFieldCount != 0) {
+      _FmtRenderFields<typename _FmtArg<Ts>::type...>::Render(args, fields,
+                                                              is_json);
+    }
+  }
+
+  static void Log(const LogSite* site, const Ts&... values) {
+    _FmtLog(nullptr, site, _FmtArg<Ts>::Prepare(values)...);
+  }
+
+  static void LogTo(Logger* logger, const LogSite* site,
+                    const Ts&... values) {
+    _FmtLog(logger, site, _FmtArg<Ts>::Prepare(values)...);
+  }
+
+  static void Capture(const LogSite* site, const Ts&... values) {
+    _FmtCapture(site, _FmtArg<Ts>::Prepare(values)...);
+  }
+};
+
+/** @brief Returns type of arguments of call site (unevaluated only). */
+template <typename... Args>
+_FmtArgs<typename std::decay<Args>::type...> _FmtArgTypes(Args&&... args);
+
+/// @endcond
+
+}  // namespace yeti
+
+#endif  // INC_YETI_FORMAT_H_
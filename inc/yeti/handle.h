@@ -0,0 +1,138 @@
+/**
+ * @file handle.h
+ * @brief Independent logger instances with their own queues and settings.
+ */
+
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+#ifndef INC_YETI_HANDLE_H_
+#define INC_YETI_HANDLE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <yeti/yeti.h>
+
+namespace yeti {
+
+class Logger;
+class LogHandle;
+
+/** @brief Settings of logger created by yeti::LogHandle. */
+struct LogHandleOptions {
+  LogHandleOptions()
+      : level(LOG_LEVEL_INFO), fd(stderr), output(LOG_OUTPUT_TEXT),
+        engine(LOG_ENGINE_THREAD), worker(nullptr) {}
+
+  LogLevel level;
+  FILE* fd;
+  std::string format_str;  // empty for default format
+  LogOutput output;
+  LogEngine engine;
+  // logger whose thread drains queue of this one (nullptr for own thread)
+  LogHandle* worker;
+};
+
+/**
+ * @brief Logger instance with its own queue, level, format and file which
+ * macros with _TO suffix write into:
+ *   yeti::LogHandle g_audit_log(options);
+ *   INF_TO(g_audit_log, "user %s logged in", name);
+ *
+ * Backlog of one instance doesn't delay records of another one. Instance
+ * has its own backend thread or shares thread of worker instance. Records
+ * of instance are filtered by its level only: call site modes, categories,
+ * levels of threads and backtrace buffering apply to the default logger.
+ */
+class LogHandle {
+ public:
+  /** @brief Creates logger instance. */
+  explicit LogHandle(const LogHandleOptions& options = LogHandleOptions());
+  /**
+   * @brief Writes pending records and stops instance.
+   *
+   * Instances sharing its thread drain their queues by themselves then, but
+   * it is better to destroy them first.
+   */
+  ~LogHandle();
+
+  LogHandle(const LogHandle&) = delete;
+  LogHandle& operator=(const LogHandle&) = delete;
+
+  /** @brief Returns handle of the default logger used by other macros. */
+  static LogHandle& Default();
+
+  /** @brief Sets logging level of instance. */
+  void SetLevel(LogLevel level) noexcept;
+  /** @brief Returns logging level of instance. */
+  int GetLevel() const noexcept;
+  /** @brief Sets format of records of instance. */
+  void SetFormatStr(const std::string& format_str) noexcept;
+  /** @brief Returns format of records of instance. */
+  std::string GetFormatStr() const noexcept;
+  /** @brief Sets file descriptor of instance. */
+  void SetFileDesc(FILE* fd) noexcept;
+  /** @brief Returns file descriptor of instance. */
+  FILE* GetFileDesc() const noexcept;
+  /** @brief Sets output format of records of instance. */
+  void SetOutput(LogOutput output) noexcept;
+  /** @brief Returns output format of records of instance. */
+  LogOutput GetOutput() const noexcept;
+  /** @brief Sets colorization of records of instance. */
+  void SetColored(bool is_colored) noexcept;
+  /** @brief Sets limits of queue pressure of instance. */
+  void SetPressureLimits(const LogPressureLimits& limits) noexcept;
+  /** @brief Sets policy of watchdog of sinks of instance. */
+  void SetStallPolicy(const LogStallPolicy& policy) noexcept;
+  /** @brief Sets period to log counters of instance into it. */
+  void SetStatsInterval(std::chrono::milliseconds interval) noexcept;
+  /** @brief Writes all queued records of instance (blocking call). */
+  void Flush();
+  /** @brief Returns counters of instance. */
+  LogStats GetStats() const;
+
+  /** @brief Returns true if records of level pass level of instance. */
+  bool IsEnabled(LogLevel level) const noexcept {
+    return level <= effective_level_->load(std::memory_order_relaxed);
+  }
+
+  /** @brief Returns logger object of handle (for macros only). */
+  Logger* _GetLogger() const noexcept { return logger_; }
+
+ private:
+  explicit LogHandle(Logger* logger);
+
+  Logger* logger_;
+  const std::atomic<int>* effective_level_;
+  bool is_owned_;
+};
+
+}  // namespace yeti
+
+#endif  // INC_YETI_HANDLE_H_
@@ -0,0 +1,122 @@
+/**
+ * @file limiter.h
+ * @brief Per call site state of rate-limited and sampled logging macros.
+ */
+
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+
+#ifndef INC_YETI_LIMITER_H_
+#define INC_YETI_LIMITER_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+namespace yeti {
+
+/// @cond
+
+/** @brief Returns uniformly distributed number in [0, 1) from per-thread RNG. */
+inline double _NextRandom() noexcept {
+  // xorshift64* seeded by thread ID
+  static thread_local std::uint64_t state = 0;
+  if (state == 0) {
+    state = std::hash<std::thread::id>()(std::this_thread::get_id()) |
+            0x9E3779B97F4A7C15ULL;
+  }
+  state ^= state >> 12;
+  state ^= state << 25;
+  state ^= state >> 27;
+  return ((state * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / (1ULL << 53));
+}
+
+/// @endcond
+
+/**
+ * @brief Static state of rate-limited or sampled macro call site.
+ *
+ * It is lock-free and it has trivial default constructor, so static object is
+ * zero-initialized without any guard. Every check is done before formatting
+ * of message. Number of occurrences suppressed since the last written one is
+ * reported in the next written message.
+ */
+struct LogLimiter {
+  std::atomic<std::uint64_t> count;
+  std::atomic<std::int64_t> next_time;
+  std::atomic<std::uint64_t> suppressed;
+
+  /** @brief Permits every n-th occurrence starting from the first one. */
+  bool EveryN(std::uint64_t n) noexcept {
+    if (n <= 1 || count.fetch_add(1, std::memory_order_relaxed) % n == 0) {
+      return true;
+    }
+    suppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  /** @brief Permits at most one occurrence per specified number of ms. */
+  bool EveryMs(std::int64_t ms) noexcept {
+    using namespace std::chrono;
+    std::int64_t now = duration_cast<milliseconds>(
+        steady_clock::now().time_since_epoch()).count();
+    std::int64_t next = next_time.load(std::memory_order_relaxed);
+    if (now >= next && next_time.compare_exchange_strong(
+            next, now + ms, std::memory_order_relaxed)) {
+      return true;
+    }
+    suppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  /** @brief Permits the first n occurrences only. */
+  bool FirstN(std::uint64_t n) noexcept {
+    // nothing is written after the first n, so suppressed aren't counted
+    return count.load(std::memory_order_relaxed) < n &&
+           count.fetch_add(1, std::memory_order_relaxed) < n;
+  }
+
+  /** @brief Permits occurrence with specified probability. */
+  bool Sample(double probability) noexcept {
+    if (_NextRandom() < probability) {
+      return true;
+    }
+    suppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  /** @brief Returns number of suppressed occurrences and resets it. */
+  std::uint64_t TakeSuppressed() noexcept {
+    if (suppressed.load(std::memory_order_relaxed) == 0) return 0;
+    return suppressed.exchange(0, std::memory_order_relaxed);
+  }
+};
+
+}  // namespace yeti
+
+#endif  // INC_YETI_LIMITER_H_
@@ -34,6 +34,8 @@
 #define INC_YETI_MACRO_H_
 
 #include <unistd.h>
+#include <atomic>
+#include <cstdint>
 #include <cstdio>
 #include <map>
 #include <memory>
@@ -41,6 +43,7 @@
 #include <string>
 #include <thread>
 #include <yeti/yeti.h>
+#include <yeti/category.h>
 
 #if defined(__clang__)
 #  pragma clang diagnostic ignored "-Wformat-security"
@@ -48,9 +51,6 @@
 #  pragma GCC diagnostic ignored "-Wformat-security"
 #endif  // ignored "-Wformat-security"
 
-
-#define MAX_MSG_LENGTH 512
-
 /// @cond
 
 #define YETI_BALCK   "\033[0;30m"
@@ -75,31 +75,97 @@
 #define YETI_HIGH    "\033[1m"
 #define YETI_RESET   "\033[0m"
 
+#define _YETI_CONCAT_IMPL(a, b) a##b
+#define _YETI_CONCAT(a, b) _YETI_CONCAT_IMPL(a, b)
+
 namespace yeti {
 
-struct LogData {
-  std::string log_format;
-  std::string level;
-  std::string color;
-  std::string filename;
-  std::string funcname;
-  pid_t pid;
-  std::thread::id tid;
+/** @brief Literal piece of {}-style format followed by placeholder or not. */
+struct _FormatPiece {
+  std::size_t offset;
+  std::size_t length;
+  bool has_arg;
+};
+
+/** @brief Static descriptor of logging macro call site. */
+struct LogSite {
+  LogLevel level;
+  const char* level_name;
+  const char* color;
+  const char* filename;
+  const char* funcname;
   int line;
-  FILE* fd;
-  std::size_t msg_id;
-  std::string msg;
-  std::chrono::high_resolution_clock::time_point time;
+  // {}-style call sites only: format parsed at compile time and renderer of
+  // arguments stored in record (key/value fields are rendered into fields)
+  const char* format;
+  const _FormatPiece* pieces;
+  std::size_t piece_count;
+  void (*render)(const LogSite* site, const char* args, std::string* msg,
+                 std::string* fields, bool is_json);
+  // category of records (nullptr if site follows the global logging level)
+  const LogCategory* category;
+  // cached action of site (_LogSiteAction), zero until site is registered;
+  // it's negated while sites are profiled (see yeti::SetLogSiteProfiling())
+  mutable std::atomic<int> action;
+  // index of site counters, zero until site is profiled
+  mutable std::atomic<std::uint32_t> profile_id;
+};
+
+/** @brief What macro does with record of call site. */
+enum _LogSiteAction {
+  _kSiteUnresolved = 0,
+  _kSiteCheck,  // depends on logging level of thread
+  _kSiteOff,
+  _kSiteCapture,
+  _kSiteLog
 };
 
+struct LogRecord;
+class Logger;
+
 // ------------ auxiliary functions ------------
-void _EnqueueLogTask(std::shared_ptr<yeti::LogData> log_data);
-std::size_t _GetMsgId();
-void _IncMsgId();
+// logger is nullptr for the default one
+void _LogPrintf(const LogSite* site, const char* fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+void _LogPrintfTo(Logger* logger, const LogSite* site, const char* fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+void _LogLimitedPrintf(const LogSite* site, std::uint64_t suppressed,
+                       const char* fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+void _EnqueueEncodedLog(Logger* logger, const LogSite* site, const char* args,
+                        std::size_t size);
+char* _ReserveEncodedLog(Logger* logger, const LogSite* site, std::size_t size,
+                         LogRecord** record);
+void _CommitEncodedLog(Logger* logger, LogRecord* record);
+std::size_t _NextMsgId();
+int _GetEffectiveLogLevel() noexcept;
+int _GetCaptureLogLevel() noexcept;
+int _ResolveLogSite(const LogSite* site, const char* format);
 // ---------------------------------------------
 
+/**
+ * @brief Returns action of call site, registering site on first use.
+ *
+ * Action is cached in site and updated by registry whenever logging level or
+ * mode of site changes, so filtered out record costs one relaxed load. Only
+ * sites between global level and levels of threads (see
+ * yeti::SetThreadLogLevel()) check level of current thread.
+ */
+inline int _GetLogSiteAction(const LogSite* site, const char* format) {
+  const int action = site->action.load(std::memory_order_relaxed);
+  return action > _kSiteCheck ? action : _ResolveLogSite(site, format);
+}
+
 }  // namespace yeti
 
+#include <yeti/backtrace.h>
+#include <yeti/context.h>
+#include <yeti/limiter.h>
+#include <yeti/format.h>
+#include <yeti/stream.h>
+#include <yeti/span.h>
+#include <yeti/handle.h>
+
 // @endcond
 
 
@@ -112,143 +178,506 @@ void _IncMsgId();
 #define DBG(fmt, ...) ((void) 0)
 #define TRC(fmt, ...) ((void) 0)
 
+#define CRT_EVERY_N(n, fmt, ...) ((void) 0)
+#define CRT_EVERY_MS(ms, fmt, ...) ((void) 0)
+#define CRT_FIRST_N(n, fmt, ...) ((void) 0)
+#define CRT_SAMPLED(p, fmt, ...) ((void) 0)
+#define ERR_EVERY_N(n, fmt, ...) ((void) 0)
+#define ERR_EVERY_MS(ms, fmt, ...) ((void) 0)
+#define ERR_FIRST_N(n, fmt, ...) ((void) 0)
+#define ERR_SAMPLED(p, fmt, ...) ((void) 0)
+#define WRN_EVERY_N(n, fmt, ...) ((void) 0)
+#define WRN_EVERY_MS(ms, fmt, ...) ((void) 0)
+#define WRN_FIRST_N(n, fmt, ...) ((void) 0)
+#define WRN_SAMPLED(p, fmt, ...) ((void) 0)
+#define INF_EVERY_N(n, fmt, ...) ((void) 0)
+#define INF_EVERY_MS(ms, fmt, ...) ((void) 0)
+#define INF_FIRST_N(n, fmt, ...) ((void) 0)
+#define INF_SAMPLED(p, fmt, ...) ((void) 0)
+#define DBG_EVERY_N(n, fmt, ...) ((void) 0)
+#define DBG_EVERY_MS(ms, fmt, ...) ((void) 0)
+#define DBG_FIRST_N(n, fmt, ...) ((void) 0)
+#define DBG_SAMPLED(p, fmt, ...) ((void) 0)
+#define TRC_EVERY_N(n, fmt, ...) ((void) 0)
+#define TRC_EVERY_MS(ms, fmt, ...) ((void) 0)
+#define TRC_FIRST_N(n, fmt, ...) ((void) 0)
+#define TRC_SAMPLED(p, fmt, ...) ((void) 0)
+
+#define CRT_FMT(fmt, ...) ((void) 0)
+#define ERR_FMT(fmt, ...) ((void) 0)
+#define WRN_FMT(fmt, ...) ((void) 0)
+#define INF_FMT(fmt, ...) ((void) 0)
+#define DBG_FMT(fmt, ...) ((void) 0)
+#define TRC_FMT(fmt, ...) ((void) 0)
+
+#define CRT_CAT(category, fmt, ...) ((void) 0)
+#define ERR_CAT(category, fmt, ...) ((void) 0)
+#define WRN_CAT(category, fmt, ...) ((void) 0)
+#define INF_CAT(category, fmt, ...) ((void) 0)
+#define DBG_CAT(category, fmt, ...) ((void) 0)
+#define TRC_CAT(category, fmt, ...) ((void) 0)
+
+#define CRT_FMT_CAT(category, fmt, ...) ((void) 0)
+#define ERR_FMT_CAT(category, fmt, ...) ((void) 0)
+#define WRN_FMT_CAT(category, fmt, ...) ((void) 0)
+#define INF_FMT_CAT(category, fmt, ...) ((void) 0)
+#define DBG_FMT_CAT(category, fmt, ...) ((void) 0)
+#define TRC_FMT_CAT(category, fmt, ...) ((void) 0)
+
+#define YETI_LOG(level) while (false) yeti::_NullLogStream()
+#define YETI_LOG_CAT(level, category) while (false) yeti::_NullLogStream()
+
+#define CRT_TO(handle, fmt, ...) ((void) 0)
+#define ERR_TO(handle, fmt, ...) ((void) 0)
+#define WRN_TO(handle, fmt, ...) ((void) 0)
+#define INF_TO(handle, fmt, ...) ((void) 0)
+#define DBG_TO(handle, fmt, ...) ((void) 0)
+#define TRC_TO(handle, fmt, ...) ((void) 0)
+
+#define CRT_FMT_TO(handle, fmt, ...) ((void) 0)
+#define ERR_FMT_TO(handle, fmt, ...) ((void) 0)
+#define WRN_FMT_TO(handle, fmt, ...) ((void) 0)
+#define INF_FMT_TO(handle, fmt, ...) ((void) 0)
+#define DBG_FMT_TO(handle, fmt, ...) ((void) 0)
+#define TRC_FMT_TO(handle, fmt, ...) ((void) 0)
+
+#define YETI_LOG_TO(level, handle) while (false) yeti::_NullLogStream()
+
+#define YETI_SCOPE(name) ((void) 0)
+#define YETI_SCOPE_AT(level, name) ((void) 0)
+
 #else  // YETI_DISABLE_LOGGING
 
+/// @cond
+
 /**
- * @brief Logs critical error message using specified printf-like format.
+ * Record is written if its level passes effective logging level of its
+ * category (or site is enabled by yeti::SetLogSiteMode()), or it is captured
+ * into backtrace ring of current thread if backtrace buffering is on (see
+ * yeti::SetLogBacktrace()).
  */
-#define CRT(fmt, ...) { \
-  auto __yeti_data__ = std::make_shared<yeti::LogData>(); \
-  __yeti_data__->level = "CRT"; \
-  __yeti_data__->color = YETI_LRED; \
-  __yeti_data__->filename = __FILE__; \
-  __yeti_data__->funcname = __func__; \
-  __yeti_data__->line = __LINE__; \
-  __yeti_data__->msg_id = yeti::_GetMsgId(); \
-  yeti::_IncMsgId(); \
-  \
-  char __yeti_msg__[MAX_MSG_LENGTH] = { 0 }; \
-  std::snprintf(__yeti_msg__, sizeof(__yeti_msg__), fmt, ##__VA_ARGS__); \
-  __yeti_data__->msg = __yeti_msg__; \
-  \
-  yeti::_EnqueueLogTask(__yeti_data__); \
+#define _YETI_LOG_CAT(category, log_level, level_name, color, fmt, ...) { \
+  static const yeti::LogSite __yeti_site__ = { \
+      log_level, level_name, color, __FILE__, __func__, __LINE__, \
+      nullptr, nullptr, 0, nullptr, category }; \
+  const int __yeti_action__ = yeti::_GetLogSiteAction(&__yeti_site__, fmt); \
+  if (__yeti_action__ == yeti::_kSiteLog) { \
+    yeti::_LogPrintf(&__yeti_site__, fmt, ##__VA_ARGS__); \
+  } else if (__yeti_action__ == yeti::_kSiteCapture) { \
+    yeti::_CaptureBacktrace(&__yeti_site__, fmt, ##__VA_ARGS__); \
+  } \
+}
+
+#define _YETI_LOG(log_level, level_name, color, fmt, ...) \
+  _YETI_LOG_CAT(nullptr, log_level, level_name, color, fmt, ##__VA_ARGS__)
+
+/** Record is written into logger of handle if it passes level of handle. */
+#define _YETI_LOG_TO(handle, log_level, level_name, color, fmt, ...) { \
+  static const yeti::LogSite __yeti_site__ = { \
+      log_level, level_name, color, __FILE__, __func__, __LINE__ }; \
+  const yeti::LogHandle& __yeti_handle__ = (handle); \
+  if (__yeti_handle__.IsEnabled(log_level)) { \
+    yeti::_LogPrintfTo(__yeti_handle__._GetLogger(), &__yeti_site__, \
+                       fmt, ##__VA_ARGS__); \
+  } \
 }
 
+/// @endcond
+
+/**
+ * @brief Logs critical error message using specified printf-like format.
+ */
+#define CRT(fmt, ...) \
+  _YETI_LOG(yeti::LOG_LEVEL_CRITICAL, "CRT", YETI_LRED, fmt, ##__VA_ARGS__)
+
 /**
  * @brief Logs error message using specified printf-like format.
  */
-#define ERR(fmt, ...) { \
-  std::size_t __yeti_msg_id__ = yeti::_GetMsgId(); \
-  yeti::_IncMsgId(); \
-  if (yeti::GetLogLevel() >= yeti::LOG_LEVEL_ERROR) { \
-    auto __yeti_data__ = std::make_shared<yeti::LogData>(); \
-    __yeti_data__->level = "ERR"; \
-    __yeti_data__->color = YETI_LPURPLE; \
-    __yeti_data__->filename = __FILE__; \
-    __yeti_data__->funcname = __func__; \
-    __yeti_data__->line = __LINE__; \
-    __yeti_data__->msg_id = __yeti_msg_id__; \
-    \
-    char __yeti_msg__[MAX_MSG_LENGTH] = { 0 }; \
-    std::snprintf(__yeti_msg__, sizeof(__yeti_msg__), fmt, ##__VA_ARGS__); \
-    __yeti_data__->msg = __yeti_msg__; \
-    \
-    yeti::_EnqueueLogTask(__yeti_data__); \
-  } \
-}
+#define ERR(fmt, ...) \
+  _YETI_LOG(yeti::LOG_LEVEL_ERROR, "ERR", YETI_LPURPLE, fmt, ##__VA_ARGS__)
 
 /**
  * @brief Logs warning message using specified printf-like format.
  */
-#define WRN(fmt, ...) { \
-  std::size_t __yeti_msg_id__ = yeti::_GetMsgId(); \
-  yeti::_IncMsgId(); \
-  if (yeti::GetLogLevel() >= yeti::LOG_LEVEL_WARNING) { \
-    auto __yeti_data__ = std::make_shared<yeti::LogData>(); \
-    __yeti_data__->level = "WRN"; \
-    __yeti_data__->color = YETI_YELLOW; \
-    __yeti_data__->filename = __FILE__; \
-    __yeti_data__->funcname = __func__; \
-    __yeti_data__->line = __LINE__; \
-    __yeti_data__->msg_id = __yeti_msg_id__; \
-    \
-    char __yeti_msg__[MAX_MSG_LENGTH] = { 0 }; \
-    std::snprintf(__yeti_msg__, sizeof(__yeti_msg__), fmt, ##__VA_ARGS__); \
-    __yeti_data__->msg = __yeti_msg__; \
-    \
-    yeti::_EnqueueLogTask(__yeti_data__); \
-  } \
-}
+#define WRN(fmt, ...) \
+  _YETI_LOG(yeti::LOG_LEVEL_WARNING, "WRN", YETI_YELLOW, fmt, ##__VA_ARGS__)
 
 /**
  * @brief Logs informational message using specified printf-like format.
  */
-#define INF(fmt, ...) { \
-  std::size_t __yeti_msg_id__ = yeti::_GetMsgId(); \
-  yeti::_IncMsgId(); \
-  if (yeti::GetLogLevel() >= yeti::LOG_LEVEL_INFO) { \
-    auto __yeti_data__ = std::make_shared<yeti::LogData>(); \
-    __yeti_data__->level = "INF"; \
-    __yeti_data__->color = YETI_LGREEN; \
-    __yeti_data__->filename = __FILE__; \
-    __yeti_data__->funcname = __func__; \
-    __yeti_data__->line = __LINE__; \
-    __yeti_data__->msg_id = __yeti_msg_id__; \
-    \
-    char __yeti_msg__[MAX_MSG_LENGTH] = { 0 }; \
-    std::snprintf(__yeti_msg__, sizeof(__yeti_msg__), fmt, ##__VA_ARGS__); \
-    __yeti_data__->msg = __yeti_msg__; \
-    \
-    yeti::_EnqueueLogTask(__yeti_data__); \
-  } \
-}
+#define INF(fmt, ...) \
+  _YETI_LOG(yeti::LOG_LEVEL_INFO, "INF", YETI_LGREEN, fmt, ##__VA_ARGS__)
 
 /**
  * @brief Logs debug message using specified printf-like format.
  */
-#define DBG(fmt, ...) { \
-  std::size_t __yeti_msg_id__ = yeti::_GetMsgId(); \
-  yeti::_IncMsgId(); \
-  if (yeti::GetLogLevel() >= yeti::LOG_LEVEL_DEBUG) { \
-    auto __yeti_data__ = std::make_shared<yeti::LogData>(); \
-    __yeti_data__->level = "DBG"; \
-    __yeti_data__->color = YETI_WHITE; \
-    __yeti_data__->filename = __FILE__; \
-    __yeti_data__->funcname = __func__; \
-    __yeti_data__->line = __LINE__; \
-    __yeti_data__->msg_id = __yeti_msg_id__; \
-    \
-    char __yeti_msg__[MAX_MSG_LENGTH] = { 0 }; \
-    std::snprintf(__yeti_msg__, sizeof(__yeti_msg__), fmt, ##__VA_ARGS__); \
-    __yeti_data__->msg = __yeti_msg__; \
-    \
-    yeti::_EnqueueLogTask(__yeti_data__); \
+#define DBG(fmt, ...) \
+  _YETI_LOG(yeti::LOG_LEVEL_DEBUG, "DBG", YETI_WHITE, fmt, ##__VA_ARGS__)
+
+/**
+ * @brief Logs trace message using specified printf-like format.
+ */
+#define TRC(fmt, ...) \
+  _YETI_LOG(yeti::LOG_LEVEL_TRACE, "TRC", "", fmt, ##__VA_ARGS__)
+
+/**
+ * Logging macros of category (see yeti::LogCategory), printf-like format:
+ *   <LEVEL>_CAT(g_net_log, "connected to %s", host);
+ * where <LEVEL> is one of CRT, ERR, WRN, INF, DBG, TRC.
+ */
+#define CRT_CAT(category, fmt, ...) \
+  _YETI_LOG_CAT(&(category), yeti::LOG_LEVEL_CRITICAL, "CRT", YETI_LRED, \
+                fmt, ##__VA_ARGS__)
+#define ERR_CAT(category, fmt, ...) \
+  _YETI_LOG_CAT(&(category), yeti::LOG_LEVEL_ERROR, "ERR", YETI_LPURPLE, \
+                fmt, ##__VA_ARGS__)
+#define WRN_CAT(category, fmt, ...) \
+  _YETI_LOG_CAT(&(category), yeti::LOG_LEVEL_WARNING, "WRN", YETI_YELLOW, \
+                fmt, ##__VA_ARGS__)
+#define INF_CAT(category, fmt, ...) \
+  _YETI_LOG_CAT(&(category), yeti::LOG_LEVEL_INFO, "INF", YETI_LGREEN, \
+                fmt, ##__VA_ARGS__)
+#define DBG_CAT(category, fmt, ...) \
+  _YETI_LOG_CAT(&(category), yeti::LOG_LEVEL_DEBUG, "DBG", YETI_WHITE, \
+                fmt, ##__VA_ARGS__)
+#define TRC_CAT(category, fmt, ...) \
+  _YETI_LOG_CAT(&(category), yeti::LOG_LEVEL_TRACE, "TRC", "", \
+                fmt, ##__VA_ARGS__)
+
+/**
+ * Logging macros writing into logger of handle (see yeti::LogHandle),
+ * printf-like format:
+ *   <LEVEL>_TO(g_audit_log, "user %s logged in", name);
+ * where <LEVEL> is one of CRT, ERR, WRN, INF, DBG, TRC.
+ */
+#define CRT_TO(handle, fmt, ...) \
+  _YETI_LOG_TO(handle, yeti::LOG_LEVEL_CRITICAL, "CRT", YETI_LRED, \
+               fmt, ##__VA_ARGS__)
+#define ERR_TO(handle, fmt, ...) \
+  _YETI_LOG_TO(handle, yeti::LOG_LEVEL_ERROR, "ERR", YETI_LPURPLE, \
+               fmt, ##__VA_ARGS__)
+#define WRN_TO(handle, fmt, ...) \
+  _YETI_LOG_TO(handle, yeti::LOG_LEVEL_WARNING, "WRN", YETI_YELLOW, \
+               fmt, ##__VA_ARGS__)
+#define INF_TO(handle, fmt, ...) \
+  _YETI_LOG_TO(handle, yeti::LOG_LEVEL_INFO, "INF", YETI_LGREEN, \
+               fmt, ##__VA_ARGS__)
+#define DBG_TO(handle, fmt, ...) \
+  _YETI_LOG_TO(handle, yeti::LOG_LEVEL_DEBUG, "DBG", YETI_WHITE, \
+               fmt, ##__VA_ARGS__)
+#define TRC_TO(handle, fmt, ...) \
+  _YETI_LOG_TO(handle, yeti::LOG_LEVEL_TRACE, "TRC", "", \
+               fmt, ##__VA_ARGS__)
+
+/// @cond
+
+/**
+ * Record is written if its level passes effective logging level and
+ * limiter of call site permits it: limiter_check is a call of one of
+ * yeti::LogLimiter methods. Suppressed occurrences are reported in the next
+ * written message.
+ */
+#define _YETI_LOG_LIMITED(log_level, level_name, color, limiter_check, \
+                          fmt, ...) { \
+  static const yeti::LogSite __yeti_site__ = { \
+      log_level, level_name, color, __FILE__, __func__, __LINE__ }; \
+  if (yeti::_GetLogSiteAction(&__yeti_site__, fmt) == yeti::_kSiteLog) { \
+    static yeti::LogLimiter __yeti_limiter__; \
+    if (__yeti_limiter__.limiter_check) { \
+      yeti::_LogLimitedPrintf(&__yeti_site__, \
+                              __yeti_limiter__.TakeSuppressed(), \
+                              fmt, ##__VA_ARGS__); \
+    } \
   } \
 }
 
+/// @endcond
+
 /**
- * @brief Logs trace message using specified printf-like format.
+ * Rate-limited and sampled logging macros (printf-like format):
+ *   <LEVEL>_EVERY_N(n, msg_fmt, ...);   - logs every n-th occurrence;
+ *   <LEVEL>_EVERY_MS(ms, msg_fmt, ...); - logs at most once per ms milliseconds;
+ *   <LEVEL>_FIRST_N(n, msg_fmt, ...);   - logs the first n occurrences only;
+ *   <LEVEL>_SAMPLED(p, msg_fmt, ...);   - logs occurrence with probability p;
+ * where <LEVEL> is one of CRT, ERR, WRN, INF, DBG, TRC.
+ */
+#define CRT_EVERY_N(n, fmt, ...) \
+  _YETI_LOG_LIMITED(yeti::LOG_LEVEL_CRITICAL, "CRT", YETI_LRED, EveryN(n), \
+                    fmt, ##__VA_ARGS__)
+#define CRT_EVERY_MS(ms, fmt, ...) \
+  _YETI_LOG_LIMITED(yeti::LOG_LEVEL_CRITICAL, "CRT", YETI_LRED, EveryMs(ms), \
+                    fmt, ##__VA_ARGS__)
+#define CRT_FIRST_N(n, fmt, ...) \
+  _YETI_LOG_LIMITED(yeti::LOG_LEVEL_CRITICAL, "CRT", YETI_LRED, FirstN(n), \
+                    fmt, ##__VA_ARGS__)
+#define CRT_SAMPLED(p, fmt, ...) \
+  _YETI_LOG_LIMITED(yeti::LOG_LEVEL_CRITICAL, "CRT", YETI_LRED, Sample(p), \
+                    fmt, ##__VA_ARGS__)
+
+#define ERR_EVERY_N(n, fmt, ...) \
+  _YETI_LOG_LIMITED(yeti::LOG_LEVEL_ERROR, "ERR", YETI_LPURPLE, EveryN(n), \
+                    fmt, ##__VA_ARGS__)
+#define ERR_EVERY_MS(ms, fmt, ...) \
+  _YETI_LOG_LIMITED(yeti::LOG_LEVEL_ERROR, "ERR", YETI_LPURPLE, EveryMs(ms), \
+                    fmt, ##__VA_ARGS__)
+#define ERR_FIRST_N(n, fmt, ...) \
+  _YETI_LOG_LIMITED(yeti::LOG_LEVEL_ERROR, "ERR", YETI_LPURPLE, FirstN(n), \
+                    fmt, ##__VA_ARGS__)
+#define ERR_SAMPLED(p, fmt, ...) \
+  _YETI_LOG_LIMITED(yeti::LOG_LEVEL_ERROR, "ERR", YETI_LPURPLE, Sample(p), \
+                    fmt, ##__VA_ARGS__)
+
+#define WRN_EVERY_N(n, fmt, ...) \
+  _YETI_LOG_LIMITED(yeti::LOG_LEVEL_WARNING, "WRN", YETI_YELLOW, EveryN(n), \
+                    fmt, ##__VA_ARGS__)
+#define WRN_EVERY_MS(ms, fmt, ...) \
+  _YETI_LOG_LIMITED(yeti::LOG_LEVEL_WARNING, "WRN", YETI_YELLOW, EveryMs(ms), \
+                    fmt, ##__VA_ARGS__)
+#define WRN_FIRST_N(n, fmt, ...) \
+  _YETI_LOG_LIMITED(yeti::LOG_LEVEL_WARNING, "WRN", YETI_YELLOW, FirstN(n), \
+                    fmt, ##__VA_ARGS__)
+#define WRN_SAMPLED(p, fmt, ...) \
+  _YETI_LOG_LIMITED(yeti::LOG_LEVEL_WARNING, "WRN", YETI_YELLOW, Sample(p), \
+                    fmt, ##__VA_ARGS__)
+
+#define INF_EVERY_N(n, fmt, ...) \
+  _YETI_LOG_LIMITED(yeti::LOG_LEVEL_INFO, "INF", YETI_LGREEN, EveryN(n), \
+                    fmt, ##__VA_ARGS__)
+#define INF_EVERY_MS(ms, fmt, ...) \
+  _YETI_LOG_LIMITED(yeti::LOG_LEVEL_INFO, "INF", YETI_LGREEN, EveryMs(ms), \
+                    fmt, ##__VA_ARGS__)
+#define INF_FIRST_N(n, fmt, ...) \
+  _YETI_LOG_LIMITED(yeti::LOG_LEVEL_INFO, "INF", YETI_LGREEN, FirstN(n), \
+                    fmt, ##__VA_ARGS__)
+#define INF_SAMPLED(p, fmt, ...) \
+  _YETI_LOG_LIMITED(yeti::LOG_LEVEL_INFO, "INF", YETI_LGREEN, Sample(p), \
+                    fmt, ##__VA_ARGS__)
+
+#define DBG_EVERY_N(n, fmt, ...) \
+  _YETI_LOG_LIMITED(yeti::LOG_LEVEL_DEBUG, "DBG", YETI_WHITE, EveryN(n), \
+                    fmt, ##__VA_ARGS__)
+#define DBG_EVERY_MS(ms, fmt, ...) \
+  _YETI_LOG_LIMITED(yeti::LOG_LEVEL_DEBUG, "DBG", YETI_WHITE, EveryMs(ms), \
+                    fmt, ##__VA_ARGS__)
+#define DBG_FIRST_N(n, fmt, ...) \
+  _YETI_LOG_LIMITED(yeti::LOG_LEVEL_DEBUG, "DBG", YETI_WHITE, FirstN(n), \
+                    fmt, ##__VA_ARGS__)
+#define DBG_SAMPLED(p, fmt, ...) \
+  _YETI_LOG_LIMITED(yeti::LOG_LEVEL_DEBUG, "DBG", YETI_WHITE, Sample(p), \
+                    fmt, ##__VA_ARGS__)
+
+#define TRC_EVERY_N(n, fmt, ...) \
+  _YETI_LOG_LIMITED(yeti::LOG_LEVEL_TRACE, "TRC", "", EveryN(n), \
+                    fmt, ##__VA_ARGS__)
+#define TRC_EVERY_MS(ms, fmt, ...) \
+  _YETI_LOG_LIMITED(yeti::LOG_LEVEL_TRACE, "TRC", "", EveryMs(ms), \
+                    fmt, ##__VA_ARGS__)
+#define TRC_FIRST_N(n, fmt, ...) \
+  _YETI_LOG_LIMITED(yeti::LOG_LEVEL_TRACE, "TRC", "", FirstN(n), \
+                    fmt, ##__VA_ARGS__)
+#define TRC_SAMPLED(p, fmt, ...) \
+  _YETI_LOG_LIMITED(yeti::LOG_LEVEL_TRACE, "TRC", "", Sample(p), \
+                    fmt, ##__VA_ARGS__)
+
+/// @cond
+
+/**
+ * Format is a string literal with {} placeholders ({{ and }} are escaped
+ * braces). It is checked against arguments and split into pieces at compile
+ * time. Arguments are copied into record and message is rendered by backend.
  */
-#define TRC(fmt, ...) { \
-  std::size_t __yeti_msg_id__ = yeti::_GetMsgId(); \
-  yeti::_IncMsgId(); \
-  if (yeti::GetLogLevel() >= yeti::LOG_LEVEL_TRACE) { \
-    auto __yeti_data__ = std::make_shared<yeti::LogData>(); \
-    __yeti_data__->level = "TRC"; \
-    __yeti_data__->color = ""; \
-    __yeti_data__->filename = __FILE__; \
-    __yeti_data__->funcname = __func__; \
-    __yeti_data__->line = __LINE__; \
-    __yeti_data__->msg_id = __yeti_msg_id__; \
-    \
-    char __yeti_msg__[MAX_MSG_LENGTH] = { 0 }; \
-    std::snprintf(__yeti_msg__, sizeof(__yeti_msg__), fmt, ##__VA_ARGS__); \
-    __yeti_data__->msg = __yeti_msg__; \
-    \
-    yeti::_EnqueueLogTask(__yeti_data__); \
+#define _YETI_FMT_SITE(category, log_level, level_name, color, fmt, ...) \
+  typedef decltype(yeti::_FmtArgTypes(__VA_ARGS__)) __yeti_args__; \
+  static_assert(yeti::_FmtCountArgs(fmt) != yeti::kFmtMalformed, \
+                "malformed format: unmatched brace"); \
+  static_assert(yeti::_FmtCountArgs(fmt) == __yeti_args__::kSize, \
+                "number of {} placeholders doesn't match number of args"); \
+  static constexpr yeti::_FormatPieces<yeti::_FmtCountPieces(fmt)> \
+      __yeti_pieces__ = yeti::_ParseFormat<yeti::_FmtCountPieces(fmt)>(fmt); \
+  static const yeti::LogSite __yeti_site__ = { \
+      log_level, level_name, color, __FILE__, __func__, __LINE__, \
+      fmt, __yeti_pieces__.pieces, yeti::_FmtCountPieces(fmt), \
+      &__yeti_args__::Render, category }
+
+#define _YETI_LOG_FMT_CAT(category, log_level, level_name, color, fmt, ...) { \
+  _YETI_FMT_SITE(category, log_level, level_name, color, fmt, ##__VA_ARGS__); \
+  const int __yeti_action__ = yeti::_GetLogSiteAction(&__yeti_site__, fmt); \
+  if (__yeti_action__ == yeti::_kSiteLog) { \
+    __yeti_args__::Log(&__yeti_site__, ##__VA_ARGS__); \
+  } else if (__yeti_action__ == yeti::_kSiteCapture) { \
+    __yeti_args__::Capture(&__yeti_site__, ##__VA_ARGS__); \
+  } \
+}
+
+#define _YETI_LOG_FMT(log_level, level_name, color, fmt, ...) \
+  _YETI_LOG_FMT_CAT(nullptr, log_level, level_name, color, fmt, ##__VA_ARGS__)
+
+#define _YETI_LOG_FMT_TO(handle, log_level, level_name, color, fmt, ...) { \
+  _YETI_FMT_SITE(nullptr, log_level, level_name, color, fmt, ##__VA_ARGS__); \
+  const yeti::LogHandle& __yeti_handle__ = (handle); \
+  if (__yeti_handle__.IsEnabled(log_level)) { \
+    __yeti_args__::LogTo(__yeti_handle__._GetLogger(), &__yeti_site__, \
+                         ##__VA_ARGS__); \
   } \
 }
 
+/// @endcond
+
+/**
+ * Type-safe logging macros with {}-style format:
+ *   <LEVEL>_FMT("{} took {} ms", name, elapsed);
+ * where <LEVEL> is one of CRT, ERR, WRN, INF, DBG, TRC. Arguments may be
+ * integers, floats, bools, chars, pointers, C strings, std::string,
+ * std::string_view and user types with yeti::Formatter specialization.
+ */
+#define CRT_FMT(fmt, ...) \
+  _YETI_LOG_FMT(yeti::LOG_LEVEL_CRITICAL, "CRT", YETI_LRED, fmt, ##__VA_ARGS__)
+#define ERR_FMT(fmt, ...) \
+  _YETI_LOG_FMT(yeti::LOG_LEVEL_ERROR, "ERR", YETI_LPURPLE, fmt, ##__VA_ARGS__)
+#define WRN_FMT(fmt, ...) \
+  _YETI_LOG_FMT(yeti::LOG_LEVEL_WARNING, "WRN", YETI_YELLOW, fmt, \
+                ##__VA_ARGS__)
+#define INF_FMT(fmt, ...) \
+  _YETI_LOG_FMT(yeti::LOG_LEVEL_INFO, "INF", YETI_LGREEN, fmt, ##__VA_ARGS__)
+#define DBG_FMT(fmt, ...) \
+  _YETI_LOG_FMT(yeti::LOG_LEVEL_DEBUG, "DBG", YETI_WHITE, fmt, ##__VA_ARGS__)
+#define TRC_FMT(fmt, ...) \
+  _YETI_LOG_FMT(yeti::LOG_LEVEL_TRACE, "TRC", "", fmt, ##__VA_ARGS__)
+
+/**
+ * Type-safe logging macros of category (see yeti::LogCategory):
+ *   <LEVEL>_FMT_CAT(g_db_log, "query took {} ms", elapsed);
+ */
+#define CRT_FMT_CAT(category, fmt, ...) \
+  _YETI_LOG_FMT_CAT(&(category), yeti::LOG_LEVEL_CRITICAL, "CRT", YETI_LRED, \
+                    fmt, ##__VA_ARGS__)
+#define ERR_FMT_CAT(category, fmt, ...) \
+  _YETI_LOG_FMT_CAT(&(category), yeti::LOG_LEVEL_ERROR, "ERR", YETI_LPURPLE, \
+                    fmt, ##__VA_ARGS__)
+#define WRN_FMT_CAT(category, fmt, ...) \
+  _YETI_LOG_FMT_CAT(&(category), yeti::LOG_LEVEL_WARNING, "WRN", \
+                    YETI_YELLOW, fmt, ##__VA_ARGS__)
+#define INF_FMT_CAT(category, fmt, ...) \
+  _YETI_LOG_FMT_CAT(&(category), yeti::LOG_LEVEL_INFO, "INF", YETI_LGREEN, \
+                    fmt, ##__VA_ARGS__)
+#define DBG_FMT_CAT(category, fmt, ...) \
+  _YETI_LOG_FMT_CAT(&(category), yeti::LOG_LEVEL_DEBUG, "DBG", YETI_WHITE, \
+                    fmt, ##__VA_ARGS__)
+#define TRC_FMT_CAT(category, fmt, ...) \
+  _YETI_LOG_FMT_CAT(&(category), yeti::LOG_LEVEL_TRACE, "TRC", "", \
+                    fmt, ##__VA_ARGS__)
+
+/**
+ * Type-safe logging macros writing into logger of handle (see
+ * yeti::LogHandle):
+ *   <LEVEL>_FMT_TO(g_audit_log, "user {} logged in", name);
+ */
+#define CRT_FMT_TO(handle, fmt, ...) \
+  _YETI_LOG_FMT_TO(handle, yeti::LOG_LEVEL_CRITICAL, "CRT", YETI_LRED, \
+                   fmt, ##__VA_ARGS__)
+#define ERR_FMT_TO(handle, fmt, ...) \
+  _YETI_LOG_FMT_TO(handle, yeti::LOG_LEVEL_ERROR, "ERR", YETI_LPURPLE, \
+                   fmt, ##__VA_ARGS__)
+#define WRN_FMT_TO(handle, fmt, ...) \
+  _YETI_LOG_FMT_TO(handle, yeti::LOG_LEVEL_WARNING, "WRN", YETI_YELLOW, \
+                   fmt, ##__VA_ARGS__)
+#define INF_FMT_TO(handle, fmt, ...) \
+  _YETI_LOG_FMT_TO(handle, yeti::LOG_LEVEL_INFO, "INF", YETI_LGREEN, \
+                   fmt, ##__VA_ARGS__)
+#define DBG_FMT_TO(handle, fmt, ...) \
+  _YETI_LOG_FMT_TO(handle, yeti::LOG_LEVEL_DEBUG, "DBG", YETI_WHITE, \
+                   fmt, ##__VA_ARGS__)
+#define TRC_FMT_TO(handle, fmt, ...) \
+  _YETI_LOG_FMT_TO(handle, yeti::LOG_LEVEL_TRACE, "TRC", "", \
+                   fmt, ##__VA_ARGS__)
+
+/// @cond
+
+#define _YETI_STREAM_CRT yeti::LOG_LEVEL_CRITICAL, "CRT", YETI_LRED
+#define _YETI_STREAM_ERR yeti::LOG_LEVEL_ERROR, "ERR", YETI_LPURPLE
+#define _YETI_STREAM_WRN yeti::LOG_LEVEL_WARNING, "WRN", YETI_YELLOW
+#define _YETI_STREAM_INF yeti::LOG_LEVEL_INFO, "INF", YETI_LGREEN
+#define _YETI_STREAM_DBG yeti::LOG_LEVEL_DEBUG, "DBG", YETI_WHITE
+#define _YETI_STREAM_TRC yeti::LOG_LEVEL_TRACE, "TRC", ""
+
+/**
+ * Loops run once at most: operands of operator<< are not evaluated if
+ * record is filtered out, and message is enqueued when temporary stream is
+ * destroyed at the end of statement.
+ */
+#define _YETI_LOG_STREAM(category, log_level, level_name, color) \
+  for (bool __yeti_once__ = true; __yeti_once__; __yeti_once__ = false) \
+    for (static const yeti::LogSite __yeti_site__ = { \
+             log_level, level_name, color, __FILE__, __func__, __LINE__, \
+             nullptr, nullptr, 0, nullptr, category }; \
+         __yeti_once__ && yeti::_GetLogSiteAction(&__yeti_site__, nullptr) != \
+             yeti::_kSiteOff; \
+         __yeti_once__ = false) \
+      yeti::_LogStream(&__yeti_site__).stream()
+
+#define _YETI_LOG_STREAM_ARGS(...) _YETI_LOG_STREAM(__VA_ARGS__)
+
+#define _YETI_LOG_STREAM_TO(handle, log_level, level_name, color) \
+  for (const yeti::LogHandle* __yeti_handle__ = &(handle); \
+       __yeti_handle__ != nullptr; __yeti_handle__ = nullptr) \
+    for (static const yeti::LogSite __yeti_site__ = { \
+             log_level, level_name, color, __FILE__, __func__, __LINE__ }; \
+         __yeti_handle__ != nullptr && \
+             __yeti_handle__->IsEnabled(log_level); \
+         __yeti_handle__ = nullptr) \
+      yeti::_LogStream(&__yeti_site__, __yeti_handle__->_GetLogger()).stream()
+
+#define _YETI_LOG_STREAM_TO_ARGS(...) _YETI_LOG_STREAM_TO(__VA_ARGS__)
+
+/// @endcond
+
+/**
+ * @brief Logs message written by operator<<, e.g.
+ * YETI_LOG(INF) << "connected to " << endpoint;
+ * where level is one of CRT, ERR, WRN, INF, DBG, TRC.
+ */
+#define YETI_LOG(level) _YETI_LOG_STREAM_ARGS(nullptr, _YETI_STREAM_##level)
+
+/**
+ * @brief Logs message of category written by operator<<, e.g.
+ * YETI_LOG_CAT(DBG, g_net_log) << "sent " << size << " bytes";
+ */
+#define YETI_LOG_CAT(level, category) \
+  _YETI_LOG_STREAM_ARGS(&(category), _YETI_STREAM_##level)
+
+/**
+ * @brief Logs message written by operator<< into logger of handle, e.g.
+ * YETI_LOG_TO(INF, g_audit_log) << "user " << name << " logged in";
+ */
+#define YETI_LOG_TO(level, handle) \
+  _YETI_LOG_STREAM_TO_ARGS(handle, _YETI_STREAM_##level)
+
+/// @cond
+
+#define _YETI_SCOPE(log_level, level_name, color, name) \
+  static const yeti::LogSite _YETI_CONCAT(__yeti_span_site_, __LINE__) = { \
+      log_level, level_name, color, __FILE__, __func__, __LINE__, name, \
+      nullptr, 0, &yeti::_RenderSpan }; \
+  yeti::LogSpan _YETI_CONCAT(__yeti_span_, __LINE__)( \
+      &_YETI_CONCAT(__yeti_span_site_, __LINE__))
+
+#define _YETI_SCOPE_ARGS(...) _YETI_SCOPE(__VA_ARGS__)
+
+/// @endcond
+
+/**
+ * @brief Times the rest of enclosing scope, e.g.
+ * YETI_SCOPE_AT(DBG, "parse request");
+ * where level is one of CRT, ERR, WRN, INF, DBG, TRC. Name must be string
+ * literal. Span is written as `<name> took <N> us` record with depth, span_id
+ * and parent_id fields, or as Chrome trace event (see SetLogTraceFile()).
+ */
+#define YETI_SCOPE_AT(level, name) \
+  _YETI_SCOPE_ARGS(_YETI_STREAM_##level, name)
+
+/** @brief Times the rest of enclosing scope at INF level. */
+#define YETI_SCOPE(name) YETI_SCOPE_AT(INF, name)
+
 #endif  // YETI_DISABLE_LOGGING
 
 #define CRITICAL(fmt, ...) CRT(fmt, ##__VA_ARGS__)
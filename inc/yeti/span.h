@@ -0,0 +1,74 @@
+/**
+ * @file span.h
+ * @brief Scoped timing of code spans written as records or trace events.
+ */
+
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+#ifndef INC_YETI_SPAN_H_
+#define INC_YETI_SPAN_H_
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <yeti/yeti.h>
+
+namespace yeti {
+
+/// @cond
+void _RenderSpan(const LogSite* site, const char* args, std::string* msg,
+                 std::string* fields, bool is_json);
+/// @endcond
+
+/**
+ * @brief Measures time from construction to destruction and enqueues
+ * record of the span (use YETI_SCOPE macro).
+ *
+ * Span has ID unique in process, ID of enclosing span of thread and nesting
+ * depth. Nothing is measured if level of site is filtered out at
+ * construction.
+ */
+class LogSpan {
+ public:
+  explicit LogSpan(const LogSite* site);
+  ~LogSpan();
+
+  LogSpan(const LogSpan&) = delete;
+  LogSpan& operator=(const LogSpan&) = delete;
+
+ private:
+  const LogSite* site_;  // nullptr if span is filtered out
+  std::chrono::high_resolution_clock::time_point begin_;
+  std::uint64_t span_id_;
+  std::uint64_t parent_id_;
+  std::uint32_t depth_;
+};
+
+}  // namespace yeti
+
+#endif  // INC_YETI_SPAN_H_
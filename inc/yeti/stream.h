@@ -0,0 +1,81 @@
+/**
+ * @file backtrace.h
+ * @brief Capturing of filtered records into per-thread backtrace ring.
+ */
+
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+
+#ifndef INC_YETI_STREAM_H_
+#define INC_YETI_STREAM_H_
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <yeti/yeti.h>
+
+/// @cond
+
+namespace yeti {
+
+class Logger;
+struct _LogStreamState;
+
+/**
+ * @brief Collects message of stream-style macro and enqueues it on
+ * destruction.
+ *
+ * Message is written into preallocated buffer of current thread, which is
+ * reused by all records of the thread.
+ */
+class _LogStream {
+ public:
+  // logger is nullptr for the default one
+  explicit _LogStream(const LogSite* site, Logger* logger = nullptr);
+  ~_LogStream();
+  _LogStream(const _LogStream&) = delete;
+  _LogStream& operator=(const _LogStream&) = delete;
+
+  std::ostream& stream();
+
+ private:
+  const LogSite* site_;
+  Logger* logger_;
+  std::size_t msg_id_;
+  std::chrono::high_resolution_clock::time_point time_;
+  _LogStreamState* state_;
+};
+
+/** @brief Swallows everything when logging is disabled. */
+struct _NullLogStream {
+  template <typename T>
+  _NullLogStream& operator<<(const T& /* value */) { return *this; }
+  _NullLogStream& operator<<(std::ostream& (* /* manip */)(std::ostream&)) {
+    return *this;
+  }
+};
+
+}  // namespace yeti
+
+/// @endcond
+
+#endif  // INC_YETI_STREAM_H_
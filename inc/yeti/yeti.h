@@ -33,9 +33,13 @@
 #ifndef INC_YETI_YETI_H_
 #define INC_YETI_YETI_H_
 
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <chrono>
 #include <string>
+#include <thread>
+#include <vector>
 
 /**
  * @namespace yeti
@@ -63,12 +67,288 @@ enum LogLevel {
   LOG_LEVEL_TRACE
 };
 
+/**
+ * @brief Engines to write queued log records.
+ *
+ * LOG_ENGINE_THREAD is a dedicated backend thread which is woken up
+ * for every record.
+ *
+ * LOG_ENGINE_COMBINING has no wakeups: producer which finds combiner free
+ * writes bounded batch of pending records for everyone, other producers just
+ * enqueue their records and return. Records left by the last combiner are
+ * written by timer in a few milliseconds.
+ */
+enum LogEngine {
+  LOG_ENGINE_THREAD,
+  LOG_ENGINE_COMBINING
+};
+
+/**
+ * @brief Output formats of log records.
+ *
+ * LOG_OUTPUT_TEXT writes records by format string (see SetLogFormatStr()).
+ *
+ * LOG_OUTPUT_JSON writes one JSON object per line with members level, ts
+ * (UTC time in ISO 8601 format), file, line, func, pid, tid, msg_id and msg
+ * followed by context of thread and key/value fields of record. Format
+ * string and colors are ignored.
+ */
+enum LogOutput {
+  LOG_OUTPUT_TEXT,
+  LOG_OUTPUT_JSON
+};
+
+/**
+ * @brief Limits of log queue pressure to degrade logging level.
+ *
+ * When log queue depth or backend lag (time from enqueueing the oldest
+ * record in batch to writing it) reaches its high-water mark, logging level
+ * checked by macros is temporarily lowered to degraded_level. It is restored
+ * when both depth and lag fall to their low-water marks. Zero high-water mark
+ * disables corresponding check.
+ */
+struct LogPressureLimits {
+  std::size_t queue_high_water;
+  std::size_t queue_low_water;
+  std::chrono::milliseconds lag_high_water;
+  std::chrono::milliseconds lag_low_water;
+  LogLevel degraded_level;
+};
+
+/**
+ * @brief Policy of watchdog of stalled sinks.
+ *
+ * Backend times every write: a sink which write takes threshold or longer
+ * is stalled. Records of stalled sink are written into fallback sink, or
+ * without fallback records less severe than keep_level are dropped (more
+ * severe ones are still written into it). Once per probe_interval a record
+ * is written into stalled sink anyway, and the sink is recovered as soon as
+ * its write is faster than threshold. Zero threshold disables watchdog.
+ */
+struct LogStallPolicy {
+  std::chrono::milliseconds threshold;
+  std::chrono::milliseconds probe_interval;
+  FILE* fallback;
+  LogLevel keep_level;
+};
+
+/** @brief Mode of logging macro call site. */
+enum LogSiteMode {
+  LOG_SITE_DEFAULT,   // site follows logging level
+  LOG_SITE_ENABLED,   // records of site are always written
+  LOG_SITE_DISABLED   // records of site are never written
+};
+
+/**
+ * @brief Selects call sites of logging macros.
+ *
+ * file, func and format are shell globs (file matches full path or base
+ * name), empty glob matches any site. Lines are inclusive, zero is no limit.
+ */
+struct LogSiteFilter {
+  LogSiteFilter() : first_line(0), last_line(0) {}
+
+  std::string file;
+  std::string func;
+  int first_line;
+  int last_line;
+  std::string format;
+};
+
+/** @brief Description of registered call site. */
+struct LogSiteInfo {
+  std::string file;
+  std::string func;
+  int line;
+  LogLevel level;
+  std::string category;  // name of category (empty if site has no one)
+  std::string format;  // format of the first record (empty for streams)
+  LogSiteMode mode;
+  bool is_enabled;     // records of site are written now
+};
+
+/**
+ * @brief Counters of call site since profiling is on.
+ *
+ * Calls which are neither emitted nor filtered out by level or mode of site
+ * are suppressed by rate limiter of site.
+ */
+struct LogSiteProfile {
+  std::string file;
+  std::string func;
+  int line;
+  LogLevel level;
+  std::uint64_t calls;
+  std::uint64_t emitted;   // records enqueued
+  std::uint64_t filtered;  // records filtered out (or captured in backtrace)
+  std::uint64_t bytes;     // bytes written into sinks
+  std::chrono::nanoseconds producer_time;  // spent in calls of emitted ones
+};
+
+/** @brief Number of logging levels to index counters by LogLevel. */
+const int kLogLevelCount = LOG_LEVEL_TRACE + 1;
+
+/**
+ * @brief Percentiles of latency samples.
+ *
+ * Percentiles are upper bounds of histogram buckets, so they are at most 1/32
+ * higher than exact ones (and never higher than max).
+ */
+struct LogLatency {
+  std::uint64_t count;  // number of samples
+  std::chrono::nanoseconds p50;
+  std::chrono::nanoseconds p99;
+  std::chrono::nanoseconds p999;
+  std::chrono::nanoseconds max;
+};
+
+/** @brief Counters of sink (file descriptor records are written into). */
+struct LogSinkStats {
+  FILE* fd;
+  std::uint64_t records;  // records and summaries of repeated ones
+  std::uint64_t bytes;
+  LogLatency write_latency;  // from logging call to write into sink
+  bool is_stalled;           // see yeti::LogStallPolicy
+  std::uint64_t stalls;      // times sink got stalled
+  std::uint64_t rerouted;    // records written into fallback while stalled
+  std::uint64_t discarded;   // records dropped while stalled
+};
+
+/**
+ * @brief Counters of logger since its start.
+ *
+ * Records enqueued by producers are either written or dropped (repeated
+ * records collapsed by deduplication, or records of stalled sinks). Queue
+ * depth counts records and control tasks which aren't taken by backend yet.
+ * Backend is busy while it writes batch of records and idle while it waits
+ * for them.
+ *
+ * Write latency is time from logging call to return from write into sink
+ * (summaries of repeated records are not measured). Call latency is time
+ * spent by producer thread in logging call, it is sampled once per 64 calls
+ * of thread.
+ */
+struct LogStats {
+  std::uint64_t enqueued[kLogLevelCount];
+  std::uint64_t written[kLogLevelCount];
+  std::uint64_t dropped[kLogLevelCount];
+  std::vector<LogSinkStats> sinks;
+  std::size_t queue_depth;
+  std::size_t peak_queue_depth;
+  std::chrono::nanoseconds busy_time;
+  std::chrono::nanoseconds idle_time;
+  std::uint64_t batches;
+  std::uint64_t batched_tasks;  // average batch is batched_tasks / batches
+  std::size_t max_batch_size;
+  LogLatency write_latency[kLogLevelCount];
+  LogLatency call_latency[kLogLevelCount];
+};
+
 /** @brief Sets logging level. */
 void SetLogLevel(LogLevel level) noexcept;
 
 /** @brief Returns current logging level. */
 int GetLogLevel() noexcept;
 
+/**
+ * @brief Sets logging levels in format of YETI_LOG_LEVEL variable, e.g.
+ * "warn,net=dbg,db.*=trc".
+ *
+ * Level without name is the global one (kept if there is no one), and
+ * name=level pairs replace all levels of categories (see
+ * yeti::SetLogCategoryLevel()).
+ */
+void SetLogLevels(const std::string& levels);
+
+/**
+ * @brief Sets logging level of categories matching glob pattern and of their
+ * children ("net" sets "net.tcp" too).
+ *
+ * Category gets level of the last pattern matching its name, or of its
+ * nearest parent. Categories without one follow the global logging level.
+ */
+void SetLogCategoryLevel(const std::string& pattern, LogLevel level);
+
+/** @brief Makes all categories follow the global logging level. */
+void ResetLogCategoryLevels();
+
+/** @brief Returns logging level of category by its name. */
+int GetLogCategoryLevel(const std::string& name);
+
+/**
+ * @brief Sets logging level of current thread overriding the global one.
+ *
+ * Only call sites with levels between the global level and levels of
+ * threads check level of current thread, it is cached by thread until the
+ * next change of levels. Pressure degradation and backtrace apply to levels
+ * of threads as to the global one.
+ */
+void SetThreadLogLevel(LogLevel level);
+
+/** @brief Sets logging level of another thread by its ID. */
+void SetThreadLogLevel(std::thread::id thread_id, LogLevel level);
+
+/** @brief Makes current thread follow the global logging level again. */
+void ResetThreadLogLevel();
+
+/**
+ * @brief Makes thread follow the global logging level again.
+ *
+ * Override of thread is kept after thread exit until it is reset.
+ */
+void ResetThreadLogLevel(std::thread::id thread_id);
+
+/** @brief Returns logging level of current thread. */
+int GetThreadLogLevel();
+
+/** @brief Returns logging level of thread by its ID. */
+int GetThreadLogLevel(std::thread::id thread_id);
+
+/** @brief Sets limits of log queue pressure (disabled by default). */
+void SetLogPressureLimits(const LogPressureLimits& limits) noexcept;
+
+/** @brief Returns current limits of log queue pressure. */
+LogPressureLimits GetLogPressureLimits() noexcept;
+
+/** @brief Returns is logging level degraded due to log queue pressure. */
+bool IsLogDegraded() noexcept;
+
+/** @brief Sets policy of watchdog of stalled sinks (disabled by default). */
+void SetLogStallPolicy(const LogStallPolicy& policy) noexcept;
+
+/** @brief Returns current policy of watchdog of stalled sinks. */
+LogStallPolicy GetLogStallPolicy() noexcept;
+
+/** @brief Returns counters of the default logger. */
+LogStats GetLogStats();
+
+/**
+ * @brief Sets period to log counters of the default logger as info record
+ * (zero period turns it off).
+ */
+void SetLogStatsInterval(std::chrono::milliseconds interval) noexcept;
+
+/** @brief Returns period to log counters. */
+std::chrono::milliseconds GetLogStatsInterval() noexcept;
+
+/**
+ * @brief Sets backtrace buffering of filtered records.
+ *
+ * Records filtered out by logging level, but passing capture_level, are not
+ * written: their arguments are copied into ring of last size records of
+ * current thread without formatting. When record at or above trigger_level is
+ * written from that thread, ring contents are written just before it with
+ * their original message IDs and timestamps.
+ *
+ * Zero size turns backtrace buffering off (default).
+ */
+void SetLogBacktrace(std::size_t size,
+                     LogLevel capture_level = LOG_LEVEL_TRACE,
+                     LogLevel trigger_level = LOG_LEVEL_ERROR) noexcept;
+
+/** @brief Returns size of per-thread backtrace ring (0 if it is off). */
+std::size_t GetLogBacktraceSize() noexcept;
+
 /** @brief Sets log to be colored. */
 void SetLogColored(bool is_colored) noexcept;
 
@@ -87,6 +367,34 @@ void SetLogFileDesc(FILE* fd) noexcept;
 /** @brief Returns current log file descriptor. */
 FILE* GetLogFileDesc() noexcept;
 
+/**
+ * @brief Collapses consecutive repeated records written into fd.
+ *
+ * Records with the same call site and message written within window from
+ * the first one of the run are suppressed. When the run is over (another
+ * record, window expiration, yeti::FlushLog() or closing fd), one line with
+ * count and time span of repetitions is written. Zero window turns
+ * deduplication off (default).
+ */
+void SetLogDedup(FILE* fd, std::chrono::milliseconds window);
+
+/** @brief Returns time window to collapse repeated records written into fd. */
+std::chrono::milliseconds GetLogDedup(FILE* fd) noexcept;
+
+/**
+ * @brief Turns escaping of messages written into fd on or off.
+ *
+ * Control characters (newlines, ANSI escape sequences, etc.) and invalid
+ * UTF-8 in messages and context values are escaped as \\n, \\r, \\t or
+ * \\xHH, so every record takes exactly one line. Backslash is escaped as
+ * \\\\, so escapes written by user can't be mistaken for these ones. It is
+ * off by default.
+ */
+void SetLogSanitized(FILE* fd, bool is_sanitized);
+
+/** @brief Returns is escaping of messages written into fd on. */
+bool IsLogSanitized(FILE* fd) noexcept;
+
 /**
  * @brief Closes specified log file descriptor.
  *
@@ -109,6 +417,7 @@ void CloseLogFileDesc(FILE* fd = nullptr);
  * <li> %(MSG_ID)   - unique message number to refer in discussion with colleagues </li>
  * <li> %(DATE)     - local date in YYYY-MM-DD format (the ISO 8601 date format) </li>
  * <li> %(TIME)     - local time in HH:MM:SS.SSS format (based on the ISO 8601 time format) </li>
+ * <li> %(CTX:key)  - value of key in context of thread (see yeti::LogContext) </li>
  * </ul>
  *
  * You should always use %(MSG) in format string if you want to log user message.
@@ -118,9 +427,122 @@ void SetLogFormatStr(const std::string& format_str) noexcept;
 /** @brief Returns current format string. */
 std::string GetLogFormatStr() noexcept;
 
+/** @brief Sets output format of log records. */
+void SetLogOutput(LogOutput output) noexcept;
+
+/** @brief Returns current output format of log records. */
+LogOutput GetLogOutput() noexcept;
+
+/**
+ * @brief Sets file to write spans of YETI_SCOPE as Chrome trace events.
+ *
+ * Events are written as JSON array (closing bracket is optional in trace
+ * event format), which can be loaded into chrome://tracing or Perfetto.
+ * Every file other than the current one opens new array, so file should be
+ * set once. Spans are written as log records again if fd is nullptr.
+ */
+void SetLogTraceFile(FILE* fd) noexcept;
+
+/** @brief Returns file to write spans as trace events (or nullptr). */
+FILE* GetLogTraceFile() noexcept;
+
+/**
+ * @brief Sets mode of call sites selected by filter, returns number of
+ * registered sites which match it.
+ *
+ * Call site is registered when it is reached for the first time, and modes
+ * are kept as rules, so sites registered later get them too (the latest
+ * matching rule wins). Cached actions of sites are updated at once.
+ */
+std::size_t SetLogSiteMode(const LogSiteFilter& filter, LogSiteMode mode);
+
+/** @brief Drops all rules of SetLogSiteMode(): sites follow logging level. */
+void ResetLogSiteModes();
+
+/** @brief Returns registered call sites selected by filter. */
+std::vector<LogSiteInfo> GetLogSites(
+    const LogSiteFilter& filter = LogSiteFilter());
+
+/**
+ * @brief Applies control commands, one per line, like in Linux dynamic debug:
+ * ~~~~~~
+ * file src/net* func Handle* line 100-200 format "conn*" enable
+ * ~~~~~~
+ * Keywords file, func, line (N or N-M) and format select sites, the last
+ * word is enable, disable or default. Empty lines and lines starting with #
+ * are skipped. Returns false if some line is malformed (it's ignored).
+ */
+bool ApplyLogSiteControl(const std::string& commands);
+
+/**
+ * @brief Sets control file which is applied at once and then again every
+ * time it is modified (it is checked by backend once a second).
+ *
+ * Commands of file replace all rules set before. Empty path stops watching.
+ * Returns false if file can't be read.
+ */
+bool SetLogSiteControlFile(const std::string& path);
+
+/**
+ * @brief Turns counters of call sites on or off.
+ *
+ * Sites reached while profiling is on count calls, emitted and filtered out
+ * records, written bytes and time of producers in per-thread counters.
+ * Filtered out records of profiled sites cost a function call instead of
+ * one load. Counters are kept when profiling is off.
+ */
+void SetLogSiteProfiling(bool is_enabled);
+
+/** @brief Returns whether counters of call sites are on. */
+bool IsLogSiteProfiling() noexcept;
+
+/** @brief Returns counters of profiled call sites. */
+std::vector<LogSiteProfile> GetLogSiteProfile();
+
+/**
+ * @brief Prints count profiled sites with the most bytes written and count
+ * sites with the most time spent by producers into fd.
+ */
+void DumpSiteProfile(std::size_t count = 10, FILE* fd = stderr);
+
+/**
+ * @brief Applies settings, one "key = value" per line:
+ * ~~~~~~
+ * level = warn,net=dbg       # the same as yeti::SetLogLevels()
+ * format = %(LEVEL) %(MSG)
+ * output = json              # text or json
+ * colored = off
+ * file = /var/log/app.log    # appended to, or stderr, or stdout
+ * dedup = 1000               # window in ms for file, 0 turns it off
+ * sanitize = on
+ * profile = on               # the same as yeti::SetLogSiteProfiling()
+ * site = func Reconnect* enable
+ * ~~~~~~
+ * Format and options of file are changed at once. Missing keys keep their
+ * values, but site lines (commands like in yeti::ApplyLogSiteControl())
+ * replace all rules set before. Empty lines and lines starting with # are
+ * skipped. Returns false if some line is malformed (it's ignored).
+ */
+bool ApplyLogConfig(const std::string& config);
+
+/**
+ * @brief Sets config file which is applied at once and then again every
+ * time it is modified (it is checked by backend once a second).
+ *
+ * File named by environment variable YETI_CONFIG is watched from start.
+ * Empty path stops watching. Returns false if file can't be read.
+ */
+bool SetLogConfigFile(const std::string& path);
+
 /** @brief Flush log queue (blocking call). */
 void FlushLog();
 
+/** @brief Sets engine to write log records. */
+void SetLogEngine(LogEngine engine) noexcept;
+
+/** @brief Returns current engine to write log records. */
+LogEngine GetLogEngine() noexcept;
+
 }  // namespace yeti
 
 #include <yeti/macro.h>
@@ -0,0 +1,82 @@
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+#include <vector>
+
+#include <src/log_context.h>
+#include <src/logger.h>
+
+namespace yeti {
+
+namespace {
+
+/** @brief Ring of the last records captured by current thread. */
+struct BacktraceRing {
+  std::vector<BacktraceRecord> records;
+  std::size_t head = 0;
+  std::size_t count = 0;
+};
+
+thread_local BacktraceRing g_backtrace;
+
+}  // namespace
+
+BacktraceRecord* _NextBacktraceRecord() {
+  std::size_t size = Logger::instance().GetBacktraceSize();
+  if (size == 0) return nullptr;
+
+  BacktraceRing& ring = g_backtrace;
+  if (ring.records.size() != size) {
+    // ring is allocated once per thread and reallocated on resizing only
+    ring.records.resize(size);
+    ring.head = 0;
+    ring.count = 0;
+  }
+
+  BacktraceRecord* record = &ring.records[(ring.head + ring.count) % size];
+  // context may change before ring is flushed
+  record->context = GetLogContextSnapshot();
+  if (ring.count < size) {
+    ++ring.count;
+  } else {
+    // overwrite the oldest record
+    ring.head = (ring.head + 1) % size;
+  }
+  return record;
+}
+
+void _FlushBacktrace(const LogSite* trigger) {
+  BacktraceRing& ring = g_backtrace;
+  for (; ring.count > 0; --ring.count) {
+    BacktraceRecord& record = ring.records[ring.head];
+    ring.head = (ring.head + 1) % ring.records.size();
+    Logger::instance().EnqueueBacktrace(record, trigger);
+    record.context.reset();
+  }
+}
+
+}  // namespace yeti
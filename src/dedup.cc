@@ -0,0 +1,127 @@
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+
+#include <src/dedup.h>
+
+namespace yeti {
+
+bool Deduplicator::IsRepeated(const LogRecord& record,
+                              std::chrono::milliseconds window) {
+  auto it = runs_.find(record.fd);
+  if (it != runs_.end()) {
+    // messages are compared as is, so encoded arguments aren't rendered
+    Run& run = it->second;
+    if (run.last.site == record.site &&
+        run.msg.size() == record.msg_len &&
+        std::memcmp(run.msg.data(), record.msg(), record.msg_len) == 0 &&
+        record.time - run.first_time <= window) {
+      run.last = record;
+      ++run.repeats;
+      return true;
+    }
+    WriteSummary(&run);
+  }
+
+  // run of sink is reused to keep capacity of its message
+  Run& run = runs_[record.fd];
+  run.first_time = record.time;
+  run.window = window;
+  run.last = record;
+  run.msg.assign(record.msg(), record.msg_len);
+  run.repeats = 0;
+  return false;
+}
+
+void Deduplicator::Flush(FILE* fd) {
+  if (fd == nullptr) {
+    for (auto& entry : runs_) {
+      WriteSummary(&entry.second);
+    }
+    runs_.clear();
+    return;
+  }
+
+  auto it = runs_.find(fd);
+  if (it != runs_.end()) {
+    WriteSummary(&it->second);
+    runs_.erase(it);
+  }
+}
+
+void Deduplicator::FlushExpired(
+    std::chrono::high_resolution_clock::time_point now) {
+  // repetitions which are still queued start a new run
+  for (auto it = runs_.begin(); it != runs_.end(); ) {
+    if (now - it->second.first_time > it->second.window) {
+      WriteSummary(&it->second);
+      it = runs_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+std::chrono::high_resolution_clock::time_point
+Deduplicator::GetDeadline() const {
+  auto deadline = std::chrono::high_resolution_clock::time_point::max();
+  for (const auto& entry : runs_) {
+    const Run& run = entry.second;
+    if (run.repeats > 0) {
+      deadline = std::min(deadline, run.first_time + run.window);
+    }
+  }
+  return deadline;
+}
+
+void Deduplicator::ReplaceConfig(const LogConfig* retired,
+                                 const LogConfig* replacement) {
+  for (auto& entry : runs_) {
+    if (entry.second.last.config == retired) {
+      entry.second.last.config = replacement;
+    }
+  }
+}
+
+void Deduplicator::WriteSummary(Run* run) {
+  if (run->repeats == 0) return;
+
+  using namespace std::chrono;
+  double span = duration_cast<duration<double>>(
+      run->last.time - run->first_time).count();
+  char msg[128] = { 0 };
+  std::snprintf(msg, sizeof(msg), "last message repeated %zu times in %.3f s",
+                run->repeats, span);
+  write_func_(run->last, msg, "");
+  run->repeats = 0;
+}
+
+}  // namespace yeti
@@ -0,0 +1,99 @@
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+#ifndef INC_YETI_DEDUP_H_
+#define INC_YETI_DEDUP_H_
+
+#include <cstdio>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <yeti/yeti.h>
+#include <src/record_queue.h>
+
+namespace yeti {
+
+/**
+ * @brief Collapses consecutive repeated records of every sink.
+ *
+ * Record repeats the previous one if it has the same call site and message
+ * and it is written within time window from the first record of the run.
+ * Repetitions are suppressed, and when the run is over (broken by another
+ * record or its window has passed), summary with their count and time span
+ * is written. It is used by backend only.
+ */
+class Deduplicator {
+ public:
+  typedef std::function<void(const LogRecord& record, const char* msg,
+                             const char* fields)> WriteFunc;
+
+  explicit Deduplicator(const WriteFunc& write_func)
+      : write_func_(write_func) {}
+
+  /**
+   * @brief Returns true if record should be suppressed as repetition.
+   *
+   * If record breaks the current run of its sink, summary of the run is
+   * written before returning.
+   */
+  bool IsRepeated(const LogRecord& record, std::chrono::milliseconds window);
+
+  /** @brief Writes summary of sink's run (of all runs if fd is nullptr). */
+  void Flush(FILE* fd = nullptr);
+
+  /** @brief Writes summaries of runs whose time window has passed by now. */
+  void FlushExpired(std::chrono::high_resolution_clock::time_point now);
+
+  /**
+   * @brief Returns when the first window of run with repetitions passes
+   * (time_point::max() if there is no such run).
+   */
+  std::chrono::high_resolution_clock::time_point GetDeadline() const;
+
+  /** @brief Makes runs referencing retired settings use their replacement. */
+  void ReplaceConfig(const LogConfig* retired, const LogConfig* replacement);
+
+ private:
+  struct Run {
+    std::chrono::high_resolution_clock::time_point first_time;
+    std::chrono::milliseconds window;
+    LogRecord last;  // header only, message is replaced by summary
+    std::string msg;  // message of the first record
+    std::size_t repeats;
+  };
+
+  void WriteSummary(Run* run);
+
+  WriteFunc write_func_;
+  std::map<FILE*, Run> runs_;
+};
+
+}  // namespace yeti
+
+#endif  // INC_YETI_DEDUP_H_
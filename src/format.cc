@@ -0,0 +1,153 @@
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <yeti/yeti.h>
+#include <src/sanitize.h>
+
+namespace yeti {
+
+namespace {
+
+// pairs of decimal digits: two digits are printed per division
+const char kDigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+}  // namespace
+
+void _FmtAppend(std::uint64_t value, std::string* out) {
+  char buf[20];
+  char* pos = buf + sizeof(buf);
+  while (value >= 100) {
+    pos -= 2;
+    std::memcpy(pos, kDigitPairs + 2 * (value % 100), 2);
+    value /= 100;
+  }
+  if (value >= 10) {
+    pos -= 2;
+    std::memcpy(pos, kDigitPairs + 2 * value, 2);
+  } else {
+    *--pos = static_cast<char>('0' + value);
+  }
+  out->append(pos, buf + sizeof(buf) - pos);
+}
+
+void _FmtAppend(std::int64_t value, std::string* out) {
+  std::uint64_t abs_value = static_cast<std::uint64_t>(value);
+  if (value < 0) {
+    out->push_back('-');
+    abs_value = ~abs_value + 1;
+  }
+  _FmtAppend(abs_value, out);
+}
+
+void _FmtAppend(double value, std::string* out) {
+  // the shortest of precisions which read back to the same value
+  char buf[32];
+  int len = std::snprintf(buf, sizeof(buf), "%.15g", value);
+  if (std::strtod(buf, nullptr) != value) {
+    len = std::snprintf(buf, sizeof(buf), "%.17g", value);
+  }
+  out->append(buf, len);
+}
+
+void _FmtAppend(bool value, std::string* out) {
+  out->append(value ? "true" : "false");
+}
+
+void _FmtAppend(char value, std::string* out) {
+  out->push_back(value);
+}
+
+void _FmtAppend(const void* value, std::string* out) {
+  static const char kHexDigits[] = "0123456789abcdef";
+  std::uintptr_t bits = reinterpret_cast<std::uintptr_t>(value);
+  char buf[2 * sizeof(bits)];
+  char* pos = buf + sizeof(buf);
+  do {
+    *--pos = kHexDigits[bits & 0xf];
+    bits >>= 4;
+  } while (bits != 0);
+  out->append("0x");
+  out->append(pos, buf + sizeof(buf) - pos);
+}
+
+void _FmtAppendJson(std::int64_t value, std::string* out) {
+  _FmtAppend(value, out);
+}
+
+void _FmtAppendJson(std::uint64_t value, std::string* out) {
+  _FmtAppend(value, out);
+}
+
+void _FmtAppendJson(double value, std::string* out) {
+  // JSON has no literals for infinities and NaN
+  if (!std::isfinite(value)) {
+    out->push_back('"');
+    _FmtAppend(value, out);
+    out->push_back('"');
+    return;
+  }
+  _FmtAppend(value, out);
+}
+
+void _FmtAppendJson(bool value, std::string* out) {
+  _FmtAppend(value, out);
+}
+
+void _FmtAppendJson(char value, std::string* out) {
+  _FmtAppendJson(&value, 1, out);
+}
+
+void _FmtAppendJson(const void* value, std::string* out) {
+  out->push_back('"');
+  _FmtAppend(value, out);
+  out->push_back('"');
+}
+
+void _FmtAppendJson(const char* data, std::size_t size, std::string* out) {
+  out->push_back('"');
+  EscapeJson(data, size, out);
+  out->push_back('"');
+}
+
+}  // namespace yeti
@@ -0,0 +1,117 @@
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+#include <yeti/handle.h>
+#include <src/logger.h>
+
+namespace yeti {
+
+LogHandle::LogHandle(const LogHandleOptions& options)
+    : logger_(new Logger(options.worker != nullptr
+                         ? options.worker->_GetLogger() : nullptr)),
+      effective_level_(&logger_->GetEffectiveLevelRef()),
+      is_owned_(true) {
+  logger_->SetLevel(options.level);
+  logger_->SetFileDesc(options.fd);
+  logger_->SetOutput(options.output);
+  logger_->SetEngine(options.engine);
+  if (!options.format_str.empty()) logger_->SetFormatStr(options.format_str);
+}
+
+LogHandle::LogHandle(Logger* logger)
+    : logger_(logger),
+      effective_level_(&logger->GetEffectiveLevelRef()),
+      is_owned_(false) {}
+
+LogHandle::~LogHandle() {
+  if (!is_owned_) return;
+  logger_->Shutdown();
+  delete logger_;
+}
+
+LogHandle& LogHandle::Default() {
+  static LogHandle handle(&Logger::instance());
+  return handle;
+}
+
+void LogHandle::SetLevel(LogLevel level) noexcept {
+  logger_->SetLevel(level);
+}
+
+int LogHandle::GetLevel() const noexcept {
+  return logger_->GetLevel();
+}
+
+void LogHandle::SetFormatStr(const std::string& format_str) noexcept {
+  logger_->SetFormatStr(format_str);
+}
+
+std::string LogHandle::GetFormatStr() const noexcept {
+  return logger_->GetFormatStr();
+}
+
+void LogHandle::SetFileDesc(FILE* fd) noexcept {
+  logger_->SetFileDesc(fd);
+}
+
+FILE* LogHandle::GetFileDesc() const noexcept {
+  return logger_->GetFileDesc();
+}
+
+void LogHandle::SetOutput(LogOutput output) noexcept {
+  logger_->SetOutput(output);
+}
+
+LogOutput LogHandle::GetOutput() const noexcept {
+  return logger_->GetOutput();
+}
+
+void LogHandle::SetColored(bool is_colored) noexcept {
+  logger_->SetColored(is_colored);
+}
+
+void LogHandle::SetPressureLimits(const LogPressureLimits& limits) noexcept {
+  logger_->SetPressureLimits(limits);
+}
+
+void LogHandle::SetStallPolicy(const LogStallPolicy& policy) noexcept {
+  logger_->SetStallPolicy(policy);
+}
+
+void LogHandle::SetStatsInterval(std::chrono::milliseconds interval) noexcept {
+  logger_->SetStatsInterval(interval);
+}
+
+void LogHandle::Flush() {
+  logger_->Flush();
+}
+
+LogStats LogHandle::GetStats() const {
+  return logger_->GetStats();
+}
+
+}  // namespace yeti
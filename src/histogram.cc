@@ -0,0 +1,101 @@
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+#include <algorithm>
+#include <cstdint>
+
+#include <src/histogram.h>
+
+namespace yeti {
+
+LatencyHistogram::LatencyHistogram() : max_(0) {
+  for (auto& count : counts_) {
+    count.store(0, std::memory_order_relaxed);
+  }
+}
+
+int LatencyHistogram::GetBucket(std::uint64_t value) noexcept {
+  if (value < static_cast<std::uint64_t>(kSubBucketCount)) {
+    return static_cast<int>(value);
+  }
+  const int exponent = 63 - __builtin_clzll(value);
+  if (exponent > kMaxExponent) return kBucketCount - 1;
+  const int shift = exponent - kSubBucketBits;
+  return (shift + 1) * kSubBucketCount +
+         static_cast<int>((value >> shift) & (kSubBucketCount - 1));
+}
+
+std::uint64_t LatencyHistogram::GetUpperBound(int bucket) noexcept {
+  if (bucket < kSubBucketCount) return bucket;
+  const int shift = bucket / kSubBucketCount - 1;
+  const std::uint64_t lower =
+      static_cast<std::uint64_t>(kSubBucketCount + bucket % kSubBucketCount)
+      << shift;
+  return lower + (std::uint64_t(1) << shift) - 1;
+}
+
+void LatencyHistogram::Add(std::int64_t nanos) noexcept {
+  const std::uint64_t value = nanos > 0 ? nanos : 0;
+  counts_[GetBucket(value)].fetch_add(1, std::memory_order_relaxed);
+  std::uint64_t max = max_.load(std::memory_order_relaxed);
+  while (value > max &&
+         !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+  }
+}
+
+LogLatency LatencyHistogram::GetLatency() const noexcept {
+  std::array<std::uint64_t, kBucketCount> counts;
+  LogLatency latency = LogLatency();
+  for (int bucket = 0; bucket < kBucketCount; ++bucket) {
+    counts[bucket] = counts_[bucket].load(std::memory_order_relaxed);
+    latency.count += counts[bucket];
+  }
+  if (latency.count == 0) return latency;
+  const std::uint64_t max = max_.load(std::memory_order_relaxed);
+
+  // value of percentile is the highest value of its bucket
+  const double kPercentiles[] = { 0.5, 0.99, 0.999 };
+  std::chrono::nanoseconds* values[] = {
+    &latency.p50, &latency.p99, &latency.p999
+  };
+  std::uint64_t below = 0;
+  int bucket = 0;
+  for (int i = 0; i < 3; ++i) {
+    std::uint64_t rank = static_cast<std::uint64_t>(
+        kPercentiles[i] * latency.count + 0.5);
+    rank = std::max<std::uint64_t>(rank, 1);
+    while (bucket < kBucketCount - 1 && below + counts[bucket] < rank) {
+      below += counts[bucket++];
+    }
+    *values[i] = std::chrono::nanoseconds(
+        std::min(GetUpperBound(bucket), max));
+  }
+  latency.max = std::chrono::nanoseconds(max);
+  return latency;
+}
+
+}  // namespace yeti
@@ -0,0 +1,74 @@
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+#ifndef INC_YETI_HISTOGRAM_H_
+#define INC_YETI_HISTOGRAM_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <yeti/yeti.h>
+
+namespace yeti {
+
+/**
+ * @brief Lock-free histogram of durations in nanoseconds.
+ *
+ * Like HDR histogram, every power of two is split into kSubBucketCount
+ * linear buckets, so percentiles are reported with relative error below
+ * 1/kSubBucketCount for any duration from nanoseconds up to minutes. Values
+ * are added concurrently with relaxed atomics.
+ */
+class LatencyHistogram {
+ public:
+  LatencyHistogram();
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+  /** @brief Adds duration (negative one is counted as zero). */
+  void Add(std::int64_t nanos) noexcept;
+
+  /** @brief Returns percentiles of added durations. */
+  LogLatency GetLatency() const noexcept;
+
+ private:
+  static const int kSubBucketBits = 5;
+  static const int kSubBucketCount = 1 << kSubBucketBits;
+  static const int kMaxExponent = 40;  // longer durations share last bucket
+  static const int kBucketCount =
+      (kMaxExponent - kSubBucketBits + 2) * kSubBucketCount;
+
+  static int GetBucket(std::uint64_t value) noexcept;
+  static std::uint64_t GetUpperBound(int bucket) noexcept;
+
+  std::array<std::atomic<std::uint64_t>, kBucketCount> counts_;
+  std::atomic<std::uint64_t> max_;
+};
+
+}  // namespace yeti
+
+#endif  // INC_YETI_HISTOGRAM_H_
@@ -0,0 +1,130 @@
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include <src/log_config.h>
+
+namespace yeti {
+
+namespace {
+
+struct Keyword {
+  const char* name;
+  LogFormatPiece::Field field;
+};
+
+const Keyword kKeywords[] = {
+  { "%(LEVEL)", LogFormatPiece::kLevel },
+  { "%(FILENAME)", LogFormatPiece::kFilename },
+  { "%(FUNCNAME)", LogFormatPiece::kFuncname },
+  { "%(CATEGORY)", LogFormatPiece::kCategory },
+  { "%(MSG)", LogFormatPiece::kMsg },
+  { "%(PID)", LogFormatPiece::kPid },
+  { "%(TID)", LogFormatPiece::kTid },
+  { "%(DATE)", LogFormatPiece::kDate },
+  { "%(TIME)", LogFormatPiece::kTime },
+  { "%(LINE)", LogFormatPiece::kLine },
+  { "%(MSG_ID)", LogFormatPiece::kMsgId }
+};
+
+// %(CTX:key) is value of key in context of thread
+const char kContextPrefix[] = "%(CTX:";
+
+void AppendText(const std::string& text, std::size_t pos, std::size_t len,
+                std::vector<LogFormatPiece>* pieces) {
+  if (len == 0) return;
+  if (pieces->empty() || pieces->back().field != LogFormatPiece::kText) {
+    pieces->push_back(LogFormatPiece{LogFormatPiece::kText, std::string()});
+  }
+  pieces->back().text.append(text, pos, len);
+}
+
+}  // namespace
+
+LogConfig::LogConfig()
+    : fd(stderr),
+      output(LogOutput::LOG_OUTPUT_TEXT),
+      is_colored(true),
+      pressure_limits{0, 0, std::chrono::milliseconds(0),
+                      std::chrono::milliseconds(0), LogLevel::LOG_LEVEL_INFO},
+      stall_policy{std::chrono::milliseconds(0),
+                   std::chrono::milliseconds(1000), nullptr,
+                   LogLevel::LOG_LEVEL_WARNING} {
+  SetFormatStr("[%(LEVEL)] %(FILENAME): %(LINE): %(MSG)");
+}
+
+void LogConfig::SetFormatStr(const std::string& format_str) {
+  this->format_str = format_str;
+  format.clear();
+  std::size_t text_pos = 0;
+  std::size_t pos = 0;
+  while ((pos = format_str.find("%(", pos)) != std::string::npos) {
+    std::size_t end = format_str.find(')', pos);
+    if (end == std::string::npos) break;
+    const std::size_t len = end - pos + 1;
+
+    LogFormatPiece piece{LogFormatPiece::kText, std::string()};
+    if (format_str.compare(pos, sizeof(kContextPrefix) - 1,
+                           kContextPrefix) == 0) {
+      std::size_t key_pos = pos + sizeof(kContextPrefix) - 1;
+      piece.field = LogFormatPiece::kContext;
+      piece.text = format_str.substr(key_pos, end - key_pos);
+    } else {
+      for (const Keyword& keyword : kKeywords) {
+        if (std::strlen(keyword.name) == len &&
+            format_str.compare(pos, len, keyword.name) == 0) {
+          piece.field = keyword.field;
+          break;
+        }
+      }
+    }
+    if (piece.field == LogFormatPiece::kText) {
+      // unknown keyword is written as is
+      pos += 2;
+      continue;
+    }
+    AppendText(format_str, text_pos, pos - text_pos, &format);
+    format.push_back(std::move(piece));
+    pos = text_pos = end + 1;
+  }
+  AppendText(format_str, text_pos, format_str.size() - text_pos, &format);
+}
+
+std::chrono::milliseconds LogConfig::GetDedupWindow(FILE* fd) const {
+  auto it = dedup_windows.find(fd);
+  return it != dedup_windows.end() ? it->second
+                                   : std::chrono::milliseconds(0);
+}
+
+bool LogConfig::IsSanitized(FILE* fd) const {
+  return sanitized_fds.count(fd) > 0;
+}
+
+}  // namespace yeti
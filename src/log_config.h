@@ -0,0 +1,88 @@
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+#ifndef INC_YETI_LOG_CONFIG_H_
+#define INC_YETI_LOG_CONFIG_H_
+
+#include <cstdio>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include <yeti/yeti.h>
+
+namespace yeti {
+
+struct TraceSink;
+
+/** @brief Part of log format: literal text or keyword. */
+struct LogFormatPiece {
+  enum Field {
+    kText, kLevel, kFilename, kFuncname, kCategory, kMsg, kContext,
+    kPid, kTid, kDate, kTime, kLine, kMsgId
+  };
+
+  Field field;
+  std::string text;  // literal text or key of %(CTX:key)
+};
+
+/**
+ * @brief Immutable snapshot of logger settings referenced by records.
+ *
+ * Snapshot is never changed after it is published: setters publish a copy
+ * with their changes, and the old snapshot is freed by backend after all
+ * records referencing it are written.
+ */
+struct LogConfig {
+  LogConfig();
+
+  /** @brief Sets format and splits it into pieces. */
+  void SetFormatStr(const std::string& format_str);
+  /** @brief Returns time window to collapse repeated records of sink. */
+  std::chrono::milliseconds GetDedupWindow(FILE* fd) const;
+  /** @brief Returns is escaping of messages written into sink on. */
+  bool IsSanitized(FILE* fd) const;
+
+  std::string format_str;
+  std::vector<LogFormatPiece> format;  // format_str compiled once
+  FILE* fd;
+  // nullptr if spans aren't written as trace events
+  std::shared_ptr<TraceSink> trace;
+  LogOutput output;
+  bool is_colored;
+  std::map<FILE*, std::chrono::milliseconds> dedup_windows;
+  std::set<FILE*> sanitized_fds;
+  // read by backend without locks
+  LogPressureLimits pressure_limits;
+  LogStallPolicy stall_policy;
+};
+
+}  // namespace yeti
+
+#endif  // INC_YETI_LOG_CONFIG_H_
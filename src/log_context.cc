@@ -0,0 +1,123 @@
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include <yeti/yeti.h>
+#include <src/log_context.h>
+
+namespace yeti {
+
+namespace {
+
+struct ContextEntry {
+  std::string key;
+  std::string value;
+};
+
+/** @brief Context of thread: strings of entries keep their capacity. */
+struct ContextStack {
+  std::array<ContextEntry, kLogContextCapacity> entries;
+  std::size_t size = 0;
+  std::size_t lost = 0;  // pushes over capacity
+  std::size_t version = 0;
+  std::size_t snapshot_version = 0;
+  std::shared_ptr<const LogContextSnapshot> snapshot;
+};
+
+ContextStack& GetContextStack() {
+  static thread_local ContextStack stack;
+  return stack;
+}
+
+}  // namespace
+
+LogContext::LogContext(const char* key, const char* value,
+                       std::size_t size) {
+  ContextStack& stack = GetContextStack();
+  if (stack.size == kLogContextCapacity) {
+    ++stack.lost;
+    return;
+  }
+  ContextEntry& entry = stack.entries[stack.size++];
+  entry.key.assign(key);
+  entry.value.assign(value, size);
+  ++stack.version;
+}
+
+LogContext::~LogContext() {
+  ContextStack& stack = GetContextStack();
+  if (stack.lost > 0) {
+    --stack.lost;
+    return;
+  }
+  --stack.size;
+  ++stack.version;
+}
+
+const std::string* LogContextSnapshot::Find(const char* key,
+                                            std::size_t key_len) const {
+  for (const auto& entry : entries) {
+    if (entry.first.size() == key_len &&
+        std::memcmp(entry.first.data(), key, key_len) == 0) {
+      return &entry.second;
+    }
+  }
+  return nullptr;
+}
+
+std::shared_ptr<const LogContextSnapshot> GetLogContextSnapshot() {
+  ContextStack& stack = GetContextStack();
+  if (stack.size == 0) return nullptr;
+  if (stack.snapshot == nullptr || stack.snapshot_version != stack.version) {
+    auto snapshot = std::make_shared<LogContextSnapshot>();
+    snapshot->entries.reserve(stack.size);
+    for (std::size_t i = 0; i < stack.size; ++i) {
+      const ContextEntry& entry = stack.entries[i];
+      auto it = std::find_if(
+          snapshot->entries.begin(), snapshot->entries.end(),
+          [&entry](const std::pair<std::string, std::string>& other) {
+            return other.first == entry.key;
+          });
+      if (it != snapshot->entries.end()) {
+        // inner pair shadows the outer one
+        it->second = entry.value;
+      } else {
+        snapshot->entries.emplace_back(entry.key, entry.value);
+      }
+    }
+    stack.snapshot = std::move(snapshot);
+    stack.snapshot_version = stack.version;
+  }
+  return stack.snapshot;
+}
+
+}  // namespace yeti
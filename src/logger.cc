@@ -25,28 +25,522 @@
 // yeti - C++ lightweight threadsafe logging
 // URL: https://github.com/seninds/yeti.git
 
+#include <sys/stat.h>
+
 #include <cstdlib>
 #include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
 #include <map>
+#include <fstream>
 #include <functional>
+#include <sstream>
 
 #include <src/logger.h>
+#include <src/sanitize.h>
+#include <src/site_profiler.h>
+#include <src/trace.h>
+
+// diagnostics describe logger, so they are written into the logger itself:
+// WRN() and INF() would put records of LogHandle into the default one
+#define _YETI_LOG_SELF(log_level, level_name, color, fmt, ...) { \
+  if (this == &Logger::instance()) { \
+    _YETI_LOG(log_level, level_name, color, fmt, ##__VA_ARGS__); \
+  } else if (log_level <= GetEffectiveLevel()) { \
+    static const LogSite __yeti_site__ = { \
+        log_level, level_name, color, __FILE__, __func__, __LINE__ }; \
+    _LogPrintfTo(this, &__yeti_site__, fmt, ##__VA_ARGS__); \
+  } \
+}
+
+#define _YETI_WRN_SELF(fmt, ...) _YETI_LOG_SELF( \
+    LogLevel::LOG_LEVEL_WARNING, "WRN", YETI_YELLOW, fmt, ##__VA_ARGS__)
+#define _YETI_INF_SELF(fmt, ...) _YETI_LOG_SELF( \
+    LogLevel::LOG_LEVEL_INFO, "INF", YETI_LGREEN, fmt, ##__VA_ARGS__)
 
 namespace yeti {
 
+namespace {
+
+// max number of tasks executed by one producer in combining mode
+const std::size_t kCombiningBatchSize = 128;
+
+// period to drain tasks left by the last combiner in combining mode
+const std::chrono::milliseconds kCombiningTimeout(10);
+
+// max number of tasks executed by backend thread per iteration, so urgent
+// records don't wait for the whole flood of verbose ones
+const std::size_t kBatchSize = 256;
+
+// period to check queue pressure while logging level is degraded
+const std::chrono::milliseconds kPressureTimeout(10);
+
+// period to check whether control file of call sites or config file is
+// modified
+const std::chrono::milliseconds kControlFileTimeout(1000);
+
+// max number of records taken from each record lane per round: higher lanes
+// are drained first, lower lanes still get their share
+const std::size_t kLaneQuota[] = { 64, 16, 4 };
+
+const char* const kLevelNames[] = {
+  "CRITICAL", "ERROR", "WARNING", "INFO", "DEBUG", "TRACE"
+};
+
+std::string Trim(const std::string& str) {
+  std::size_t begin = str.find_first_not_of(" \t\r");
+  if (begin == std::string::npos) return std::string();
+  std::size_t end = str.find_last_not_of(" \t\r");
+  return str.substr(begin, end - begin + 1);
+}
+
+bool ParseBool(const std::string& str, bool* value) {
+  if (str == "on" || str == "true" || str == "yes" || str == "1") {
+    *value = true;
+  } else if (str == "off" || str == "false" || str == "no" || str == "0") {
+    *value = false;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
 void RegAllSignals();
+std::size_t WriteLogRecord(const LogRecord& record, FILE* fd,
+                           const char* msg, const char* fields);
 
-Logger::Logger()
-    : stop_loop_(false),
-      is_colored_(true),
+Logger::Logger(Logger* worker)
+    : queue_size_(0),
+      task_seq_(0),
+      written_counts_(),
+      enqueued_counts_(),
+      peak_queue_size_(0),
+      stats_(),
+      batch_written_(),
+      batch_dropped_(),
+      last_latency_fd_(nullptr),
+      last_sink_latency_(nullptr),
+      stats_interval_(0),
+      stop_loop_(false),
+      is_combining_(false),
+      engine_(LogEngine::LOG_ENGINE_THREAD),
       level_(LogLevel::LOG_LEVEL_INFO),
+      effective_level_(LogLevel::LOG_LEVEL_INFO),
+      capture_level_(LogLevel::LOG_LEVEL_INFO),
+      backtrace_size_(0),
+      backtrace_level_(LogLevel::LOG_LEVEL_TRACE),
+      backtrace_trigger_level_(LogLevel::LOG_LEVEL_ERROR),
+      is_degraded_(false),
+      site_levels_(),
+      level_generation_(1),
+      is_pressured_(false),
       msg_id_(0),
-      format_str_("[%(LEVEL)] %(FILENAME): %(LINE): %(MSG)"),
-      fd_(stderr) {
-  thread_ = std::thread(&Logger::ProcessingLoop, this);
+      config_(new LogConfig()),
+      has_dedup_(false),
+      dedup_([this](const LogRecord& record, const char* msg,
+                    const char* fields) {
+        WriteRecord(record, msg, fields);
+      }),
+      dedup_deadline_(0),
+      control_file_{std::string(), 0, 0},
+      config_file_{std::string(), 0, 0},
+      has_watched_files_(false),
+      config_fd_(nullptr),
+      has_config_sites_(false),
+      worker_(worker),
+      has_attached_(false),
+      has_attached_tasks_(false) {
+  batch_stall_policy_ = config_.load()->stall_policy;
+  SetLevel(LogLevel::LOG_LEVEL_INFO);
+  if (worker != nullptr) {
+    worker->Attach(this);
+  } else {
+    thread_ = std::thread(&Logger::ProcessingLoop, this);
+  }
+}
+
+Logger::~Logger() {
+  if (config_fd_ != nullptr) std::fclose(config_fd_);
+  delete config_.load();
+}
+
+void Logger::SetLevel(LogLevel level) noexcept {
+  std::lock_guard<std::mutex> lock(settings_mutex_);
+  level_ = level;
+  UpdateEffectiveLevel();
+}
+
+void Logger::SetLevels(const std::string& levels) {
+  bool has_level = false;
+  LogLevel level = LogLevel::LOG_LEVEL_INFO;
+  SiteRegistry::CategoryRules rules;
+  std::istringstream input(levels);
+  std::string item;
+  while (std::getline(input, item, ',')) {
+    std::size_t equal = item.find('=');
+    if (equal == std::string::npos) {
+      if (item.find_first_not_of(" \t") == std::string::npos) continue;
+      level = LogLevelFromEnv(item.c_str());
+      has_level = true;
+      continue;
+    }
+    std::size_t begin = item.find_first_not_of(" \t");
+    std::size_t end = item.find_last_not_of(" \t", equal - 1);
+    if (begin >= equal || end == std::string::npos) continue;
+    rules.emplace_back(item.substr(begin, end - begin + 1),
+                       LogLevelFromEnv(item.c_str() + equal + 1));
+  }
+  site_registry_.SetCategoryLevels(rules);
+  if (has_level) SetLevel(level);
+}
+
+void Logger::UpdateEffectiveLevel() {
+  // settings_mutex_ should be locked by caller
+  SiteLevels levels;
+  levels.level = level_;
+  levels.degraded_level = is_degraded_
+      ? static_cast<int>(config_.load()->pressure_limits.degraded_level)
+      : static_cast<int>(LogLevel::LOG_LEVEL_TRACE);
+  levels.backtrace_level = backtrace_size_ > 0 ? backtrace_level_.load() : -1;
+  levels.has_thread_levels = !thread_levels_.empty();
+  levels.min_thread_level = LogLevel::LOG_LEVEL_TRACE;
+  levels.max_thread_level = LogLevel::LOG_LEVEL_CRITICAL;
+  for (const auto& thread_level : thread_levels_) {
+    levels.min_thread_level =
+        std::min(levels.min_thread_level, thread_level.second);
+    levels.max_thread_level =
+        std::max(levels.max_thread_level, thread_level.second);
+  }
+  site_levels_ = levels;
+  effective_level_ = levels.GetEffective(levels.level);
+  capture_level_ = levels.GetCapture(levels.level);
+  // invalidate levels cached by threads
+  ++level_generation_;
+  site_registry_.SetLevels(levels);
+}
+
+void Logger::SetThreadLevel(std::thread::id thread_id, LogLevel level) {
+  std::lock_guard<std::mutex> lock(settings_mutex_);
+  thread_levels_[thread_id] = level;
+  UpdateEffectiveLevel();
+}
+
+void Logger::ResetThreadLevel(std::thread::id thread_id) {
+  std::lock_guard<std::mutex> lock(settings_mutex_);
+  if (thread_levels_.erase(thread_id) > 0) UpdateEffectiveLevel();
+}
+
+int Logger::GetThreadLevel(std::thread::id thread_id) const {
+  std::lock_guard<std::mutex> lock(settings_mutex_);
+  auto it = thread_levels_.find(thread_id);
+  return it != thread_levels_.end() ? it->second : level_.load();
+}
+
+const Logger::ThreadLevels& Logger::GetCurrentThreadLevels() {
+  static thread_local ThreadLevels thread = ThreadLevels();
+  if (thread.generation != level_generation_.load()) {
+    std::lock_guard<std::mutex> lock(settings_mutex_);
+    auto it = thread_levels_.find(std::this_thread::get_id());
+    thread.generation = level_generation_;
+    thread.levels = site_levels_;
+    thread.has_override = it != thread_levels_.end();
+    thread.level = thread.has_override ? it->second : 0;
+  }
+  return thread;
+}
+
+int Logger::ResolveSite(const LogSite* site, const char* format,
+                        bool is_counted) {
+  int action = site->action.load(std::memory_order_relaxed);
+  if (action == _kSiteUnresolved) {
+    action = site_registry_.Register(site, format);
+  }
+  // actions of profiled sites are negated to get here from macros
+  const bool is_profiled = action < 0;
+  if (is_profiled) action = -action;
+
+  if (action == _kSiteCheck) {
+    // level of thread overrides levels of categories as well as the global
+    // one
+    const ThreadLevels& thread = GetCurrentThreadLevels();
+    const int level = thread.has_override ? thread.level
+        : site->category != nullptr ? site->category->GetLevel()
+        : thread.levels.level;
+    action = thread.levels.GetEffective(level) >= site->level ? _kSiteLog
+        : thread.levels.GetCapture(level) >= site->level ? _kSiteCapture
+        : _kSiteOff;
+  }
+  if (is_profiled && is_counted) {
+    SiteProfiler::instance().AddCall(site, action != _kSiteLog);
+  }
+  return action;
+}
+
+bool Logger::ApplySiteControl(const std::string& commands) {
+  SiteRegistry::Rules rules;
+  bool is_valid = ParseSiteControl(commands, &rules);
+  for (const auto& rule : rules) {
+    site_registry_.SetMode(rule.first, rule.second);
+  }
+  return is_valid;
+}
+
+bool Logger::SetSiteControlFile(const std::string& path) {
+  SetWatchedFile(&control_file_, path);
+  return path.empty() || LoadSiteControlFile(true);
+}
+
+bool Logger::SetConfigFile(const std::string& path) {
+  SetWatchedFile(&config_file_, path);
+  return path.empty() || LoadConfigFile(true);
+}
+
+void Logger::SetWatchedFile(WatchedFile* file, const std::string& path) {
+  {
+    std::lock_guard<std::mutex> lock(settings_mutex_);
+    file->path = path;
+    has_watched_files_ =
+        !control_file_.path.empty() || !config_file_.path.empty();
+  }
+  // wake backend up to start checking file periodically
+  EnqueueTask([] {});
+}
+
+bool Logger::ReadWatchedFile(WatchedFile* file, bool is_forced,
+                             std::string* content) {
+  std::string path;
+  {
+    std::lock_guard<std::mutex> lock(settings_mutex_);
+    path = file->path;
+  }
+  struct stat info;
+  if (path.empty() || stat(path.c_str(), &info) != 0) return false;
+  std::int64_t mtime = static_cast<std::int64_t>(info.st_mtim.tv_sec) *
+                       1000000000 + info.st_mtim.tv_nsec;
+  {
+    std::lock_guard<std::mutex> lock(settings_mutex_);
+    if (!is_forced && mtime == file->mtime && info.st_size == file->size) {
+      return false;
+    }
+    file->mtime = mtime;
+    file->size = info.st_size;
+  }
+
+  std::ifstream input(path);
+  if (!input) return false;
+  std::stringstream buffer;
+  buffer << input.rdbuf();
+  *content = buffer.str();
+  return true;
+}
+
+bool Logger::LoadSiteControlFile(bool is_forced) {
+  std::string commands;
+  if (!ReadWatchedFile(&control_file_, is_forced, &commands)) return false;
+  // rules of file replace all rules
+  SiteRegistry::Rules rules;
+  ParseSiteControl(commands, &rules);
+  site_registry_.SetModes(rules);
+  return true;
+}
+
+bool Logger::LoadConfigFile(bool is_forced) {
+  std::string config;
+  if (!ReadWatchedFile(&config_file_, is_forced, &config)) return false;
+  ApplyConfig(config);
+  return true;
+}
+
+void Logger::PollWatchedFiles() {
+  // backend only
+  if (!has_watched_files_) return;
+  auto now = std::chrono::steady_clock::now();
+  if (now - watched_files_check_time_ < kControlFileTimeout) return;
+  watched_files_check_time_ = now;
+
+  LoadSiteControlFile(false);
+  LoadConfigFile(false);
+}
+
+FILE* Logger::OpenConfigSink(const std::string& path) {
+  if (path == "stderr") return stderr;
+  if (path == "stdout") return stdout;
+  {
+    // file is reopened only if config names another one
+    std::lock_guard<std::mutex> lock(settings_mutex_);
+    if (config_fd_ != nullptr && path == config_fd_path_) return config_fd_;
+  }
+  return std::fopen(path.c_str(), "a");
+}
+
+bool Logger::ApplyConfig(const std::string& config) {
+  bool is_valid = true;
+  std::map<std::string, std::string> values;
+  std::string site_commands;
+  bool has_sites = false;
+  std::istringstream input(config);
+  std::string line;
+  while (std::getline(input, line)) {
+    std::size_t begin = line.find_first_not_of(" \t\r");
+    if (begin == std::string::npos || line[begin] == '#') continue;
+    std::size_t equal = line.find('=', begin);
+    if (equal == std::string::npos) {
+      is_valid = false;
+      continue;
+    }
+    const std::string key = Trim(line.substr(begin, equal - begin));
+    const std::string value = Trim(line.substr(equal + 1));
+    if (key == "site") {
+      site_commands.append(value).push_back('\n');
+      has_sites = true;
+    } else if (key == "level" || key == "format" || key == "output" ||
+               key == "colored" || key == "file" || key == "dedup" ||
+               key == "sanitize" || key == "profile") {
+      values[key] = value;
+    } else {
+      is_valid = false;
+    }
+  }
+
+  // settings of records are checked before anything is applied
+  auto has = [&values](const char* key) { return values.count(key) > 0; };
+  LogOutput output = LogOutput::LOG_OUTPUT_TEXT;
+  if (has("output")) {
+    if (values["output"] == "json") {
+      output = LogOutput::LOG_OUTPUT_JSON;
+    } else if (values["output"] != "text") {
+      is_valid = false;
+      values.erase("output");
+    }
+  }
+  bool is_colored = false;
+  if (has("colored") && !ParseBool(values["colored"], &is_colored)) {
+    is_valid = false;
+    values.erase("colored");
+  }
+  bool is_sanitized = false;
+  if (has("sanitize") && !ParseBool(values["sanitize"], &is_sanitized)) {
+    is_valid = false;
+    values.erase("sanitize");
+  }
+  bool is_profiling = false;
+  if (has("profile") && !ParseBool(values["profile"], &is_profiling)) {
+    is_valid = false;
+    values.erase("profile");
+  }
+  std::chrono::milliseconds window(0);
+  if (has("dedup")) {
+    char* end = nullptr;
+    long long count = std::strtoll(values["dedup"].c_str(), &end, 10);
+    if (end == values["dedup"].c_str() || *end != '\0' || count < 0) {
+      is_valid = false;
+      values.erase("dedup");
+    }
+    window = std::chrono::milliseconds(count);
+  }
+  FILE* fd = nullptr;
+  if (has("file")) {
+    fd = OpenConfigSink(values["file"]);
+    if (fd == nullptr) {
+      is_valid = false;
+      values.erase("file");
+    }
+  }
+
+  // format and sinks are changed at once by one snapshot
+  FILE* sink = nullptr;
+  UpdateConfig([&](LogConfig* config) {
+    if (has("format")) config->SetFormatStr(values["format"]);
+    if (has("output")) config->output = output;
+    if (has("colored")) config->is_colored = is_colored;
+    if (fd != nullptr) config->fd = fd;
+    sink = config->fd;
+    if (has("dedup")) {
+      if (window.count() > 0) {
+        config->dedup_windows[sink] = window;
+      } else {
+        config->dedup_windows.erase(sink);
+      }
+      has_dedup_ = !config->dedup_windows.empty();
+    }
+    if (has("sanitize")) {
+      if (is_sanitized) {
+        config->sanitized_fds.insert(sink);
+      } else {
+        config->sanitized_fds.erase(sink);
+      }
+    }
+  });
+  if (has("dedup") && window.count() == 0) {
+    // write summary of the last run
+    EnqueueTask([this, sink] { dedup_.Flush(sink); });
+  }
+  if (fd != nullptr) {
+    FILE* old_fd = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(settings_mutex_);
+      if (fd != config_fd_) {
+        old_fd = config_fd_;
+        const bool is_std = fd == stderr || fd == stdout;
+        config_fd_ = is_std ? nullptr : fd;
+        config_fd_path_ = is_std ? std::string() : values["file"];
+      }
+    }
+    // file opened by previous config is closed after its records
+    if (old_fd != nullptr) CloseFileDesc(old_fd);
+  }
 
-  // check environment variable to set log level
-  level_ = Logger::LogLevelFromEnv(std::getenv("YETI_LOG_LEVEL"));
+  if (has("level")) SetLevels(values["level"]);
+  if (has("profile")) SetSiteProfiling(is_profiling);
+  bool had_sites = false;
+  {
+    std::lock_guard<std::mutex> lock(settings_mutex_);
+    had_sites = has_config_sites_;
+    has_config_sites_ = has_sites;
+  }
+  if (has_sites || had_sites) {
+    // site commands of config replace all rules like control file does
+    SiteRegistry::Rules rules;
+    is_valid = ParseSiteControl(site_commands, &rules) && is_valid;
+    site_registry_.SetModes(rules);
+  }
+  return is_valid;
+}
+
+void Logger::SetBacktrace(std::size_t size, LogLevel capture_level,
+                          LogLevel trigger_level) noexcept {
+  std::lock_guard<std::mutex> lock(settings_mutex_);
+  backtrace_size_ = size;
+  backtrace_level_ = capture_level;
+  backtrace_trigger_level_ = trigger_level;
+  UpdateEffectiveLevel();
+}
+
+void Logger::SetPressureLimits(const LogPressureLimits& limits) noexcept {
+  UpdateConfig([&limits](LogConfig* config) {
+    config->pressure_limits = limits;
+  });
+  std::lock_guard<std::mutex> lock(settings_mutex_);
+  UpdateEffectiveLevel();
+}
+
+LogPressureLimits Logger::GetPressureLimits() const noexcept {
+  std::lock_guard<std::mutex> lock(settings_mutex_);
+  return config_.load()->pressure_limits;
+}
+
+void Logger::SetStallPolicy(const LogStallPolicy& policy) noexcept {
+  UpdateConfig([&policy](LogConfig* config) {
+    config->stall_policy = policy;
+  });
+}
+
+LogStallPolicy Logger::GetStallPolicy() const noexcept {
+  std::lock_guard<std::mutex> lock(settings_mutex_);
+  return config_.load()->stall_policy;
 }
 
 LogLevel Logger::LogLevelFromEnv(const char* var) {
@@ -89,6 +583,12 @@ Logger& Logger::instance() {
 
   static std::atomic<bool> is_registered(false);
   if (!is_registered.exchange(true)) {
+    // check environment variable to set log levels
+    const char* levels = std::getenv("YETI_LOG_LEVEL");
+    if (levels != nullptr) logger.SetLevels(levels);
+    // settings of config file override environment
+    const char* config = std::getenv("YETI_CONFIG");
+    if (config != nullptr) logger.SetConfigFile(config);
     RegAllSignals();
     std::atexit([]() { yeti::Logger::instance().Shutdown(); });
   }
@@ -96,72 +596,908 @@ Logger& Logger::instance() {
   return logger;
 }
 
+void Logger::UpdateConfig(const std::function<void(LogConfig*)>& update) {
+  // setters are serialized by settings_mutex_, so nobody else replaces
+  // current snapshot while it is copied
+  std::unique_lock<std::mutex> settings_lock(settings_mutex_);
+  std::unique_ptr<LogConfig> config(new LogConfig(*config_.load()));
+  update(config.get());
+
+  // snapshot is replaced under queue_mutex_ which producers read it under,
+  // so records enqueued after control task below never reference old one
+  std::unique_lock<std::mutex> queue_lock(queue_mutex_);
+  const LogConfig* new_config = config.release();
+  const LogConfig* old_config = config_.exchange(new_config);
+  settings_lock.unlock();
+  // new snapshot is retired by the next task, so it outlives this one
+  control_lane_.push(Task{task_seq_++,
+                          std::chrono::high_resolution_clock::now(),
+                          [this, old_config, new_config] {
+                            RetireConfig(old_config, new_config);
+                          }});
+  ++queue_size_;
+  NotifyBackend(&queue_lock);
+}
+
+void Logger::RetireConfig(const LogConfig* config,
+                          const LogConfig* replacement) {
+  // backend only: all records referencing config are written by now, but
+  // summaries of repeated records may still reference it
+  dedup_.ReplaceConfig(config, replacement);
+  delete config;
+}
+
+void Logger::SetOutput(LogOutput output) noexcept {
+  UpdateConfig([output](LogConfig* config) { config->output = output; });
+}
+
+LogOutput Logger::GetOutput() const noexcept {
+  std::lock_guard<std::mutex> lock(settings_mutex_);
+  return config_.load()->output;
+}
+
+void Logger::SetTraceFile(FILE* fd) noexcept {
+  UpdateConfig([fd](LogConfig* config) {
+    // the same file continues its array, another one opens new array
+    if (fd == nullptr) {
+      config->trace.reset();
+    } else if (config->trace == nullptr || config->trace->fd != fd) {
+      config->trace = std::make_shared<TraceSink>(fd);
+    }
+  });
+}
+
+FILE* Logger::GetTraceFile() const noexcept {
+  std::lock_guard<std::mutex> lock(settings_mutex_);
+  const LogConfig* config = config_.load();
+  return config->trace != nullptr ? config->trace->fd : nullptr;
+}
+
+void Logger::SetColored(bool is_colored) noexcept {
+  UpdateConfig([is_colored](LogConfig* config) {
+    config->is_colored = is_colored;
+  });
+}
+
+bool Logger::IsColored() const noexcept {
+  std::lock_guard<std::mutex> lock(settings_mutex_);
+  return config_.load()->is_colored;
+}
+
+void Logger::SetFileDesc(FILE* fd) noexcept {
+  UpdateConfig([fd](LogConfig* config) { config->fd = fd; });
+}
+
+FILE* Logger::GetFileDesc() const noexcept {
+  std::lock_guard<std::mutex> lock(settings_mutex_);
+  return config_.load()->fd;
+}
+
 void Logger::CloseFileDesc(FILE* fd) {
   if (fd == nullptr) {
-    fd = fd_;
+    fd = GetFileDesc();
   }
   if (fd != stderr && fd != stdout && fd != stdin) {
-    auto close_func = [fd] { std::fclose(fd); };
+    auto close_func = [this, fd] {
+      dedup_.Flush(fd);
+      std::fclose(fd);
+      // the same address may be given to another file
+      sink_stalls_.erase(fd);
+    };
     this->EnqueueTask(close_func);
   }
 }
 
+void Logger::SetDedupWindow(FILE* fd, std::chrono::milliseconds window) {
+  UpdateConfig([this, fd, window](LogConfig* config) {
+    if (window.count() > 0) {
+      config->dedup_windows[fd] = window;
+    } else {
+      config->dedup_windows.erase(fd);
+    }
+    has_dedup_ = !config->dedup_windows.empty();
+  });
+  if (window.count() == 0) {
+    // write summary of the last run
+    this->EnqueueTask([this, fd] { dedup_.Flush(fd); });
+  }
+}
+
+std::chrono::milliseconds Logger::GetDedupWindow(FILE* fd) const {
+  std::lock_guard<std::mutex> lock(settings_mutex_);
+  return config_.load()->GetDedupWindow(fd);
+}
+
+bool Logger::IsRepeated(const LogRecord& record) {
+  auto window = record.config->GetDedupWindow(record.fd);
+  if (window.count() == 0) return false;
+  return dedup_.IsRepeated(record, window);
+}
+
+void Logger::SetSanitized(FILE* fd, bool is_sanitized) {
+  UpdateConfig([fd, is_sanitized](LogConfig* config) {
+    if (is_sanitized) {
+      config->sanitized_fds.insert(fd);
+    } else {
+      config->sanitized_fds.erase(fd);
+    }
+  });
+}
+
+bool Logger::IsSanitized(FILE* fd) const {
+  std::lock_guard<std::mutex> lock(settings_mutex_);
+  return config_.load()->IsSanitized(fd);
+}
+
 void Logger::EnqueueTask(const std::function<void()>& queue_func) {
+  std::unique_lock<std::mutex> queue_lock(queue_mutex_);
+  control_lane_.push(Task{task_seq_++,
+                          std::chrono::high_resolution_clock::now(),
+                          queue_func});
+  peak_queue_size_ = std::max(peak_queue_size_, ++queue_size_);
+  NotifyBackend(&queue_lock);
+}
+
+Logger::Lane Logger::GetLane(LogLevel level) noexcept {
+  switch (level) {
+    case LogLevel::LOG_LEVEL_CRITICAL:
+    case LogLevel::LOG_LEVEL_ERROR:
+      return kUrgentLane;
+    case LogLevel::LOG_LEVEL_WARNING:
+    case LogLevel::LOG_LEVEL_INFO:
+      return kNormalLane;
+    default:
+      return kVerboseLane;
+  }
+}
+
+LogRecord Logger::MakeHeader(
+    const LogSite* site, std::size_t msg_id,
+    std::chrono::high_resolution_clock::time_point time,
+    std::shared_ptr<const LogContextSnapshot> context) {
+  LogRecord header;
+  header.site = site;
+  header.seq = 0;
+  header.msg_id = msg_id;
+  header.time = time;
+  header.tid = std::this_thread::get_id();
+  header.fd = nullptr;
+  header.config = nullptr;
+  header.context = std::move(context);
+  header.pid = getpid();
+  header.msg_len = 0;
+  header.size = 0;
+  header.is_committed = false;
+  header.is_encoded = false;
+  return header;
+}
+
+void Logger::EnqueueRecord(const LogSite* site, std::size_t msg_id,
+                           std::chrono::high_resolution_clock::time_point time,
+                           const char* msg, std::size_t msg_len,
+                           bool is_encoded) {
+  LogRecord header =
+      MakeHeader(site, msg_id, time, GetLogContextSnapshot());
+  header.is_encoded = is_encoded;
+  EnqueueRecord(std::move(header), GetLane(site->level), msg, msg_len);
+}
+
+LogRecord* Logger::ReserveRecord(
+    const LogSite* site, std::size_t msg_id,
+    std::chrono::high_resolution_clock::time_point time,
+    std::size_t msg_len, bool is_encoded) {
+  LogRecord header =
+      MakeHeader(site, msg_id, time, GetLogContextSnapshot());
+  header.is_encoded = is_encoded;
+  return ReserveRecord(std::move(header), GetLane(site->level), msg_len);
+}
+
+void Logger::EnqueueBacktrace(const BacktraceRecord& record,
+                              const LogSite* trigger) {
+  LogRecord header = MakeHeader(record.site, record.msg_id, record.time,
+                                record.context);
+  const Lane lane = GetLane(trigger->level);
+  if (record.is_encoded) {
+    header.is_encoded = true;
+    EnqueueRecord(std::move(header), lane, record.args, record.args_size);
+    return;
+  }
+
+  auto format = [&record](char* msg, std::size_t size) {
+    if (record.format == nullptr) {
+      return std::snprintf(msg, size, "%s", record.args);
+    }
+    return record.format(record.args, msg, size);
+  };
+  EnqueueFormatted(std::move(header), lane, format);
+}
+
+void Logger::EnqueueRecord(LogRecord&& header, Lane lane, const char* msg,
+                           std::size_t msg_len) {
+  const int level = header.site->level;
+  std::unique_lock<std::mutex> queue_lock(queue_mutex_);
+  header.config = config_.load(std::memory_order_relaxed);
+  header.fd = header.config->fd;
+  header.seq = task_seq_++;
+  header.is_committed = true;
+  LogRecord* record = record_lanes_[lane].Reserve(
+      std::move(header), msg_len, &chunk_pool_);
+  std::memcpy(record->msg(), msg, msg_len);
+  record->msg()[msg_len] = '\0';
+  ++enqueued_counts_[level];
+  peak_queue_size_ = std::max(peak_queue_size_, ++queue_size_);
+  NotifyBackend(&queue_lock);
+}
+
+LogRecord* Logger::ReserveRecord(LogRecord&& header, Lane lane,
+                                 std::size_t msg_len) {
+  const int level = header.site->level;
   std::lock_guard<std::mutex> queue_lock(queue_mutex_);
-  queue_.push(queue_func);
+  header.config = config_.load(std::memory_order_relaxed);
+  header.fd = header.config->fd;
+  header.seq = task_seq_++;
+  ++enqueued_counts_[level];
+  peak_queue_size_ = std::max(peak_queue_size_, ++queue_size_);
+  return record_lanes_[lane].Reserve(std::move(header), msg_len, &chunk_pool_);
+}
+
+void Logger::CommitRecord(LogRecord* record) {
+  std::unique_lock<std::mutex> queue_lock(queue_mutex_);
+  record->msg()[record->msg_len] = '\0';
+  record->is_committed = true;
+  NotifyBackend(&queue_lock);
+}
+
+void Logger::NotifyBackend(std::unique_lock<std::mutex>* queue_lock) {
+  if (engine_ == LogEngine::LOG_ENGINE_THREAD) {
+    Logger* worker = worker_;
+    if (worker == nullptr) {
+      cv_.notify_one();
+      return;
+    }
+    // queue of worker is locked after this one (the same order as in
+    // processing loop of worker)
+    queue_lock->unlock();
+    worker->WakeUp();
+    return;
+  }
+  queue_lock->unlock();
+
+  // whoever finds combiner free writes pending records for everyone
+  Combine(kCombiningBatchSize);
+}
+
+void Logger::WakeUp() {
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    has_attached_tasks_ = true;
+  }
+  cv_.notify_one();
+}
+
+void Logger::Attach(Logger* logger) {
+  std::lock_guard<std::mutex> lock(attached_mutex_);
+  attached_.push_back(logger);
+  has_attached_ = true;
+}
+
+void Logger::Detach(Logger* logger) {
+  std::lock_guard<std::mutex> lock(attached_mutex_);
+  attached_.erase(std::remove(attached_.begin(), attached_.end(), logger),
+                  attached_.end());
+  has_attached_ = !attached_.empty();
+}
+
+void Logger::DrainAttached() {
+  // backend only
+  if (!has_attached_) return;
+  std::lock_guard<std::mutex> lock(attached_mutex_);
+  for (Logger* logger : attached_) {
+    logger->Combine(std::numeric_limits<std::size_t>::max());
+  }
+}
+
+void Logger::SetEngine(LogEngine engine) noexcept {
+  {
+    // backend checks engine under queue_mutex_ before it waits, so wakeup
+    // isn't lost between the check and the wait
+    std::lock_guard<std::mutex> queue_lock(queue_mutex_);
+    engine_ = engine;
+  }
   cv_.notify_one();
 }
 
+bool Logger::Combine(std::size_t max_tasks) {
+  if (is_combining_.exchange(true)) {
+    return false;
+  }
+
+  // lock order is the same as in processing loop
+  Pressure pressure;
+  std::vector<StallEvent> stall_events;
+  {
+    std::unique_lock<std::mutex> queue_lock(queue_mutex_);
+    std::lock_guard<std::mutex> exec_lock(exec_list_mutex_);
+    std::size_t depth = queue_size_ + TakeTasks(max_tasks);
+    queue_lock.unlock();
+    pressure = UpdatePressure(depth);
+    ExecTasks();
+    FlushRepeats();
+    stall_events.swap(stall_events_);
+  }
+
+  is_combining_ = false;
+  ReportPressure(pressure);
+  ReportStalls(stall_events);
+  return true;
+}
+
+std::size_t Logger::GetMinRecordSeq() const {
+  // reserved records which are not committed yet are taken into account
+  std::size_t min_seq = std::numeric_limits<std::size_t>::max();
+  for (const RecordQueue& lane : record_lanes_) {
+    const LogRecord* record = lane.front();
+    if (record != nullptr) {
+      min_seq = std::min(min_seq, record->seq);
+    }
+  }
+  return min_seq;
+}
+
+bool Logger::HasReadyTasks() const {
+  // queue_mutex_ should be locked by caller
+  for (const RecordQueue& lane : record_lanes_) {
+    const LogRecord* record = lane.front();
+    if (record != nullptr && record->is_committed) return true;
+  }
+  return !control_lane_.empty() &&
+         control_lane_.front().seq < GetMinRecordSeq();
+}
+
+void Logger::ReleaseRecords() {
+  // queue_mutex_ and exec_list_mutex_ should be locked by caller
+  for (int lane = kUrgentLane; lane < kControlLane; ++lane) {
+    for (; written_counts_[lane] > 0; --written_counts_[lane]) {
+      record_lanes_[lane].Release(&chunk_pool_);
+    }
+  }
+}
+
+std::size_t Logger::TakeTasks(std::size_t max_tasks) {
+  // queue_mutex_ and exec_list_mutex_ should be locked by caller
+  ReleaseRecords();
+
+  std::size_t taken = 0;
+  auto update_oldest_time = [this, &taken](
+      std::chrono::high_resolution_clock::time_point time) {
+    if (taken == 0 || time < oldest_task_time_) {
+      oldest_task_time_ = time;
+    }
+    --queue_size_;
+    ++taken;
+  };
+
+  std::size_t round_taken;
+  do {
+    round_taken = taken;
+
+    // control tasks are barriers: they wait for all records which were
+    // enqueued before them
+    while (taken < max_tasks && !control_lane_.empty() &&
+           control_lane_.front().seq < GetMinRecordSeq()) {
+      update_oldest_time(control_lane_.front().time);
+      exec_list_.push_back(ExecTask{kControlLane, nullptr,
+                                    std::move(control_lane_.front().func)});
+      control_lane_.pop();
+    }
+
+    for (int lane = kUrgentLane; lane < kControlLane; ++lane) {
+      RecordQueue& records = record_lanes_[lane];
+      for (std::size_t quota = kLaneQuota[lane]; quota > 0 &&
+           taken < max_tasks && !records.empty() &&
+           records.front()->is_committed; --quota) {
+        update_oldest_time(records.front()->time);
+        exec_list_.push_back(ExecTask{static_cast<Lane>(lane),
+                                      records.front(), nullptr});
+        records.pop();
+      }
+    }
+  } while (taken < max_tasks && taken > round_taken);
+  return taken;
+}
+
+const LogConfig& Logger::GetBackendConfig() const {
+  // exec_list_mutex_ should be locked by caller: snapshot is retired by
+  // control task, which can't be executed until the lock is released, so
+  // current one is read without settings_mutex_
+  return *config_.load();
+}
+
+Logger::Pressure Logger::UpdatePressure(std::size_t depth) {
+  // exec_list_mutex_ should be locked by caller
+  using namespace std::chrono;
+  Pressure pressure = { false, is_pressured_, depth, milliseconds(0) };
+  if (!exec_list_.empty()) {
+    pressure.lag = duration_cast<milliseconds>(
+        high_resolution_clock::now() - oldest_task_time_);
+    pressure.lag = std::max(pressure.lag, milliseconds(0));
+  }
+
+  const LogPressureLimits limits = GetBackendConfig().pressure_limits;
+  const bool is_depth_checked = limits.queue_high_water > 0;
+  const bool is_lag_checked = limits.lag_high_water.count() > 0;
+  if (!is_pressured_) {
+    pressure.is_degraded =
+        (is_depth_checked && depth >= limits.queue_high_water) ||
+        (is_lag_checked && pressure.lag >= limits.lag_high_water);
+  } else {
+    // hysteresis: level is restored only when queue is drained enough
+    pressure.is_degraded =
+        (is_depth_checked && depth > limits.queue_low_water) ||
+        (is_lag_checked && pressure.lag > limits.lag_low_water);
+  }
+  pressure.is_changed = pressure.is_degraded != is_pressured_;
+  is_pressured_ = pressure.is_degraded;
+  return pressure;
+}
+
+void Logger::ReportPressure(const Pressure& pressure) {
+  // should be called without any queue locks, because it logs
+  if (!pressure.is_changed) return;
+
+  if (pressure.is_degraded) {
+    const int level = GetPressureLimits().degraded_level;
+    _YETI_WRN_SELF("log queue pressure (depth %zu, lag %lld ms): "
+                   "logging level is degraded to %s",
+                   pressure.depth,
+                   static_cast<long long>(pressure.lag.count()),
+                   kLevelNames[level]);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(settings_mutex_);
+    is_degraded_ = pressure.is_degraded;
+    UpdateEffectiveLevel();
+  }
+
+  if (!pressure.is_degraded) {
+    _YETI_WRN_SELF("log queue pressure is gone (depth %zu, lag %lld ms): "
+                   "logging level is restored to %s",
+                   pressure.depth,
+                   static_cast<long long>(pressure.lag.count()),
+                   kLevelNames[GetLevel()]);
+  }
+}
+
+void Logger::ExecTasks() {
+  // exec_list_mutex_ should be locked by caller
+  if (exec_list_.empty()) return;
+
+  const auto start_time = std::chrono::steady_clock::now();
+  batch_stall_policy_ = GetBackendConfig().stall_policy;
+  for (ExecTask& task : exec_list_) {
+    if (task.record == nullptr) {
+      task.func();
+      continue;
+    }
+    const LogConfig& config = *task.record->config;
+    const int level = task.record->site->level;
+    if (config.trace != nullptr && IsSpanRecord(*task.record)) {
+      WriteTraceEvent(*task.record, config.trace.get());
+      AddWriteLatency(*task.record, nullptr);
+      ++batch_written_[level];
+    } else if (IsRepeated(*task.record)) {
+      ++batch_dropped_[level];
+    } else {
+      const char* msg = task.record->msg();
+      std::size_t msg_len = task.record->msg_len;
+      const bool is_json = config.output == LogOutput::LOG_OUTPUT_JSON;
+      fields_buffer_.clear();
+      if (task.record->is_encoded) {
+        // in text output fields are appended to message
+        render_buffer_.clear();
+        task.record->site->render(task.record->site, msg, &render_buffer_,
+                                  is_json ? &fields_buffer_ : &render_buffer_,
+                                  is_json);
+        msg = render_buffer_.c_str();
+        msg_len = render_buffer_.size();
+      }
+      // JSON strings are always escaped
+      if (!is_json && config.IsSanitized(task.record->fd)) {
+        const char* escaped =
+            SanitizeMessage(msg, msg_len, &sanitize_buffer_);
+        if (escaped != nullptr) msg = escaped;
+      }
+      if (WriteRecord(*task.record, msg, fields_buffer_.c_str())) {
+        AddWriteLatency(*task.record, task.record->fd);
+        ++batch_written_[level];
+      } else {
+        ++batch_dropped_[level];
+      }
+    }
+    // record is released when queue is locked next time
+    ++written_counts_[task.lane];
+  }
+  const std::size_t batch_size = exec_list_.size();
+  exec_list_.clear();
+
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  for (int level = 0; level < kLogLevelCount; ++level) {
+    stats_.written[level] += batch_written_[level];
+    stats_.dropped[level] += batch_dropped_[level];
+  }
+  batch_written_.fill(0);
+  batch_dropped_.fill(0);
+  for (const LogSinkStats& batch_sink : batch_sinks_) {
+    auto sink = std::find_if(
+        stats_.sinks.begin(), stats_.sinks.end(),
+        [&batch_sink](const LogSinkStats& s) { return s.fd == batch_sink.fd; });
+    if (sink == stats_.sinks.end()) {
+      stats_.sinks.push_back(batch_sink);
+    } else {
+      sink->records += batch_sink.records;
+      sink->bytes += batch_sink.bytes;
+      sink->is_stalled = batch_sink.is_stalled;
+      sink->stalls += batch_sink.stalls;
+      sink->rerouted += batch_sink.rerouted;
+      sink->discarded += batch_sink.discarded;
+    }
+  }
+  batch_sinks_.clear();
+  stats_.busy_time += std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start_time);
+  ++stats_.batches;
+  stats_.batched_tasks += batch_size;
+  stats_.max_batch_size = std::max(stats_.max_batch_size, batch_size);
+}
+
+void Logger::FlushRepeats() {
+  // exec_list_mutex_ should be locked by caller
+  if (!has_dedup_ && dedup_deadline_ == 0) return;
+  const auto now = std::chrono::high_resolution_clock::now();
+  dedup_.FlushExpired(now);
+  const auto deadline = dedup_.GetDeadline();
+  dedup_deadline_ =
+      deadline == std::chrono::high_resolution_clock::time_point::max() ? 0
+      : std::chrono::duration_cast<std::chrono::nanoseconds>(
+            deadline.time_since_epoch()).count();
+}
+
+bool Logger::WriteRecord(const LogRecord& record, const char* msg,
+                         const char* fields) {
+  // exec_list_mutex_ should be locked by caller
+  using namespace std::chrono;
+  const LogStallPolicy& policy = batch_stall_policy_;
+  FILE* fd = record.fd;
+  SinkStall* stall = nullptr;
+  bool is_probe = false;
+  if (policy.threshold.count() > 0) {
+    stall = &sink_stalls_[fd];
+    is_probe = stall->is_stalled &&
+        steady_clock::now() - stall->slow_write_time >= policy.probe_interval;
+    if (stall->is_stalled && !is_probe) {
+      // records are kept off stalled sink until it's probed again
+      if (policy.fallback != nullptr && policy.fallback != fd) {
+        ++GetBatchSink(fd).rerouted;
+        fd = policy.fallback;
+        stall = nullptr;
+      } else if (record.site->level > policy.keep_level) {
+        ++GetBatchSink(fd).discarded;
+        return false;
+      }
+    }
+  }
+
+  const auto start_time = stall != nullptr ? steady_clock::now()
+                                           : steady_clock::time_point();
+  const std::size_t bytes = WriteLogRecord(record, fd, msg, fields);
+  // buffered write is fast even if sink is stalled, so probe is flushed
+  if (is_probe) std::fflush(fd);
+  if (record.site->action.load(std::memory_order_relaxed) < 0) {
+    SiteProfiler::instance().AddBytes(record.site, bytes);
+  }
+  LogSinkStats& sink = GetBatchSink(fd);
+  ++sink.records;
+  sink.bytes += bytes;
+  if (stall == nullptr) return true;
+
+  const auto now = steady_clock::now();
+  const auto write_time = duration_cast<milliseconds>(now - start_time);
+  if (now - start_time >= policy.threshold) {
+    if (!stall->is_stalled) {
+      stall->is_stalled = true;
+      ++sink.stalls;
+      stall_events_.push_back(StallEvent{fd, write_time, true});
+    }
+    stall->slow_write_time = now;
+  } else if (is_probe) {
+    stall->is_stalled = false;
+    stall_events_.push_back(StallEvent{fd, write_time, false});
+  }
+  sink.is_stalled = stall->is_stalled;
+  return true;
+}
+
+LogSinkStats& Logger::GetBatchSink(FILE* fd) {
+  // exec_list_mutex_ should be locked by caller
+  // there are few sinks, and the last one is the most likely
+  auto sink = std::find_if(
+      batch_sinks_.rbegin(), batch_sinks_.rend(),
+      [fd](const LogSinkStats& s) { return s.fd == fd; });
+  if (sink != batch_sinks_.rend()) return *sink;
+  LogSinkStats new_sink = LogSinkStats();
+  new_sink.fd = fd;
+  auto stall = sink_stalls_.find(fd);
+  new_sink.is_stalled =
+      stall != sink_stalls_.end() && stall->second.is_stalled;
+  batch_sinks_.push_back(new_sink);
+  return batch_sinks_.back();
+}
+
+void Logger::ReportStalls(const std::vector<StallEvent>& events) {
+  // should be called without any queue locks, because it logs
+  for (const StallEvent& event : events) {
+    const long long write_time = event.write_time.count();
+    if (event.is_stalled) {
+      _YETI_WRN_SELF(
+          "log sink %p stalled (write took %lld ms): its records are %s",
+          static_cast<void*>(event.fd), write_time,
+          GetStallPolicy().fallback != nullptr ? "rerouted" : "dropped");
+    } else {
+      _YETI_WRN_SELF("log sink %p recovered (write took %lld ms)",
+                     static_cast<void*>(event.fd), write_time);
+    }
+  }
+}
+
+void Logger::AddWriteLatency(const LogRecord& record, FILE* fd) {
+  // backend only
+  const std::int64_t latency =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::high_resolution_clock::now() - record.time).count();
+  write_latency_[record.site->level].Add(latency);
+  if (fd == nullptr) return;
+  if (fd != last_latency_fd_) {
+    auto histogram = sink_latency_.find(fd);
+    if (histogram == sink_latency_.end()) {
+      std::lock_guard<std::mutex> lock(stats_mutex_);
+      histogram = sink_latency_.emplace(
+          fd, std::unique_ptr<LatencyHistogram>(new LatencyHistogram())).first;
+    }
+    last_latency_fd_ = fd;
+    last_sink_latency_ = histogram->second.get();
+  }
+  last_sink_latency_->Add(latency);
+}
+
+void Logger::AccountCall(
+    const LogSite* site,
+    std::chrono::high_resolution_clock::time_point start) noexcept {
+  thread_local unsigned calls = 0;
+  const bool is_sampled = calls++ % 64 == 0;
+  const bool is_profiled = site->action.load(std::memory_order_relaxed) < 0;
+  if (!is_sampled && !is_profiled) return;
+  const std::int64_t latency =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::high_resolution_clock::now() - start).count();
+  if (is_sampled) call_latency_[site->level].Add(latency);
+  if (is_profiled) SiteProfiler::instance().AddEmitted(site, latency);
+}
+
+LogStats Logger::GetStats() const {
+  LogStats stats;
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats = stats_;
+    for (LogSinkStats& sink : stats.sinks) {
+      auto histogram = sink_latency_.find(sink.fd);
+      if (histogram != sink_latency_.end()) {
+        sink.write_latency = histogram->second->GetLatency();
+      }
+    }
+  }
+  for (int level = 0; level < kLogLevelCount; ++level) {
+    stats.write_latency[level] = write_latency_[level].GetLatency();
+    stats.call_latency[level] = call_latency_[level].GetLatency();
+  }
+  // records are counted as enqueued before they are written
+  std::lock_guard<std::mutex> lock(queue_mutex_);
+  std::copy(enqueued_counts_.begin(), enqueued_counts_.end(),
+            stats.enqueued);
+  stats.queue_depth = queue_size_;
+  stats.peak_queue_depth = peak_queue_size_;
+  return stats;
+}
+
+void Logger::SetStatsInterval(std::chrono::milliseconds interval) noexcept {
+  stats_interval_ = interval.count();
+  // wake backend up to start logging counters periodically
+  EnqueueTask([] {});
+}
+
+void Logger::AddIdleTime(std::chrono::steady_clock::duration idle_time) {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  stats_.idle_time +=
+      std::chrono::duration_cast<std::chrono::nanoseconds>(idle_time);
+}
+
+void Logger::PollStats() {
+  // backend only
+  const std::int64_t interval = stats_interval_;
+  if (interval <= 0) return;
+  auto now = std::chrono::steady_clock::now();
+  if (now - stats_time_ < std::chrono::milliseconds(interval)) return;
+  const bool is_first = stats_time_ == std::chrono::steady_clock::time_point();
+  stats_time_ = now;
+  if (is_first) return;
+
+  const LogStats stats = GetStats();
+  unsigned long long enqueued = 0, written = 0, dropped = 0;
+  for (int level = 0; level < kLogLevelCount; ++level) {
+    enqueued += stats.enqueued[level];
+    written += stats.written[level];
+    dropped += stats.dropped[level];
+  }
+  const double busy = stats.busy_time.count();
+  const double total = busy + stats.idle_time.count();
+  _YETI_INF_SELF("log stats: enqueued %llu, written %llu, dropped %llu, "
+                 "queue depth %zu (peak %zu), backend busy %.1f%%, "
+                 "batches %llu (max %zu)",
+                 enqueued, written, dropped, stats.queue_depth,
+                 stats.peak_queue_depth,
+                 total > 0 ? 100.0 * busy / total : 0.0,
+                 static_cast<unsigned long long>(stats.batches),
+                 stats.max_batch_size);
+}
+
+std::chrono::milliseconds Logger::GetPollTimeout() const {
+  using namespace std::chrono;
+  milliseconds timeout = kControlFileTimeout;
+  const std::int64_t interval = stats_interval_;
+  if (interval > 0 && (!has_watched_files_ || interval < timeout.count())) {
+    timeout = milliseconds(interval);
+  }
+  const std::int64_t deadline = dedup_deadline_;
+  if (deadline != 0) {
+    // summary is written when window has passed, i.e. a bit after deadline
+    const nanoseconds left = nanoseconds(deadline) -
+        high_resolution_clock::now().time_since_epoch();
+    timeout = std::min(timeout, std::max(
+        duration_cast<milliseconds>(left) + milliseconds(1),
+        milliseconds(0)));
+  }
+  return timeout;
+}
+
 void Logger::Shutdown() {
+  if (has_dedup_) {
+    this->EnqueueTask([this] { dedup_.Flush(); });
+  }
+
+  Logger* worker = worker_.exchange(nullptr);
+  if (worker != nullptr) {
+    // nobody drains queue from now on, so producers do it by themselves
+    worker->Detach(this);
+    engine_ = LogEngine::LOG_ENGINE_COMBINING;
+    Flush();
+    return;
+  }
+
   // set flag to stop processing loop
   stop_loop_ = true;
   cv_.notify_one();
   if (thread_.joinable()) {
     thread_.join();
   }
+
+  // loggers sharing thread drain their queues by themselves from now on
+  std::lock_guard<std::mutex> lock(attached_mutex_);
+  for (Logger* logger : attached_) {
+    logger->worker_ = nullptr;
+    logger->engine_ = LogEngine::LOG_ENGINE_COMBINING;
+    logger->Flush();
+  }
+  attached_.clear();
+  has_attached_ = false;
 }
 
 void Logger::ProcessingLoop() {
   // start processing loop
   do {
     std::unique_lock<std::mutex> queue_lock(queue_mutex_);
-    cv_.wait(queue_lock, [this] { return !this->queue_.empty() || stop_loop_; });
-
-    // build execution list
-    std::lock_guard<std::mutex> exec_lock(exec_list_mutex_);
-    while (!queue_.empty()) {
-      exec_list_.push_back(queue_.front());
-      queue_.pop();
+    if (engine_ == LogEngine::LOG_ENGINE_COMBINING) {
+      // producers drain queue by themselves, so just pick up tasks
+      // which were left by the last combiner
+      const auto wait_time = std::chrono::steady_clock::now();
+      cv_.wait_for(queue_lock, kCombiningTimeout,
+                   [this] { return stop_loop_.load(); });
+      has_attached_tasks_ = false;
+      queue_lock.unlock();
+      AddIdleTime(std::chrono::steady_clock::now() - wait_time);
+      Combine(std::numeric_limits<std::size_t>::max());
+      DrainAttached();
+      PollWatchedFiles();
+      PollStats();
+      continue;
     }
-    queue_lock.unlock();
+    // switch to combining engine wakes backend up to wait with timeout
+    auto is_ready = [this] {
+      return HasReadyTasks() || has_attached_tasks_ || stop_loop_ ||
+             engine_ == LogEngine::LOG_ENGINE_COMBINING;
+    };
+    const auto wait_time = std::chrono::steady_clock::now();
+    if (is_degraded_ || has_attached_) {
+      // wake up periodically to restore logging level in idle (of this
+      // logger or of loggers sharing its thread)
+      cv_.wait_for(queue_lock, kPressureTimeout, is_ready);
+    } else if (has_watched_files_ || stats_interval_ > 0 ||
+               dedup_deadline_ != 0) {
+      cv_.wait_for(queue_lock, GetPollTimeout(), is_ready);
+    } else {
+      cv_.wait(queue_lock, is_ready);
+    }
+    const auto idle_time = std::chrono::steady_clock::now() - wait_time;
+    if (engine_ == LogEngine::LOG_ENGINE_COMBINING) {
+      // engine is switched: wait the other way without blocking producers
+      // on combiner which may be writing at the moment
+      queue_lock.unlock();
+      AddIdleTime(idle_time);
+      continue;
+    }
+
+    Pressure pressure;
+    std::vector<StallEvent> stall_events;
+    {
+      // build execution list
+      std::lock_guard<std::mutex> exec_lock(exec_list_mutex_);
+      std::size_t depth = queue_size_ + TakeTasks(kBatchSize);
+      has_attached_tasks_ = false;
+      queue_lock.unlock();
+      pressure = UpdatePressure(depth);
 
-    // execute all elements from execution list
-    while (!exec_list_.empty()) {
-      exec_list_.front()();
-      exec_list_.pop_front();
+      // execute all elements from execution list
+      ExecTasks();
+      FlushRepeats();
+      stall_events.swap(stall_events_);
     }
+    ReportPressure(pressure);
+    ReportStalls(stall_events);
+    AddIdleTime(idle_time);
+    DrainAttached();
+    PollWatchedFiles();
+    PollStats();
   } while (!stop_loop_ || !IsQueueEmpty());
 }
 
 void Logger::SetFormatStr(const std::string& format_str) noexcept {
-  std::lock_guard<std::mutex> lock(settings_mutex_);
-  format_str_ = format_str;
+  UpdateConfig([&format_str](LogConfig* config) {
+    config->SetFormatStr(format_str);
+  });
 }
 
 std::string Logger::GetFormatStr() const noexcept {
   std::lock_guard<std::mutex> lock(settings_mutex_);
-  return format_str_;
+  return config_.load()->format_str;
 }
 
 void Logger::Flush() {
+  if (has_dedup_) {
+    // write summaries of all runs of repeated records
+    this->EnqueueTask([this] { dedup_.Flush(); });
+  }
+
   do {
-    cv_.notify_one();
+    if (engine_ == LogEngine::LOG_ENGINE_COMBINING || worker_ != nullptr) {
+      Combine(std::numeric_limits<std::size_t>::max());
+    } else {
+      cv_.notify_one();
+    }
   } while (!IsQueueEmpty() || !IsExecListEmpty());
 }
 
 bool Logger::IsQueueEmpty() {
   std::lock_guard<std::mutex> lock(queue_mutex_);
-  return queue_.empty();
+  return queue_size_ == 0;
 }
 
 bool Logger::IsExecListEmpty() {
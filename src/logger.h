@@ -28,55 +28,271 @@
 #ifndef INC_YETI_LOGGER_H_
 #define INC_YETI_LOGGER_H_
 
+#include <cstdint>
 #include <cstdio>
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <functional>
 #include <mutex>
 #include <queue>
-#include <list>
+#include <map>
+#include <memory>
 #include <string>
 #include <thread>
+#include <vector>
 #include <yeti/yeti.h>
+#include <src/dedup.h>
+#include <src/histogram.h>
+#include <src/record_queue.h>
+#include <src/site_registry.h>
 
 namespace yeti {
 
-/** @brief Singleton to provide access to logger object. */
+/**
+ * @brief Logger object with its own queue, settings and backend.
+ *
+ * Default instance is used by macros without handle, others are created by
+ * yeti::LogHandle.
+ */
 class Logger {
  public:
-  ~Logger() = default;
+  /**
+   * @brief Creates logger drained by its own thread or by thread of worker
+   * (worker should outlive logger).
+   */
+  explicit Logger(Logger* worker = nullptr);
+  ~Logger();
   Logger(const Logger&) = delete;
   Logger& operator=(const Logger&) = delete;
-  Logger* operator &() = delete;
 
-  /** @brief Returns instance of logger object. */
+  /** @brief Returns default instance of logger object. */
   static Logger& instance();
 
-  /** @brief Adds functor to log queue. */
+  /**
+   * @brief Adds control functor to log queue.
+   *
+   * Control task is executed only after all records enqueued before it.
+   */
   void EnqueueTask(const std::function<void()>& queue_func);
 
+  /**
+   * @brief Adds record with message of msg_len characters to log queue.
+   *
+   * Encoded message contains arguments which are rendered by call site.
+   */
+  void EnqueueRecord(const LogSite* site, std::size_t msg_id,
+                     std::chrono::high_resolution_clock::time_point time,
+                     const char* msg, std::size_t msg_len,
+                     bool is_encoded = false);
+
+  /**
+   * @brief Reserves record for message of msg_len characters in log queue.
+   *
+   * Message should be written into record before it is committed.
+   */
+  LogRecord* ReserveRecord(const LogSite* site, std::size_t msg_id,
+                           std::chrono::high_resolution_clock::time_point time,
+                           std::size_t msg_len, bool is_encoded = false);
+  /** @brief Passes reserved record to backend. */
+  void CommitRecord(LogRecord* record);
+
+  /**
+   * @brief Adds record with message written by format functor to log queue.
+   *
+   * Functor int(char* buf, std::size_t size) works like snprintf. Short
+   * message is formatted on stack and copied into record slot, long one is
+   * measured and then formatted right into record spilled over several slots.
+   */
+  template <typename Format>
+  void EnqueueFormatted(const LogSite* site, std::size_t msg_id,
+                        std::chrono::high_resolution_clock::time_point time,
+                        Format format) {
+    EnqueueFormatted(MakeHeader(site, msg_id, time, GetLogContextSnapshot()),
+                     GetLane(site->level), format);
+  }
+
+  /**
+   * @brief Adds record captured into backtrace ring to log queue.
+   *
+   * Record is placed into lane of trigger record, so it is written before
+   * trigger even if its own lane is drained later. It keeps context of
+   * thread from the moment it was captured.
+   */
+  void EnqueueBacktrace(const BacktraceRecord& record,
+                        const LogSite* trigger);
+
+  /** @brief Sets output format of records. */
+  void SetOutput(LogOutput output) noexcept;
+  /** @brief Returns current output format of records. */
+  LogOutput GetOutput() const noexcept;
+
+  /** @brief Sets file to write spans as trace events (nullptr to stop). */
+  void SetTraceFile(FILE* fd) noexcept;
+  /** @brief Returns file to write spans as trace events. */
+  FILE* GetTraceFile() const noexcept;
+
+  /** @brief Sets engine to drain log queue. */
+  void SetEngine(LogEngine engine) noexcept;
+  /** @brief Returns current engine. */
+  LogEngine GetEngine() const noexcept {
+    return static_cast<LogEngine>(engine_.load());
+  }
+
+  /**
+   * @brief Executes up to max_tasks queued tasks if no one else is doing it.
+   *
+   * Returns false if another thread is combining at the moment.
+   */
+  bool Combine(std::size_t max_tasks);
+
   /** @brief Sets logging level. */
-  void SetLevel(LogLevel level) noexcept { instance().level_ = level; }
+  void SetLevel(LogLevel level) noexcept;
+  /** @brief Sets levels like "warn,net=dbg" (see yeti::SetLogLevels()). */
+  void SetLevels(const std::string& levels);
   /** @brief Returns current logging level. */
-  int GetLevel() const noexcept { return instance().level_; }
+  int GetLevel() const noexcept { return level_; }
+  /** @brief Returns logging level checked by macros (may be degraded). */
+  int GetEffectiveLevel() const noexcept { return effective_level_; }
+  /** @brief Returns logging level checked by macros to read it inline. */
+  const std::atomic<int>& GetEffectiveLevelRef() const noexcept {
+    return effective_level_;
+  }
+
+  /** @brief Returns logging level to write or capture records. */
+  int GetCaptureLevel() const noexcept { return capture_level_; }
+
+  /** @brief Sets logging level of thread overriding the global one. */
+  void SetThreadLevel(std::thread::id thread_id, LogLevel level);
+  /** @brief Drops logging level of thread. */
+  void ResetThreadLevel(std::thread::id thread_id);
+  /** @brief Returns logging level of thread (global if not overridden). */
+  int GetThreadLevel(std::thread::id thread_id) const;
+
+  /** @brief Sets backtrace buffering parameters (zero size disables it). */
+  void SetBacktrace(std::size_t size, LogLevel capture_level,
+                    LogLevel trigger_level) noexcept;
+  /** @brief Returns size of per-thread backtrace ring. */
+  std::size_t GetBacktraceSize() const noexcept { return backtrace_size_; }
+  /** @brief Returns level of records which flush backtrace ring. */
+  int GetBacktraceTriggerLevel() const noexcept {
+    return backtrace_trigger_level_;
+  }
+
+  /** @brief Sets queue pressure limits to degrade logging level. */
+  void SetPressureLimits(const LogPressureLimits& limits) noexcept;
+  /** @brief Returns queue pressure limits. */
+  LogPressureLimits GetPressureLimits() const noexcept;
+  /** @brief Returns is logging level degraded due to queue pressure. */
+  bool IsDegraded() const noexcept { return is_degraded_; }
+  /** @brief Sets policy of watchdog of stalled sinks. */
+  void SetStallPolicy(const LogStallPolicy& policy) noexcept;
+  /** @brief Returns policy of watchdog of stalled sinks. */
+  LogStallPolicy GetStallPolicy() const noexcept;
+
+  /** @brief Returns counters of logger. */
+  LogStats GetStats() const;
+  /**
+   * @brief Accounts time spent by producer in logging call of site since
+   * start: it's sampled once per 64 calls of thread, and counted for
+   * profiled site.
+   */
+  void AccountCall(
+      const LogSite* site,
+      std::chrono::high_resolution_clock::time_point start) noexcept;
+  /** @brief Sets period to log counters (zero turns it off). */
+  void SetStatsInterval(std::chrono::milliseconds interval) noexcept;
+  /** @brief Returns period to log counters. */
+  std::chrono::milliseconds GetStatsInterval() const noexcept {
+    return std::chrono::milliseconds(stats_interval_.load());
+  }
 
   /** @brief Sets log colorization. */
-  void SetColored(bool is_colored) noexcept { is_colored_ = is_colored; }
+  void SetColored(bool is_colored) noexcept;
   /** @brief Returns current log colorization. */
-  bool IsColored() const noexcept { return instance().is_colored_; }
+  bool IsColored() const noexcept;
 
-  /** @brief Returns current message ID. */
-  std::size_t GetMsgId() const noexcept { return msg_id_; }
-  /** @brief Increments message ID. */
-  void IncMsgId() noexcept { ++msg_id_; }
+  /** @brief Returns unique message ID and increments it. */
+  std::size_t NextMsgId() noexcept { return msg_id_++; }
 
   /** @brief Sets file log descriptor. */
-  void SetFileDesc(FILE* fd) noexcept { fd_ = fd; }
+  void SetFileDesc(FILE* fd) noexcept;
   /** @brief Returns current file log descriptor. */
-  FILE* GetFileDesc() const noexcept { return fd_;}
+  FILE* GetFileDesc() const noexcept;
   /** @brief Closes specified log file descriptor. */
   void CloseFileDesc(FILE* fd = nullptr);
 
+  /**
+   * @brief Sets time window to collapse repeated records of sink.
+   *
+   * Zero window turns deduplication of sink off.
+   */
+  void SetDedupWindow(FILE* fd, std::chrono::milliseconds window);
+  /** @brief Returns time window to collapse repeated records of sink. */
+  std::chrono::milliseconds GetDedupWindow(FILE* fd) const;
+  /**
+   * @brief Returns true if record repeats the previous one of its sink
+   * and should not be written (backend only).
+   */
+  bool IsRepeated(const LogRecord& record);
+
+  /** @brief Turns escaping of messages written into sink on or off. */
+  void SetSanitized(FILE* fd, bool is_sanitized);
+  /** @brief Returns is escaping of messages written into sink on. */
+  bool IsSanitized(FILE* fd) const;
+
+  /**
+   * @brief Registers call site (if it is new) and returns its action
+   * for current thread (call is counted if site is profiled).
+   */
+  int ResolveSite(const LogSite* site, const char* format,
+                  bool is_counted = true);
+  /** @brief Sets mode of call sites, returns number of matching ones. */
+  std::size_t SetSiteMode(const LogSiteFilter& filter, LogSiteMode mode) {
+    return site_registry_.SetMode(filter, mode);
+  }
+  /** @brief Drops all modes of call sites. */
+  void ResetSiteModes() { site_registry_.SetModes(SiteRegistry::Rules()); }
+  /** @brief Returns registered call sites matching filter. */
+  std::vector<LogSiteInfo> GetSites(const LogSiteFilter& filter) const {
+    return site_registry_.GetSites(filter);
+  }
+  /** @brief Turns counters of call sites on or off. */
+  void SetSiteProfiling(bool is_enabled) {
+    site_registry_.SetProfiling(is_enabled);
+  }
+  /** @brief Returns whether counters of call sites are on. */
+  bool IsSiteProfiling() const noexcept {
+    return site_registry_.IsProfiling();
+  }
+  /** @brief Applies control commands to call sites. */
+  bool ApplySiteControl(const std::string& commands);
+  /** @brief Sets control file of call sites (empty path stops watching). */
+  bool SetSiteControlFile(const std::string& path);
+
+  /** @brief Applies settings like in config file (see ApplyLogConfig()). */
+  bool ApplyConfig(const std::string& config);
+  /** @brief Sets config file (empty path stops watching). */
+  bool SetConfigFile(const std::string& path);
+
+  /** @brief Registers category of records and sets its level. */
+  void RegisterCategory(LogCategory* category) {
+    site_registry_.RegisterCategory(category);
+  }
+  /** @brief Sets level of categories matching pattern. */
+  void SetCategoryLevel(const std::string& pattern, LogLevel level) {
+    site_registry_.SetCategoryLevel(pattern, level);
+  }
+  /** @brief Makes all categories follow the global logging level. */
+  void ResetCategoryLevels() {
+    site_registry_.SetCategoryLevels(SiteRegistry::CategoryRules());
+  }
+  /** @brief Returns level of category by its name. */
+  int GetCategoryLevel(const std::string& name) const {
+    return site_registry_.GetCategoryLevel(name);
+  }
+
   /** @brief Parse string to set log level. */
   LogLevel LogLevelFromEnv(const char* var);
 
@@ -98,24 +314,211 @@ class Logger {
   bool IsQueueEmpty();
 
   /** @brief Return is execution list is empty. */
-    bool IsExecListEmpty();
+  bool IsExecListEmpty();
+
+  /** @brief Starts draining queue of logger sharing thread of this one. */
+  void Attach(Logger* logger);
+  /** @brief Stops draining queue of logger sharing thread of this one. */
+  void Detach(Logger* logger);
 
  private:
-  Logger();
+  /** @brief Queue lanes in order of draining priority. */
+  enum Lane {
+    kUrgentLane,   // critical and error records
+    kNormalLane,   // warning and info records
+    kVerboseLane,  // debug and trace records
+    kControlLane   // control tasks (closing file descriptors, etc.)
+  };
+
+  /** @brief Control task. */
+  struct Task {
+    std::size_t seq;
+    std::chrono::high_resolution_clock::time_point time;
+    std::function<void()> func;
+  };
+
+  /** @brief Element of execution list: record to write or control task. */
+  struct ExecTask {
+    Lane lane;
+    LogRecord* record;
+    std::function<void()> func;
+  };
+
+  /** @brief Logging levels of thread cached until next change of levels. */
+  struct ThreadLevels {
+    std::uint64_t generation;
+    SiteLevels levels;
+    bool has_override;
+    int level;  // level of thread if it is overridden
+  };
+
+  /** @brief State of sink watched for stalls (backend only). */
+  struct SinkStall {
+    bool is_stalled;
+    std::chrono::steady_clock::time_point slow_write_time;  // the last one
+  };
+
+  /** @brief Change of sink state reported after batch. */
+  struct StallEvent {
+    FILE* fd;
+    std::chrono::milliseconds write_time;
+    bool is_stalled;
+  };
+
+  /** @brief File which is applied again when backend sees it modified. */
+  struct WatchedFile {
+    std::string path;  // empty if file isn't watched
+    std::int64_t mtime;  // nanoseconds
+    std::int64_t size;
+  };
+
+  /** @brief Queue pressure observed by backend. */
+  struct Pressure {
+    bool is_changed;
+    bool is_degraded;
+    std::size_t depth;
+    std::chrono::milliseconds lag;
+  };
+
+  static Lane GetLane(LogLevel level) noexcept;
+  LogRecord MakeHeader(const LogSite* site, std::size_t msg_id,
+                       std::chrono::high_resolution_clock::time_point time,
+                       std::shared_ptr<const LogContextSnapshot> context);
+  void EnqueueRecord(LogRecord&& header, Lane lane, const char* msg,
+                     std::size_t msg_len);
+  LogRecord* ReserveRecord(LogRecord&& header, Lane lane,
+                           std::size_t msg_len);
+
+  template <typename Format>
+  void EnqueueFormatted(LogRecord&& header, Lane lane, Format format) {
+    // short message is formatted on stack, long one right into record
+    char msg[kInlineMsgSize];
+    int len = format(msg, sizeof(msg));
+    if (len < 0) {
+      // output error, log empty message
+      len = 0;
+      msg[0] = '\0';
+    }
+    if (static_cast<std::size_t>(len) < sizeof(msg)) {
+      EnqueueRecord(std::move(header), lane, msg, len);
+      return;
+    }
+
+    LogRecord* record = ReserveRecord(std::move(header), lane, len);
+    int written = format(record->msg(), record->msg_len + 1);
+    if (written >= 0 && written < len) {
+      record->msg_len = written;
+    }
+    CommitRecord(record);
+  }
+
+  void NotifyBackend(std::unique_lock<std::mutex>* queue_lock);
+  std::size_t TakeTasks(std::size_t max_tasks);
+  void ReleaseRecords();
+  std::size_t GetMinRecordSeq() const;
+  bool HasReadyTasks() const;
+  void ExecTasks();
+  void FlushRepeats();
+  const LogConfig& GetBackendConfig() const;
+  Pressure UpdatePressure(std::size_t depth);
+  void ReportPressure(const Pressure& pressure);
+  void UpdateEffectiveLevel();
+  const ThreadLevels& GetCurrentThreadLevels();
+  void SetWatchedFile(WatchedFile* file, const std::string& path);
+  bool ReadWatchedFile(WatchedFile* file, bool is_forced,
+                       std::string* content);
+  bool LoadSiteControlFile(bool is_forced);
+  bool LoadConfigFile(bool is_forced);
+  void PollWatchedFiles();
+  FILE* OpenConfigSink(const std::string& path);
+  void WakeUp();
+  void DrainAttached();
+  bool WriteRecord(const LogRecord& record, const char* msg,
+                   const char* fields);
+  LogSinkStats& GetBatchSink(FILE* fd);
+  void ReportStalls(const std::vector<StallEvent>& events);
+  void AddWriteLatency(const LogRecord& record, FILE* fd);
+  void AddIdleTime(std::chrono::steady_clock::duration idle_time);
+  void PollStats();
+  std::chrono::milliseconds GetPollTimeout() const;
+  void UpdateConfig(const std::function<void(LogConfig*)>& update);
+  void RetireConfig(const LogConfig* config, const LogConfig* replacement);
 
   mutable std::mutex queue_mutex_;
   mutable std::mutex exec_list_mutex_;
   mutable std::mutex settings_mutex_;
   std::condition_variable cv_;
-  std::queue<std::function<void()>> queue_;
-  std::list<std::function<void()>> exec_list_;
+  ChunkPool chunk_pool_;
+  std::array<RecordQueue, kControlLane> record_lanes_;
+  std::queue<Task> control_lane_;
+  std::size_t queue_size_;
+  std::size_t task_seq_;
+  std::vector<ExecTask> exec_list_;
+  std::string render_buffer_;
+  std::string fields_buffer_;
+  std::string sanitize_buffer_;
+  std::array<std::size_t, kControlLane> written_counts_;
+  // counters of producers guarded by queue_mutex_
+  std::array<std::uint64_t, kLogLevelCount> enqueued_counts_;
+  std::size_t peak_queue_size_;
+  // counters of backend: they are summed up per batch (guarded by
+  // exec_list_mutex_) and published into stats_ once per batch
+  mutable std::mutex stats_mutex_;
+  LogStats stats_;
+  std::array<std::uint64_t, kLogLevelCount> batch_written_;
+  std::array<std::uint64_t, kLogLevelCount> batch_dropped_;
+  std::vector<LogSinkStats> batch_sinks_;
+  // histograms are updated without locks; sinks are added by backend under
+  // stats_mutex_, so backend reads them without lock
+  std::array<LatencyHistogram, kLogLevelCount> write_latency_;
+  std::array<LatencyHistogram, kLogLevelCount> call_latency_;
+  std::map<FILE*, std::unique_ptr<LatencyHistogram>> sink_latency_;
+  FILE* last_latency_fd_;
+  LatencyHistogram* last_sink_latency_;
+  std::atomic<std::int64_t> stats_interval_;  // milliseconds
+  std::chrono::steady_clock::time_point stats_time_;
   std::atomic<bool> stop_loop_;
-  std::atomic<bool> is_colored_;
+  std::atomic<bool> is_combining_;
+  std::atomic<int> engine_;
   std::atomic<int> level_;
+  std::atomic<int> effective_level_;
+  std::atomic<int> capture_level_;
+  std::atomic<std::size_t> backtrace_size_;
+  std::atomic<int> backtrace_level_;
+  std::atomic<int> backtrace_trigger_level_;
+  std::atomic<bool> is_degraded_;
+  std::map<std::thread::id, int> thread_levels_;
+  SiteLevels site_levels_;
+  std::atomic<std::uint64_t> level_generation_;
+  bool is_pressured_;
+  // watchdog of sinks: policy is read once per batch
+  LogStallPolicy batch_stall_policy_;
+  std::map<FILE*, SinkStall> sink_stalls_;
+  std::vector<StallEvent> stall_events_;
+  std::chrono::high_resolution_clock::time_point oldest_task_time_;
   std::atomic<std::size_t> msg_id_;
-  std::string format_str_;
-  std::atomic<FILE*> fd_;
+  // published settings: producers read them under queue_mutex_, setters
+  // replace them under settings_mutex_ and queue_mutex_
+  std::atomic<const LogConfig*> config_;
+  std::atomic<bool> has_dedup_;
+  Deduplicator dedup_;
+  // when the first summary of repeated records is due (nanoseconds since
+  // epoch of high_resolution_clock, zero if there is no one)
+  std::atomic<std::int64_t> dedup_deadline_;
+  SiteRegistry site_registry_;
+  WatchedFile control_file_;
+  WatchedFile config_file_;
+  std::atomic<bool> has_watched_files_;
+  std::chrono::steady_clock::time_point watched_files_check_time_;
+  FILE* config_fd_;  // sink opened by config, nullptr if there is no one
+  std::string config_fd_path_;
+  bool has_config_sites_;  // config has set modes of call sites
   std::thread thread_;
+  std::atomic<Logger*> worker_;
+  std::mutex attached_mutex_;
+  std::vector<Logger*> attached_;
+  std::atomic<bool> has_attached_;
+  bool has_attached_tasks_;  // guarded by queue_mutex_
 };
 
 }  // namespace yeti
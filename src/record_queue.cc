@@ -0,0 +1,152 @@
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+#include <algorithm>
+#include <new>
+#include <utility>
+
+#include <src/record_queue.h>
+
+namespace yeti {
+
+namespace {
+
+// size of regular chunk (longer records get chunk of their own)
+const std::size_t kChunkSize = 64 * 1024;
+
+// max number of free chunks kept for reuse
+const std::size_t kMaxFreeChunks = 16;
+
+LogRecord* RecordAt(const RecordChunk* chunk, std::size_t pos) {
+  return reinterpret_cast<LogRecord*>(chunk->data.get() + pos);
+}
+
+}  // namespace
+
+ChunkPool::~ChunkPool() {
+  for (RecordChunk* chunk : free_chunks_) {
+    delete chunk;
+  }
+}
+
+RecordChunk* ChunkPool::Acquire(std::size_t size) {
+  if (size <= kChunkSize && !free_chunks_.empty()) {
+    RecordChunk* chunk = free_chunks_.back();
+    free_chunks_.pop_back();
+    return chunk;
+  }
+
+  std::size_t capacity = std::max(size, kChunkSize);
+  return new RecordChunk{capacity, 0, 0, 0,
+                         std::unique_ptr<char[]>(new char[capacity])};
+}
+
+void ChunkPool::Recycle(RecordChunk* chunk) {
+  if (chunk->capacity != kChunkSize || free_chunks_.size() >= kMaxFreeChunks) {
+    delete chunk;
+    return;
+  }
+  chunk->write_pos = chunk->read_pos = chunk->release_pos = 0;
+  free_chunks_.push_back(chunk);
+}
+
+RecordQueue::~RecordQueue() {
+  for (RecordChunk* chunk : chunks_) {
+    for (std::size_t pos = chunk->release_pos; pos < chunk->write_pos; ) {
+      LogRecord* record = RecordAt(chunk, pos);
+      pos += record->size;
+      record->~LogRecord();
+    }
+    delete chunk;
+  }
+}
+
+LogRecord* RecordQueue::Reserve(LogRecord&& header, std::size_t msg_len,
+                                ChunkPool* pool) {
+  // round record up to whole number of slots
+  std::size_t size = sizeof(LogRecord) + msg_len + 1;
+  size = (size + kRecordSlotSize - 1) / kRecordSlotSize * kRecordSlotSize;
+
+  RecordChunk* tail = chunks_.empty() ? nullptr : chunks_.back();
+  if (tail == nullptr || tail->capacity - tail->write_pos < size) {
+    if (tail != nullptr && chunks_.size() == 1 &&
+        tail->release_pos == tail->write_pos) {
+      // the only chunk is empty, but too small for record
+      chunks_.pop_back();
+      pool->Recycle(tail);
+      tail = nullptr;
+    }
+    chunks_.push_back(pool->Acquire(size));
+    if (tail != nullptr && tail->read_pos == tail->write_pos) {
+      // all records of previous chunk are taken
+      read_index_ = chunks_.size() - 1;
+    }
+    tail = chunks_.back();
+  }
+
+  LogRecord* record = new (tail->data.get() + tail->write_pos)
+      LogRecord(std::move(header));
+  record->msg_len = static_cast<std::uint32_t>(msg_len);
+  record->size = static_cast<std::uint32_t>(size);
+  tail->write_pos += size;
+  return record;
+}
+
+LogRecord* RecordQueue::front() const noexcept {
+  if (chunks_.empty()) return nullptr;
+
+  const RecordChunk* chunk = chunks_[read_index_];
+  if (chunk->read_pos == chunk->write_pos) return nullptr;
+  return RecordAt(chunk, chunk->read_pos);
+}
+
+void RecordQueue::pop() noexcept {
+  RecordChunk* chunk = chunks_[read_index_];
+  chunk->read_pos += RecordAt(chunk, chunk->read_pos)->size;
+  if (chunk->read_pos == chunk->write_pos && read_index_ + 1 < chunks_.size()) {
+    ++read_index_;
+  }
+}
+
+void RecordQueue::Release(ChunkPool* pool) noexcept {
+  RecordChunk* chunk = chunks_.front();
+  LogRecord* record = RecordAt(chunk, chunk->release_pos);
+  chunk->release_pos += record->size;
+  record->~LogRecord();
+  if (chunk->release_pos != chunk->write_pos) return;
+
+  if (chunks_.size() > 1) {
+    chunks_.pop_front();
+    --read_index_;
+    pool->Recycle(chunk);
+  } else {
+    // reuse the only chunk from the beginning
+    chunk->write_pos = chunk->read_pos = chunk->release_pos = 0;
+  }
+}
+
+}  // namespace yeti
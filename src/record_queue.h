@@ -0,0 +1,142 @@
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+#ifndef INC_YETI_RECORD_QUEUE_H_
+#define INC_YETI_RECORD_QUEUE_H_
+
+#include <unistd.h>
+#include <cstdint>
+#include <cstdio>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <yeti/yeti.h>
+#include <src/log_config.h>
+#include <src/log_context.h>
+
+namespace yeti {
+
+/**
+ * @brief Header of log record stored in log queue.
+ *
+ * Message of record is stored right after header, so record with short
+ * message occupies one slot and record with long one spills over several
+ * consecutive slots.
+ */
+struct LogRecord {
+  const LogSite* site;
+  std::size_t seq;
+  std::size_t msg_id;
+  std::chrono::high_resolution_clock::time_point time;
+  std::thread::id tid;
+  FILE* fd;
+  const LogConfig* config;  // valid until record is written
+  std::shared_ptr<const LogContextSnapshot> context;  // nullptr if empty
+  pid_t pid;
+  std::uint32_t msg_len;
+  std::uint32_t size;  // bytes occupied by record in queue
+  bool is_committed;
+  bool is_encoded;  // message is arguments of {}-style call site
+
+  /** @brief Returns null-terminated message following header. */
+  char* msg() noexcept { return reinterpret_cast<char*>(this + 1); }
+  const char* msg() const noexcept {
+    return reinterpret_cast<const char*>(this + 1);
+  }
+};
+
+/** @brief Size of queue slot (record occupies integral number of slots). */
+const std::size_t kRecordSlotSize = 256;
+
+/** @brief Max size of message (with terminating zero) stored in one slot. */
+const std::size_t kInlineMsgSize = kRecordSlotSize - sizeof(LogRecord);
+
+/** @brief Contiguous memory where records are placed one after another. */
+struct RecordChunk {
+  std::size_t capacity;
+  std::size_t write_pos;    // end of reserved records
+  std::size_t read_pos;     // end of records taken by backend
+  std::size_t release_pos;  // end of released records
+  std::unique_ptr<char[]> data;
+};
+
+/** @brief Keeps released chunks to reuse them by all queues. */
+class ChunkPool {
+ public:
+  ChunkPool() = default;
+  ~ChunkPool();
+  ChunkPool(const ChunkPool&) = delete;
+  ChunkPool& operator=(const ChunkPool&) = delete;
+
+  /** @brief Returns empty chunk which can hold at least size bytes. */
+  RecordChunk* Acquire(std::size_t size);
+  /** @brief Returns chunk to pool (or frees it if pool is full). */
+  void Recycle(RecordChunk* chunk);
+
+ private:
+  std::vector<RecordChunk*> free_chunks_;
+};
+
+/**
+ * @brief FIFO queue of variable-length records.
+ *
+ * Records are reserved by producers, taken by backend and released after
+ * they are written, in the same order. Memory is reused through chunk pool,
+ * so there is no allocation per record. Queue is not thread-safe.
+ */
+class RecordQueue {
+ public:
+  RecordQueue() : read_index_(0) {}
+  ~RecordQueue();
+  RecordQueue(const RecordQueue&) = delete;
+  RecordQueue& operator=(const RecordQueue&) = delete;
+
+  /** @brief Places header into queue and reserves msg_len + 1 bytes. */
+  LogRecord* Reserve(LogRecord&& header, std::size_t msg_len,
+                     ChunkPool* pool);
+
+  /** @brief Returns the oldest record not taken yet (or nullptr). */
+  LogRecord* front() const noexcept;
+  /** @brief Returns is there no records to take. */
+  bool empty() const noexcept { return front() == nullptr; }
+  /** @brief Takes front record (it is valid until it is released). */
+  void pop() noexcept;
+
+  /** @brief Destroys the oldest taken record and reuses its memory. */
+  void Release(ChunkPool* pool) noexcept;
+
+ private:
+  std::deque<RecordChunk*> chunks_;
+  std::size_t read_index_;  // chunk of front record
+};
+
+}  // namespace yeti
+
+#endif  // INC_YETI_RECORD_QUEUE_H_
@@ -0,0 +1,295 @@
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#if defined(__SSE2__)
+#  include <immintrin.h>
+#endif  // __SSE2__
+
+#include <src/sanitize.h>
+
+namespace yeti {
+
+namespace {
+
+// backslash is unsafe too: otherwise literal "\n" can't be told from
+// escaped newline
+bool IsUnsafe(unsigned char c) {
+  return c < 0x20 || c >= 0x7f || c == '\\';
+}
+
+bool IsJsonSpecial(unsigned char c) {
+  return c < 0x20 || c >= 0x80 || c == '"' || c == '\\';
+}
+
+std::size_t FindUnsafeByteScalar(const char* data, std::size_t pos,
+                                 std::size_t size) {
+  for (; pos < size; ++pos) {
+    if (IsUnsafe(static_cast<unsigned char>(data[pos]))) break;
+  }
+  return pos;
+}
+
+std::size_t FindJsonSpecialByteScalar(const char* data, std::size_t pos,
+                                      std::size_t size) {
+  for (; pos < size; ++pos) {
+    if (IsJsonSpecial(static_cast<unsigned char>(data[pos]))) break;
+  }
+  return pos;
+}
+
+#if defined(__SSE2__)
+
+// bytes are compared as signed: non-ASCII ones are negative, so they are
+// caught by the same comparison as control characters
+
+std::size_t FindUnsafeByteSse2(const char* data, std::size_t size) {
+  const __m128i space = _mm_set1_epi8(0x20);
+  const __m128i del = _mm_set1_epi8(0x7f);
+  const __m128i backslash = _mm_set1_epi8('\\');
+  std::size_t pos = 0;
+  for (; pos + sizeof(__m128i) <= size; pos += sizeof(__m128i)) {
+    __m128i bytes =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+    int mask = _mm_movemask_epi8(_mm_or_si128(
+        _mm_cmplt_epi8(bytes, space),
+        _mm_or_si128(_mm_cmpeq_epi8(bytes, del),
+                     _mm_cmpeq_epi8(bytes, backslash))));
+    if (mask != 0) return pos + __builtin_ctz(mask);
+  }
+  return FindUnsafeByteScalar(data, pos, size);
+}
+
+__attribute__((target("avx2")))
+std::size_t FindUnsafeByteAvx2(const char* data, std::size_t size) {
+  const __m256i space = _mm256_set1_epi8(0x20);
+  const __m256i del = _mm256_set1_epi8(0x7f);
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  std::size_t pos = 0;
+  for (; pos + sizeof(__m256i) <= size; pos += sizeof(__m256i)) {
+    __m256i bytes =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+    int mask = _mm256_movemask_epi8(_mm256_or_si256(
+        _mm256_cmpgt_epi8(space, bytes),
+        _mm256_or_si256(_mm256_cmpeq_epi8(bytes, del),
+                        _mm256_cmpeq_epi8(bytes, backslash))));
+    if (mask != 0) return pos + __builtin_ctz(mask);
+  }
+  return FindUnsafeByteScalar(data, pos, size);
+}
+
+std::size_t FindJsonSpecialByteSse2(const char* data, std::size_t size) {
+  const __m128i space = _mm_set1_epi8(0x20);
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  std::size_t pos = 0;
+  for (; pos + sizeof(__m128i) <= size; pos += sizeof(__m128i)) {
+    __m128i bytes =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+    int mask = _mm_movemask_epi8(_mm_or_si128(
+        _mm_cmplt_epi8(bytes, space),
+        _mm_or_si128(_mm_cmpeq_epi8(bytes, quote),
+                     _mm_cmpeq_epi8(bytes, backslash))));
+    if (mask != 0) return pos + __builtin_ctz(mask);
+  }
+  return FindJsonSpecialByteScalar(data, pos, size);
+}
+
+__attribute__((target("avx2")))
+std::size_t FindJsonSpecialByteAvx2(const char* data, std::size_t size) {
+  const __m256i space = _mm256_set1_epi8(0x20);
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  std::size_t pos = 0;
+  for (; pos + sizeof(__m256i) <= size; pos += sizeof(__m256i)) {
+    __m256i bytes =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+    int mask = _mm256_movemask_epi8(_mm256_or_si256(
+        _mm256_cmpgt_epi8(space, bytes),
+        _mm256_or_si256(_mm256_cmpeq_epi8(bytes, quote),
+                        _mm256_cmpeq_epi8(bytes, backslash))));
+    if (mask != 0) return pos + __builtin_ctz(mask);
+  }
+  return FindJsonSpecialByteScalar(data, pos, size);
+}
+
+typedef std::size_t (*FindFunc)(const char* data, std::size_t size);
+
+FindFunc SelectFindFunc(FindFunc avx2_func, FindFunc sse2_func) {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") ? avx2_func : sse2_func;
+}
+
+#endif  // __SSE2__
+
+// returns length of valid UTF-8 sequence at data (0 if it is invalid)
+std::size_t GetUtf8Length(const unsigned char* data, std::size_t size) {
+  auto is_cont = [data, size](std::size_t i) {
+    return i < size && (data[i] & 0xc0) == 0x80;
+  };
+  const unsigned char c = data[0];
+  if (c >= 0xc2 && c <= 0xdf) {
+    return is_cont(1) ? 2 : 0;
+  }
+  if (c >= 0xe0 && c <= 0xef) {
+    // overlong forms and surrogates are invalid
+    if (size < 2 || (c == 0xe0 && data[1] < 0xa0) ||
+        (c == 0xed && data[1] > 0x9f)) {
+      return 0;
+    }
+    return is_cont(1) && is_cont(2) ? 3 : 0;
+  }
+  if (c >= 0xf0 && c <= 0xf4) {
+    // overlong forms and code points above U+10FFFF are invalid
+    if (size < 2 || (c == 0xf0 && data[1] < 0x90) ||
+        (c == 0xf4 && data[1] > 0x8f)) {
+      return 0;
+    }
+    return is_cont(1) && is_cont(2) && is_cont(3) ? 4 : 0;
+  }
+  return 0;
+}
+
+}  // namespace
+
+std::size_t FindUnsafeByte(const char* data, std::size_t size) {
+#if defined(__SSE2__)
+  static const FindFunc find_func =
+      SelectFindFunc(&FindUnsafeByteAvx2, &FindUnsafeByteSse2);
+  return find_func(data, size);
+#else
+  return FindUnsafeByteScalar(data, 0, size);
+#endif  // __SSE2__
+}
+
+std::size_t FindJsonSpecialByte(const char* data, std::size_t size) {
+#if defined(__SSE2__)
+  static const FindFunc find_func =
+      SelectFindFunc(&FindJsonSpecialByteAvx2, &FindJsonSpecialByteSse2);
+  return find_func(data, size);
+#else
+  return FindJsonSpecialByteScalar(data, 0, size);
+#endif  // __SSE2__
+}
+
+const char* SanitizeMessage(const char* msg, std::size_t size,
+                            std::string* out) {
+  std::size_t pos = FindUnsafeByte(msg, size);
+  if (pos == size) return nullptr;
+
+  out->assign(msg, pos);
+  while (pos < size) {
+    const unsigned char c = static_cast<unsigned char>(msg[pos]);
+    std::size_t len = c >= 0x80 ? GetUtf8Length(
+        reinterpret_cast<const unsigned char*>(msg + pos), size - pos) : 0;
+    if (len > 0) {
+      out->append(msg + pos, len);
+      pos += len;
+    } else {
+      switch (c) {
+        case '\n':
+          out->append("\\n");
+          break;
+        case '\r':
+          out->append("\\r");
+          break;
+        case '\t':
+          out->append("\\t");
+          break;
+        case '\\':
+          out->append("\\\\");
+          break;
+        default:
+          char hex[5];
+          std::snprintf(hex, sizeof(hex), "\\x%02X", c);
+          out->append(hex, 4);
+          break;
+      }
+      ++pos;
+    }
+
+    // copy clean run at once
+    std::size_t next = pos + FindUnsafeByte(msg + pos, size - pos);
+    out->append(msg + pos, next - pos);
+    pos = next;
+  }
+  return out->c_str();
+}
+
+void EscapeJson(const char* data, std::size_t size, std::string* out) {
+  static const char kHexDigits[] = "0123456789abcdef";
+  std::size_t pos = FindJsonSpecialByte(data, size);
+  out->append(data, pos);
+  while (pos < size) {
+    const unsigned char c = static_cast<unsigned char>(data[pos]);
+    std::size_t len = c >= 0x80 ? GetUtf8Length(
+        reinterpret_cast<const unsigned char*>(data + pos), size - pos) : 0;
+    if (len > 0) {
+      out->append(data + pos, len);
+      pos += len;
+    } else {
+      switch (c) {
+        case '"':
+          out->append("\\\"");
+          break;
+        case '\\':
+          out->append("\\\\");
+          break;
+        case '\n':
+          out->append("\\n");
+          break;
+        case '\r':
+          out->append("\\r");
+          break;
+        case '\t':
+          out->append("\\t");
+          break;
+        default:
+          if (c >= 0x80) {
+            // invalid UTF-8 is replaced to keep output valid JSON
+            out->append("\\ufffd");
+          } else {
+            const char escaped[] = {'\\', 'u', '0', '0', kHexDigits[c >> 4],
+                                    kHexDigits[c & 0xf]};
+            out->append(escaped, sizeof(escaped));
+          }
+          break;
+      }
+      ++pos;
+    }
+
+    // copy clean run at once
+    std::size_t next = pos + FindJsonSpecialByte(data + pos, size - pos);
+    out->append(data + pos, next - pos);
+    pos = next;
+  }
+}
+
+}  // namespace yeti
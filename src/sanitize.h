@@ -0,0 +1,70 @@
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+#ifndef INC_YETI_SANITIZE_H_
+#define INC_YETI_SANITIZE_H_
+
+#include <cstddef>
+#include <string>
+
+namespace yeti {
+
+/**
+ * @brief Returns position of the first byte which may need escaping:
+ * control character, DEL, backslash or non-ASCII byte (size if there is no
+ * such byte).
+ *
+ * Payload is scanned with AVX2 or SSE2 if CPU supports them.
+ */
+std::size_t FindUnsafeByte(const char* data, std::size_t size);
+
+/**
+ * @brief Returns position of the first byte which may need escaping in JSON
+ * string: control character, quote, backslash or non-ASCII byte.
+ */
+std::size_t FindJsonSpecialByte(const char* data, std::size_t size);
+
+/**
+ * @brief Returns message with control characters, backslashes and invalid
+ * UTF-8 escaped (\\n, \\r, \\t, \\\\ or \\xHH), or nullptr if message is
+ * clean.
+ *
+ * Valid UTF-8 sequences are kept. Escaped message is written into out.
+ */
+const char* SanitizeMessage(const char* msg, std::size_t size,
+                            std::string* out);
+
+/**
+ * @brief Appends data escaped as content of JSON string to out.
+ *
+ * Valid UTF-8 sequences are kept, invalid bytes are replaced by U+FFFD.
+ */
+void EscapeJson(const char* data, std::size_t size, std::string* out);
+
+}  // namespace yeti
+
+#endif  // INC_YETI_SANITIZE_H_
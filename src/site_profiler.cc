@@ -0,0 +1,243 @@
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <new>
+#include <vector>
+
+#include <src/site_profiler.h>
+
+namespace yeti {
+
+namespace {
+
+const char* const kLevelNames[] = { "CRT", "ERR", "WRN", "INF", "DBG", "TRC" };
+
+// counter is written by owner thread only, so it needs no atomic increment
+void Add(std::atomic<std::uint64_t>* counter, std::uint64_t value) {
+  counter->store(counter->load(std::memory_order_relaxed) + value,
+                 std::memory_order_relaxed);
+}
+
+}  // namespace
+
+/** @brief Shard of current thread, it's retired when thread exits. */
+class SiteProfiler::ThreadShard {
+ public:
+  ThreadShard() : shard_(new Shard()) {
+    SiteProfiler::instance().AttachShard(shard_);
+  }
+  ~ThreadShard() { SiteProfiler::instance().RetireShard(shard_); }
+
+  Shard* get() const { return shard_; }
+
+ private:
+  Shard* shard_;
+};
+
+SiteProfiler::Block::Block() {
+  for (Counters& counters : this->counters) {
+    counters.calls.store(0, std::memory_order_relaxed);
+    counters.emitted.store(0, std::memory_order_relaxed);
+    counters.filtered.store(0, std::memory_order_relaxed);
+    counters.bytes.store(0, std::memory_order_relaxed);
+    counters.nanoseconds.store(0, std::memory_order_relaxed);
+  }
+}
+
+SiteProfiler::Shard::Shard() {
+  for (auto& block : blocks) {
+    block.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+SiteProfiler::Shard::~Shard() {
+  for (auto& block : blocks) {
+    delete block.load(std::memory_order_relaxed);
+  }
+}
+
+SiteProfiler& SiteProfiler::instance() {
+  // threads may retire their shards during static destruction
+  static SiteProfiler* profiler = new SiteProfiler();
+  return *profiler;
+}
+
+SiteProfiler::SiteProfiler() : retired_(new Shard()) {}
+
+std::uint32_t SiteProfiler::RegisterSite(const LogSite* site) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // site may be registered by another thread meanwhile
+  std::uint32_t id = site->profile_id.load(std::memory_order_relaxed);
+  if (id == 0) {
+    sites_.push_back(site);
+    id = static_cast<std::uint32_t>(sites_.size());
+    site->profile_id.store(id, std::memory_order_relaxed);
+  }
+  return id;
+}
+
+void SiteProfiler::AttachShard(Shard* shard) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  shards_.push_back(shard);
+}
+
+void SiteProfiler::RetireShard(Shard* shard) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  shards_.erase(std::find(shards_.begin(), shards_.end(), shard));
+  AddShard(*shard, retired_.get());
+  delete shard;
+}
+
+void SiteProfiler::AddShard(const Shard& shard, Shard* total) {
+  // mutex_ should be locked by caller
+  for (std::size_t i = 0; i < kMaxBlocks; ++i) {
+    const Block* block = shard.blocks[i].load(std::memory_order_acquire);
+    if (block == nullptr) continue;
+    Block* total_block = total->blocks[i].load(std::memory_order_relaxed);
+    if (total_block == nullptr) {
+      total_block = new Block();
+      total->blocks[i].store(total_block, std::memory_order_relaxed);
+    }
+    for (std::size_t j = 0; j < kBlockSize; ++j) {
+      const Counters& from = block->counters[j];
+      Counters& to = total_block->counters[j];
+      Add(&to.calls, from.calls.load(std::memory_order_relaxed));
+      Add(&to.emitted, from.emitted.load(std::memory_order_relaxed));
+      Add(&to.filtered, from.filtered.load(std::memory_order_relaxed));
+      Add(&to.bytes, from.bytes.load(std::memory_order_relaxed));
+      Add(&to.nanoseconds, from.nanoseconds.load(std::memory_order_relaxed));
+    }
+  }
+}
+
+SiteProfiler::Counters* SiteProfiler::GetCounters(
+    const LogSite* site) noexcept {
+  std::uint32_t id = site->profile_id.load(std::memory_order_relaxed);
+  if (id == 0) id = RegisterSite(site);
+  const std::size_t index = id - 1;
+  if (index >= kBlockSize * kMaxBlocks) return nullptr;
+
+  static thread_local ThreadShard thread_shard;
+  std::atomic<Block*>& slot = thread_shard.get()->blocks[index / kBlockSize];
+  Block* block = slot.load(std::memory_order_relaxed);
+  if (block == nullptr) {
+    block = new (std::nothrow) Block();
+    if (block == nullptr) return nullptr;
+    slot.store(block, std::memory_order_release);
+  }
+  return &block->counters[index % kBlockSize];
+}
+
+void SiteProfiler::AddCall(const LogSite* site, bool is_filtered) noexcept {
+  Counters* counters = GetCounters(site);
+  if (counters == nullptr) return;
+  Add(&counters->calls, 1);
+  if (is_filtered) Add(&counters->filtered, 1);
+}
+
+void SiteProfiler::AddEmitted(const LogSite* site,
+                              std::int64_t nanos) noexcept {
+  Counters* counters = GetCounters(site);
+  if (counters == nullptr) return;
+  Add(&counters->emitted, 1);
+  Add(&counters->nanoseconds, nanos > 0 ? nanos : 0);
+}
+
+void SiteProfiler::AddBytes(const LogSite* site, std::size_t bytes) noexcept {
+  Counters* counters = GetCounters(site);
+  if (counters != nullptr) Add(&counters->bytes, bytes);
+}
+
+std::vector<LogSiteProfile> SiteProfiler::GetProfile() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // retired counters are summed up with counters of running threads
+  Shard total;
+  AddShard(*retired_, &total);
+  for (const Shard* shard : shards_) {
+    AddShard(*shard, &total);
+  }
+
+  std::vector<LogSiteProfile> profile;
+  for (std::size_t index = 0; index < sites_.size(); ++index) {
+    const Block* block =
+        total.blocks[index / kBlockSize].load(std::memory_order_relaxed);
+    if (block == nullptr) continue;
+    const Counters& counters = block->counters[index % kBlockSize];
+    const LogSite* site = sites_[index];
+    LogSiteProfile site_profile;
+    site_profile.file = site->filename;
+    site_profile.func = site->funcname;
+    site_profile.line = site->line;
+    site_profile.level = site->level;
+    site_profile.calls = counters.calls.load(std::memory_order_relaxed);
+    site_profile.emitted = counters.emitted.load(std::memory_order_relaxed);
+    site_profile.filtered = counters.filtered.load(std::memory_order_relaxed);
+    site_profile.bytes = counters.bytes.load(std::memory_order_relaxed);
+    site_profile.producer_time = std::chrono::nanoseconds(
+        counters.nanoseconds.load(std::memory_order_relaxed));
+    profile.push_back(site_profile);
+  }
+  return profile;
+}
+
+void SiteProfiler::Dump(std::size_t count, FILE* fd) const {
+  std::vector<LogSiteProfile> profile = GetProfile();
+  auto print = [&](const char* order) {
+    std::fprintf(fd, "log site profile: top %zu of %zu sites by %s\n",
+                 std::min(count, profile.size()), profile.size(), order);
+    std::fprintf(fd, "%12s %12s %12s %14s %12s  %s\n", "calls", "emitted",
+                 "filtered", "bytes", "time, us", "site");
+    for (std::size_t i = 0; i < count && i < profile.size(); ++i) {
+      const LogSiteProfile& site = profile[i];
+      std::fprintf(
+          fd, "%12llu %12llu %12llu %14llu %12llu  %s:%d %s() [%s]\n",
+          static_cast<unsigned long long>(site.calls),
+          static_cast<unsigned long long>(site.emitted),
+          static_cast<unsigned long long>(site.filtered),
+          static_cast<unsigned long long>(site.bytes),
+          static_cast<unsigned long long>(site.producer_time.count() / 1000),
+          site.file.c_str(), site.line, site.func.c_str(),
+          kLevelNames[site.level]);
+    }
+  };
+  std::stable_sort(profile.begin(), profile.end(),
+                   [](const LogSiteProfile& a, const LogSiteProfile& b) {
+                     return a.bytes > b.bytes;
+                   });
+  print("bytes");
+  std::stable_sort(profile.begin(), profile.end(),
+                   [](const LogSiteProfile& a, const LogSiteProfile& b) {
+                     return a.producer_time > b.producer_time;
+                   });
+  print("producer time");
+  std::fflush(fd);
+}
+
+}  // namespace yeti
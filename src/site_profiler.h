@@ -0,0 +1,108 @@
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+#ifndef INC_YETI_SITE_PROFILER_H_
+#define INC_YETI_SITE_PROFILER_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <yeti/yeti.h>
+
+namespace yeti {
+
+/**
+ * @brief Counters of call sites sharded by threads.
+ *
+ * Every thread counts into its own shard with plain relaxed stores, so
+ * counting costs no locked instructions and no cache line bouncing. Shards
+ * are summed up when profile is read, and counters of finished threads are
+ * kept in a retired shard. It is thread-safe.
+ */
+class SiteProfiler {
+ public:
+  /** @brief Returns process-wide profiler (it is never destroyed). */
+  static SiteProfiler& instance();
+
+  SiteProfiler();
+  SiteProfiler(const SiteProfiler&) = delete;
+  SiteProfiler& operator=(const SiteProfiler&) = delete;
+
+  /** @brief Counts call of site which record is filtered out or not. */
+  void AddCall(const LogSite* site, bool is_filtered) noexcept;
+  /** @brief Counts record enqueued by producer and time of its call. */
+  void AddEmitted(const LogSite* site, std::int64_t nanos) noexcept;
+  /** @brief Counts bytes of site written by backend. */
+  void AddBytes(const LogSite* site, std::size_t bytes) noexcept;
+
+  /** @brief Returns counters of all profiled sites. */
+  std::vector<LogSiteProfile> GetProfile() const;
+  /** @brief Prints top count sites by bytes and by time into fd. */
+  void Dump(std::size_t count, FILE* fd) const;
+
+ private:
+  struct Counters {
+    std::atomic<std::uint64_t> calls;
+    std::atomic<std::uint64_t> emitted;
+    std::atomic<std::uint64_t> filtered;
+    std::atomic<std::uint64_t> bytes;
+    std::atomic<std::uint64_t> nanoseconds;
+  };
+  static const std::size_t kBlockSize = 256;
+  static const std::size_t kMaxBlocks = 256;  // further sites aren't counted
+
+  struct Block {
+    Block();
+    std::array<Counters, kBlockSize> counters;
+  };
+  // blocks are allocated by owner thread and never freed while it runs
+  struct Shard {
+    Shard();
+    ~Shard();
+    std::array<std::atomic<Block*>, kMaxBlocks> blocks;
+  };
+  class ThreadShard;
+
+  Counters* GetCounters(const LogSite* site) noexcept;
+  std::uint32_t RegisterSite(const LogSite* site);
+  void AttachShard(Shard* shard);
+  void RetireShard(Shard* shard);
+  static void AddShard(const Shard& shard, Shard* total);
+
+  mutable std::mutex mutex_;
+  std::vector<const LogSite*> sites_;  // by profile id - 1
+  std::vector<Shard*> shards_;         // shards of running threads
+  std::unique_ptr<Shard> retired_;     // counters of finished threads
+};
+
+}  // namespace yeti
+
+#endif  // INC_YETI_SITE_PROFILER_H_
@@ -0,0 +1,315 @@
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+#include <fnmatch.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+#include <src/site_registry.h>
+
+namespace yeti {
+
+namespace {
+
+bool MatchGlob(const std::string& glob, const char* str) {
+  return glob.empty() || fnmatch(glob.c_str(), str, 0) == 0;
+}
+
+bool MatchFilter(const LogSiteFilter& filter, const LogSite* site,
+                 const std::string& format) {
+  if (!filter.file.empty()) {
+    const char* slash = std::strrchr(site->filename, '/');
+    const char* basename = slash != nullptr ? slash + 1 : site->filename;
+    if (!MatchGlob(filter.file, site->filename) &&
+        !MatchGlob(filter.file, basename)) {
+      return false;
+    }
+  }
+  if (filter.first_line > 0 && site->line < filter.first_line) return false;
+  if (filter.last_line > 0 && site->line > filter.last_line) return false;
+  return MatchGlob(filter.func, site->funcname) &&
+         MatchGlob(filter.format, format.c_str());
+}
+
+int GetAction(const LogSite* site, LogSiteMode mode,
+              const SiteLevels& levels) {
+  switch (mode) {
+    case LOG_SITE_ENABLED:
+      return _kSiteLog;
+    case LOG_SITE_DISABLED:
+      return _kSiteOff;
+    default:
+      break;
+  }
+  const int base_level = site->category != nullptr
+      ? site->category->GetLevel() : levels.level;
+  const int effective_level = levels.GetEffective(base_level);
+  const int capture_level = levels.GetCapture(base_level);
+  if (levels.has_thread_levels) {
+    // sites between levels of category and levels of threads check level
+    // of current thread, the others keep the same action for all threads
+    int min_level = std::min(effective_level,
+                             levels.GetEffective(levels.min_thread_level));
+    int max_level = std::max(capture_level,
+                             levels.GetCapture(levels.max_thread_level));
+    if (site->level > min_level && site->level <= max_level) {
+      return _kSiteCheck;
+    }
+  }
+  if (effective_level >= site->level) return _kSiteLog;
+  if (capture_level >= site->level) return _kSiteCapture;
+  return _kSiteOff;
+}
+
+// reads the next word or "quoted string" of line
+bool ReadWord(std::istringstream* line, std::string* word) {
+  *line >> std::ws;
+  if (line->peek() != '"') return static_cast<bool>(*line >> *word);
+  line->get();
+  return static_cast<bool>(std::getline(*line, *word, '"'));
+}
+
+bool ParseLine(const std::string& text, LogSiteFilter* filter,
+               LogSiteMode* mode) {
+  std::istringstream line(text);
+  std::string keyword;
+  while (ReadWord(&line, &keyword)) {
+    std::string value;
+    if (keyword == "enable" || keyword == "disable" || keyword == "default") {
+      *mode = keyword == "enable" ? LOG_SITE_ENABLED
+          : keyword == "disable" ? LOG_SITE_DISABLED : LOG_SITE_DEFAULT;
+      // action must be the last word
+      return !ReadWord(&line, &value);
+    }
+    if (!ReadWord(&line, &value)) return false;
+    if (keyword == "file") {
+      filter->file = value;
+    } else if (keyword == "func") {
+      filter->func = value;
+    } else if (keyword == "format") {
+      filter->format = value;
+    } else if (keyword == "line") {
+      char* end = nullptr;
+      filter->first_line = std::strtol(value.c_str(), &end, 10);
+      filter->last_line = filter->first_line;
+      if (*end == '-') {
+        filter->last_line = std::strtol(end + 1, &end, 10);
+      }
+      if (*end != '\0' || filter->first_line <= 0 ||
+          filter->last_line < filter->first_line) {
+        return false;
+      }
+    } else {
+      return false;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+SiteRegistry::SiteRegistry()
+    : levels_{LOG_LEVEL_INFO, LOG_LEVEL_TRACE, -1, false, 0, 0},
+      is_profiling_(false) {}
+
+LogSiteMode SiteRegistry::GetMode(const Entry& entry) const {
+  // mutex_ should be locked by caller
+  LogSiteMode mode = LOG_SITE_DEFAULT;
+  for (const auto& rule : rules_) {
+    if (MatchFilter(rule.first, entry.site, entry.format)) {
+      mode = rule.second;
+    }
+  }
+  return mode;
+}
+
+void SiteRegistry::UpdateAction(const Entry& entry) const {
+  // mutex_ should be locked by caller
+  const int action = GetAction(entry.site, entry.mode, levels_);
+  entry.site->action.store(is_profiling_ ? -action : action,
+                           std::memory_order_relaxed);
+}
+
+int SiteRegistry::ResolveCategoryLevel(const std::string& name) const {
+  // mutex_ should be locked by caller
+  // the last pattern matching name wins, then the ones matching its parents
+  std::string prefix = name;
+  for (;;) {
+    for (auto it = category_rules_.rbegin(); it != category_rules_.rend();
+         ++it) {
+      if (fnmatch(it->first.c_str(), prefix.c_str(), 0) == 0) {
+        return it->second;
+      }
+    }
+    std::size_t dot = prefix.rfind('.');
+    if (dot == std::string::npos) break;
+    prefix.resize(dot);
+  }
+  return levels_.level;
+}
+
+void SiteRegistry::UpdateCategories() {
+  // mutex_ should be locked by caller
+  for (LogCategory* category : categories_) {
+    category->_SetLevel(ResolveCategoryLevel(category->GetName()));
+  }
+  for (const Entry& entry : entries_) {
+    UpdateAction(entry);
+  }
+}
+
+int SiteRegistry::Register(const LogSite* site, const char* format) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (site->action.load(std::memory_order_relaxed) == _kSiteUnresolved) {
+    // site may be registered by another thread meanwhile
+    Entry entry{site, format != nullptr ? format : "", LOG_SITE_DEFAULT};
+    entry.mode = GetMode(entry);
+    UpdateAction(entry);
+    entries_.push_back(std::move(entry));
+  }
+  return site->action.load(std::memory_order_relaxed);
+}
+
+void SiteRegistry::SetLevels(const SiteLevels& levels) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  levels_ = levels;
+  UpdateCategories();
+}
+
+void SiteRegistry::RegisterCategory(LogCategory* category) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  categories_.push_back(category);
+  // sites of category may be registered before it
+  UpdateCategories();
+}
+
+void SiteRegistry::SetCategoryLevel(const std::string& pattern,
+                                    LogLevel level) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto is_same = [&pattern](const std::pair<std::string, LogLevel>& rule) {
+    return rule.first == pattern;
+  };
+  category_rules_.erase(std::remove_if(category_rules_.begin(),
+                                       category_rules_.end(), is_same),
+                        category_rules_.end());
+  category_rules_.emplace_back(pattern, level);
+  UpdateCategories();
+}
+
+void SiteRegistry::SetCategoryLevels(const CategoryRules& rules) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  category_rules_ = rules;
+  UpdateCategories();
+}
+
+int SiteRegistry::GetCategoryLevel(const std::string& name) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return ResolveCategoryLevel(name);
+}
+
+std::size_t SiteRegistry::SetMode(const LogSiteFilter& filter,
+                                  LogSiteMode mode) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto is_same = [&filter](const std::pair<LogSiteFilter, LogSiteMode>& rule) {
+    return rule.first.file == filter.file && rule.first.func == filter.func &&
+           rule.first.first_line == filter.first_line &&
+           rule.first.last_line == filter.last_line &&
+           rule.first.format == filter.format;
+  };
+  rules_.erase(std::remove_if(rules_.begin(), rules_.end(), is_same),
+               rules_.end());
+  rules_.emplace_back(filter, mode);
+
+  std::size_t count = 0;
+  for (Entry& entry : entries_) {
+    if (!MatchFilter(filter, entry.site, entry.format)) continue;
+    entry.mode = mode;
+    UpdateAction(entry);
+    ++count;
+  }
+  return count;
+}
+
+void SiteRegistry::SetModes(const Rules& rules) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  rules_ = rules;
+  for (Entry& entry : entries_) {
+    entry.mode = GetMode(entry);
+    UpdateAction(entry);
+  }
+}
+
+void SiteRegistry::SetProfiling(bool is_profiling) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  is_profiling_ = is_profiling;
+  for (const Entry& entry : entries_) {
+    UpdateAction(entry);
+  }
+}
+
+std::vector<LogSiteInfo> SiteRegistry::GetSites(
+    const LogSiteFilter& filter) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  SiteLevels levels = levels_;
+  levels.has_thread_levels = false;
+  std::vector<LogSiteInfo> sites;
+  for (const Entry& entry : entries_) {
+    if (!MatchFilter(filter, entry.site, entry.format)) continue;
+    const LogSite* site = entry.site;
+    sites.push_back(LogSiteInfo{
+        site->filename, site->funcname, site->line, site->level,
+        site->category != nullptr ? site->category->GetName() : "",
+        entry.format, entry.mode,
+        GetAction(site, entry.mode, levels) == _kSiteLog});
+  }
+  return sites;
+}
+
+bool ParseSiteControl(const std::string& commands,
+                      SiteRegistry::Rules* rules) {
+  bool is_valid = true;
+  std::istringstream input(commands);
+  std::string line;
+  while (std::getline(input, line)) {
+    std::size_t begin = line.find_first_not_of(" \t\r");
+    if (begin == std::string::npos || line[begin] == '#') continue;
+    LogSiteFilter filter;
+    LogSiteMode mode = LOG_SITE_DEFAULT;
+    if (ParseLine(line, &filter, &mode)) {
+      rules->emplace_back(filter, mode);
+    } else {
+      is_valid = false;
+    }
+  }
+  return is_valid;
+}
+
+}  // namespace yeti
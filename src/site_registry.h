@@ -0,0 +1,145 @@
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+#ifndef INC_YETI_SITE_REGISTRY_H_
+#define INC_YETI_SITE_REGISTRY_H_
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <yeti/yeti.h>
+
+namespace yeti {
+
+/** @brief Logging levels which actions of call sites depend on. */
+struct SiteLevels {
+  int level;             // global logging level set by user
+  int degraded_level;    // bound of effective levels under queue pressure
+  int backtrace_level;   // level of captured records (-1 if backtrace is off)
+  bool has_thread_levels;
+  int min_thread_level;  // the lowest level of threads overriding level
+  int max_thread_level;  // the highest level of threads overriding level
+
+  /** @brief Returns level checked by macros for specified base level. */
+  int GetEffective(int base_level) const {
+    return std::min(base_level, degraded_level);
+  }
+  /** @brief Returns level to write or capture records for base level. */
+  int GetCapture(int base_level) const {
+    return std::max(GetEffective(base_level), backtrace_level);
+  }
+};
+
+/**
+ * @brief Registry of call sites of logging macros.
+ *
+ * It keeps cached action of every registered site up to date with logging
+ * levels and with modes set by filters. It is thread-safe.
+ */
+class SiteRegistry {
+ public:
+  typedef std::vector<std::pair<LogSiteFilter, LogSiteMode>> Rules;
+  typedef std::vector<std::pair<std::string, LogLevel>> CategoryRules;
+
+  SiteRegistry();
+  SiteRegistry(const SiteRegistry&) = delete;
+  SiteRegistry& operator=(const SiteRegistry&) = delete;
+
+  /** @brief Registers site (if it is new) and returns its action. */
+  int Register(const LogSite* site, const char* format);
+
+  /**
+   * @brief Updates actions of all sites after change of levels.
+   *
+   * Sites with levels between levels of their categories and levels of
+   * threads depend on current thread.
+   */
+  void SetLevels(const SiteLevels& levels);
+
+  /** @brief Registers category and sets its level. */
+  void RegisterCategory(LogCategory* category);
+  /** @brief Sets level of categories matching pattern and their children. */
+  void SetCategoryLevel(const std::string& pattern, LogLevel level);
+  /** @brief Replaces all levels of categories. */
+  void SetCategoryLevels(const CategoryRules& rules);
+  /** @brief Returns level of category by its name. */
+  int GetCategoryLevel(const std::string& name) const;
+
+  /**
+   * @brief Adds rule (replacing rule with the same filter) and returns
+   * number of registered sites matching it.
+   */
+  std::size_t SetMode(const LogSiteFilter& filter, LogSiteMode mode);
+  /** @brief Replaces all rules. */
+  void SetModes(const Rules& rules);
+
+  /**
+   * @brief Turns profiling of sites on or off: actions of profiled sites are
+   * negated, so macros call yeti::_ResolveLogSite() which counts calls.
+   */
+  void SetProfiling(bool is_profiling);
+  /** @brief Returns whether sites are profiled. */
+  bool IsProfiling() const noexcept { return is_profiling_; }
+
+  /** @brief Returns registered sites matching filter (by global level). */
+  std::vector<LogSiteInfo> GetSites(const LogSiteFilter& filter) const;
+
+ private:
+  struct Entry {
+    const LogSite* site;
+    std::string format;
+    LogSiteMode mode;
+  };
+
+  LogSiteMode GetMode(const Entry& entry) const;
+  void UpdateAction(const Entry& entry) const;
+  int ResolveCategoryLevel(const std::string& name) const;
+  void UpdateCategories();
+
+  mutable std::mutex mutex_;
+  std::vector<Entry> entries_;
+  Rules rules_;
+  std::vector<LogCategory*> categories_;
+  CategoryRules category_rules_;
+  SiteLevels levels_;
+  std::atomic<bool> is_profiling_;
+};
+
+/**
+ * @brief Parses control commands (see yeti::ApplyLogSiteControl()).
+ *
+ * Returns false if some line is malformed, other lines are parsed anyway.
+ */
+bool ParseSiteControl(const std::string& commands,
+                      SiteRegistry::Rules* rules);
+
+}  // namespace yeti
+
+#endif  // INC_YETI_SITE_REGISTRY_H_
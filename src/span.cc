@@ -0,0 +1,203 @@
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include <yeti/yeti.h>
+#include <src/logger.h>
+#include <src/trace.h>
+
+namespace yeti {
+
+namespace {
+
+/** @brief Arguments of span record. */
+struct SpanArgs {
+  std::int64_t begin_ns;  // since epoch of high resolution clock
+  std::int64_t duration_ns;
+  std::uint64_t span_id;
+  std::uint64_t parent_id;
+  std::uint32_t depth;
+};
+
+/** @brief Span IDs are taken by threads in blocks to avoid contention. */
+const std::uint64_t kSpanIdBlockSize = 1024;
+
+std::atomic<std::uint64_t> g_next_span_block(1);
+
+/** @brief Innermost span of thread (trivial, so it needs no guard). */
+struct SpanState {
+  std::uint64_t current_id;
+  std::uint32_t depth;
+  std::uint64_t next_id;
+  std::uint64_t id_limit;
+};
+
+thread_local SpanState t_span_state;
+
+std::uint64_t NextSpanId(SpanState* state) {
+  if (state->next_id == state->id_limit) {
+    state->next_id = g_next_span_block.fetch_add(kSpanIdBlockSize,
+                                                 std::memory_order_relaxed);
+    state->id_limit = state->next_id + kSpanIdBlockSize;
+  }
+  return state->next_id++;
+}
+
+SpanArgs DecodeSpan(const char* args) {
+  SpanArgs span;
+  std::memcpy(&span, args, sizeof(span));
+  return span;
+}
+
+// appends nanoseconds as microseconds with three decimals
+void AppendMicros(std::int64_t ns, std::string* out) {
+  if (ns < 0) {
+    out->push_back('-');
+    ns = -ns;
+  }
+  _FmtAppend(static_cast<std::uint64_t>(ns / 1000), out);
+  const int frac = static_cast<int>(ns % 1000);
+  const char digits[] = {'.', static_cast<char>('0' + frac / 100),
+                         static_cast<char>('0' + frac / 10 % 10),
+                         static_cast<char>('0' + frac % 10)};
+  out->append(digits, sizeof(digits));
+}
+
+}  // namespace
+
+LogSpan::LogSpan(const LogSite* site)
+    : site_(nullptr), span_id_(0), parent_id_(0), depth_(0) {
+  if (_GetLogSiteAction(site, site->format) != _kSiteLog) return;
+
+  SpanState& state = t_span_state;
+  site_ = site;
+  span_id_ = NextSpanId(&state);
+  parent_id_ = state.current_id;
+  depth_ = state.depth++;
+  state.current_id = span_id_;
+  begin_ = std::chrono::high_resolution_clock::now();
+}
+
+LogSpan::~LogSpan() {
+  if (site_ == nullptr) return;
+
+  using namespace std::chrono;
+  auto end = high_resolution_clock::now();
+  SpanState& state = t_span_state;
+  state.current_id = parent_id_;
+  --state.depth;
+
+  SpanArgs span;
+  span.begin_ns =
+      duration_cast<nanoseconds>(begin_.time_since_epoch()).count();
+  span.duration_ns = duration_cast<nanoseconds>(end - begin_).count();
+  span.span_id = span_id_;
+  span.parent_id = parent_id_;
+  span.depth = depth_;
+  _EnqueueEncodedLog(nullptr, site_, reinterpret_cast<const char*>(&span),
+                     sizeof(span));
+}
+
+void _RenderSpan(const LogSite* site, const char* args, std::string* msg,
+                 std::string* fields, bool is_json) {
+  const SpanArgs span = DecodeSpan(args);
+  msg->append(site->format);
+  msg->append(" took ");
+  AppendMicros(span.duration_ns, msg);
+  msg->append(" us");
+
+  if (is_json) {
+    fields->append(",\"span\":");
+    _FmtAppendJson(site->format, std::strlen(site->format), fields);
+    fields->append(",\"dur_ns\":");
+    _FmtAppend(static_cast<std::int64_t>(span.duration_ns), fields);
+    fields->append(",\"depth\":");
+  } else {
+    fields->append(" depth=");
+  }
+  _FmtAppend(static_cast<std::uint64_t>(span.depth), fields);
+  fields->append(is_json ? ",\"span_id\":" : " span_id=");
+  _FmtAppend(span.span_id, fields);
+  fields->append(is_json ? ",\"parent_id\":" : " parent_id=");
+  _FmtAppend(span.parent_id, fields);
+}
+
+bool IsSpanRecord(const LogRecord& record) {
+  return record.is_encoded && record.site->render == &_RenderSpan;
+}
+
+void WriteTraceEvent(const LogRecord& record, TraceSink* sink) {
+  // events are elements of JSON array, closing bracket is optional in trace
+  // event format
+  static thread_local std::string event;  // reused by backends
+
+  const SpanArgs span = DecodeSpan(record.msg());
+  auto it = sink->thread_ids.find(record.tid);
+  if (it == sink->thread_ids.end()) {
+    it = sink->thread_ids.emplace(record.tid,
+                                  sink->thread_ids.size() + 1).first;
+  }
+
+  event.assign(sink->is_opened ? ",\n" : "[\n");
+  sink->is_opened = true;
+  event.append("{\"name\":");
+  _FmtAppendJson(record.site->format, std::strlen(record.site->format),
+                 &event);
+  event.append(",\"cat\":\"yeti\",\"ph\":\"X\",\"ts\":");
+  AppendMicros(span.begin_ns, &event);
+  event.append(",\"dur\":");
+  AppendMicros(span.duration_ns, &event);
+  event.append(",\"pid\":");
+  _FmtAppend(static_cast<std::int64_t>(record.pid), &event);
+  event.append(",\"tid\":");
+  _FmtAppend(it->second, &event);
+  event.append(",\"args\":{\"span_id\":");
+  _FmtAppend(span.span_id, &event);
+  event.append(",\"parent_id\":");
+  _FmtAppend(span.parent_id, &event);
+  event.append(",\"depth\":");
+  _FmtAppend(static_cast<std::uint64_t>(span.depth), &event);
+  if (record.context != nullptr) {
+    for (const auto& entry : record.context->entries) {
+      event.push_back(',');
+      _FmtAppendJson(entry.first.data(), entry.first.size(), &event);
+      event.push_back(':');
+      _FmtAppendJson(entry.second.data(), entry.second.size(), &event);
+    }
+  }
+  event.append("}}");
+  std::fwrite(event.data(), 1, event.size(), sink->fd);
+}
+
+}  // namespace yeti
@@ -0,0 +1,161 @@
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+#include <cstdio>
+#include <chrono>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+#include <src/logger.h>
+
+namespace yeti {
+
+namespace {
+
+// initial size of thread buffer
+const std::size_t kStreamBufSize = 1024;
+
+// thread buffer which has grown larger is shrunk after use
+const std::size_t kMaxStreamBufSize = 64 * 1024;
+
+/** @brief Growable buffer which keeps its memory between records. */
+class LogStreamBuf : public std::streambuf {
+ public:
+  LogStreamBuf() : buffer_(kStreamBufSize) { Reset(); }
+
+  void Reset() {
+    if (buffer_.size() > kMaxStreamBufSize) {
+      std::vector<char>(kStreamBufSize).swap(buffer_);
+    }
+    setp(buffer_.data(), buffer_.data() + buffer_.size());
+  }
+
+  const char* data() const { return pbase(); }
+  std::size_t size() const { return pptr() - pbase(); }
+
+ protected:
+  int_type overflow(int_type ch) override {
+    std::size_t used = size();
+    buffer_.resize(2 * buffer_.size());
+    setp(buffer_.data(), buffer_.data() + buffer_.size());
+    pbump(static_cast<int>(used));
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(ch);
+      pbump(1);
+    }
+    return traits_type::not_eof(ch);
+  }
+
+ private:
+  std::vector<char> buffer_;
+};
+
+}  // namespace
+
+/** @brief Stream with its buffer, created once per thread. */
+struct _LogStreamState {
+  _LogStreamState() : stream(&buf), is_busy(false) {}
+
+  LogStreamBuf buf;
+  std::ostream stream;
+  bool is_busy;
+};
+
+namespace {
+
+thread_local _LogStreamState g_stream_state;
+
+}  // namespace
+
+_LogStream::_LogStream(const LogSite* site, Logger* logger)
+    : site_(site),
+      logger_(logger),
+      msg_id_(logger != nullptr ? logger->NextMsgId() : _NextMsgId()),
+      time_(std::chrono::high_resolution_clock::now()),
+      state_(&g_stream_state) {
+  if (state_->is_busy) {
+    // record is logged while another one is being written by this thread
+    // (from operator<<, etc.)
+    state_ = new _LogStreamState();
+  }
+  state_->is_busy = true;
+
+  // reset formatting state left by previous record
+  std::ostream& stream = state_->stream;
+  stream.clear();
+  stream.flags(std::ios_base::dec | std::ios_base::skipws);
+  stream.precision(6);
+  stream.width(0);
+  stream.fill(' ');
+}
+
+_LogStream::~_LogStream() {
+  Logger& logger = Logger::instance();
+  const char* msg = state_->buf.data();
+  std::size_t size = state_->buf.size();
+  if (logger_ != nullptr) {
+    // records of other loggers are filtered by their levels only
+    logger_->EnqueueRecord(site_, msg_id_, time_, msg, size);
+    logger_->AccountCall(site_, time_);
+  } else {
+    // level is checked again, but call is already counted by macro
+    const int action = logger.ResolveSite(site_, nullptr, false);
+    if (action == _kSiteLog) {
+      if (site_->level <= logger.GetBacktraceTriggerLevel()) {
+        _FlushBacktrace(site_);
+      }
+      logger.EnqueueRecord(site_, msg_id_, time_, msg, size);
+      logger.AccountCall(site_, time_);
+    } else if (action == _kSiteCapture) {
+      BacktraceRecord* record = _NextBacktraceRecord();
+      if (record != nullptr) {
+        record->site = site_;
+        record->msg_id = msg_id_;
+        record->time = time_;
+        record->format = nullptr;
+        record->is_encoded = false;
+        std::snprintf(record->args, sizeof(record->args), "%.*s",
+                      static_cast<int>(size), msg);
+      }
+    }
+    // record is dropped if its site has been turned off meanwhile
+  }
+
+  if (state_ != &g_stream_state) {
+    delete state_;
+  } else {
+    state_->buf.Reset();
+    state_->is_busy = false;
+  }
+}
+
+std::ostream& _LogStream::stream() {
+  return state_->stream;
+}
+
+}  // namespace yeti
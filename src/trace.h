@@ -0,0 +1,66 @@
+// Copyright (c) 2014, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+#ifndef INC_YETI_TRACE_H_
+#define INC_YETI_TRACE_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <thread>
+#include <src/record_queue.h>
+
+namespace yeti {
+
+/**
+ * @brief File of trace events with state of its JSON array.
+ *
+ * It's created when file is set and shared by snapshots of settings, so
+ * every trace file opens its own array (written by backend only).
+ */
+struct TraceSink {
+  explicit TraceSink(FILE* fd) : fd(fd), is_opened(false) {}
+
+  FILE* fd;
+  bool is_opened;  // the first event has opened JSON array
+  // viewers expect small numbers of threads rather than hashes
+  std::map<std::thread::id, std::uint64_t> thread_ids;
+};
+
+/** @brief Returns is record made by YETI_SCOPE. */
+bool IsSpanRecord(const LogRecord& record);
+
+/**
+ * @brief Writes span record as Chrome trace event ("X" phase) into sink.
+ *
+ * The first event written into sink opens JSON array (backend only).
+ */
+void WriteTraceEvent(const LogRecord& record, TraceSink* sink);
+
+}  // namespace yeti
+
+#endif  // INC_YETI_TRACE_H_
@@ -28,19 +28,28 @@
 #include <yeti/yeti.h>
 
 #include <csignal>
+#include <cstdarg>
 #include <cstdio>
+#include <cstring>
 #include <ctime>
 
+#include <algorithm>
 #include <iostream>
-
 #include <map>
 #include <mutex>
 #include <string>
 #include <src/logger.h>
+#include <src/sanitize.h>
+#include <src/site_profiler.h>
 
 namespace yeti {
 
-const std::map<int, std::string> SIGNAME = {
+// both are initialized statically: logger may be created (and signals may
+// be registered) by constructors of global objects, e.g. yeti::LogCategory
+const struct {
+  int num;
+  const char* name;
+} SIGNAME[] = {
     { SIGABRT, "SIGABRT" },
     { SIGFPE, "SIGFPE" },
     { SIGILL, "SIGILL" },
@@ -51,14 +60,7 @@ const std::map<int, std::string> SIGNAME = {
 
 typedef void (*__sighandler_t)(int);
 
-std::map<int, __sighandler_t> g_old_handlers = {
-    { SIGABRT, nullptr },
-    { SIGFPE, nullptr },
-    { SIGILL, nullptr },
-    { SIGINT, nullptr },
-    { SIGSEGV, nullptr },
-    { SIGTERM, nullptr }
-};
+__sighandler_t g_old_handlers[NSIG] = { nullptr };
 
 
 void SetLogLevel(LogLevel level) noexcept {
@@ -69,6 +71,164 @@ int GetLogLevel() noexcept {
   return Logger::instance().GetLevel();
 }
 
+void SetLogLevels(const std::string& levels) {
+  Logger::instance().SetLevels(levels);
+}
+
+void SetLogCategoryLevel(const std::string& pattern, LogLevel level) {
+  Logger::instance().SetCategoryLevel(pattern, level);
+}
+
+void ResetLogCategoryLevels() {
+  Logger::instance().ResetCategoryLevels();
+}
+
+int GetLogCategoryLevel(const std::string& name) {
+  return Logger::instance().GetCategoryLevel(name);
+}
+
+LogCategory::LogCategory(const char* name)
+    : name_(name), level_(LOG_LEVEL_INFO) {
+  Logger::instance().RegisterCategory(this);
+}
+
+void SetThreadLogLevel(LogLevel level) {
+  Logger::instance().SetThreadLevel(std::this_thread::get_id(), level);
+}
+
+void SetThreadLogLevel(std::thread::id thread_id, LogLevel level) {
+  Logger::instance().SetThreadLevel(thread_id, level);
+}
+
+void ResetThreadLogLevel() {
+  Logger::instance().ResetThreadLevel(std::this_thread::get_id());
+}
+
+void ResetThreadLogLevel(std::thread::id thread_id) {
+  Logger::instance().ResetThreadLevel(thread_id);
+}
+
+int GetThreadLogLevel() {
+  return Logger::instance().GetThreadLevel(std::this_thread::get_id());
+}
+
+int GetThreadLogLevel(std::thread::id thread_id) {
+  return Logger::instance().GetThreadLevel(thread_id);
+}
+
+void SetLogPressureLimits(const LogPressureLimits& limits) noexcept {
+  Logger::instance().SetPressureLimits(limits);
+}
+
+LogPressureLimits GetLogPressureLimits() noexcept {
+  return Logger::instance().GetPressureLimits();
+}
+
+bool IsLogDegraded() noexcept {
+  return Logger::instance().IsDegraded();
+}
+
+void SetLogStallPolicy(const LogStallPolicy& policy) noexcept {
+  Logger::instance().SetStallPolicy(policy);
+}
+
+LogStallPolicy GetLogStallPolicy() noexcept {
+  return Logger::instance().GetStallPolicy();
+}
+
+LogStats GetLogStats() {
+  return Logger::instance().GetStats();
+}
+
+void SetLogStatsInterval(std::chrono::milliseconds interval) noexcept {
+  Logger::instance().SetStatsInterval(interval);
+}
+
+std::chrono::milliseconds GetLogStatsInterval() noexcept {
+  return Logger::instance().GetStatsInterval();
+}
+
+int _GetEffectiveLogLevel() noexcept {
+  return Logger::instance().GetEffectiveLevel();
+}
+
+int _GetCaptureLogLevel() noexcept {
+  return Logger::instance().GetCaptureLevel();
+}
+
+void SetLogBacktrace(std::size_t size, LogLevel capture_level,
+                     LogLevel trigger_level) noexcept {
+  Logger::instance().SetBacktrace(size, capture_level, trigger_level);
+}
+
+std::size_t GetLogBacktraceSize() noexcept {
+  return Logger::instance().GetBacktraceSize();
+}
+
+void SetLogDedup(FILE* fd, std::chrono::milliseconds window) {
+  Logger::instance().SetDedupWindow(fd, window);
+}
+
+std::chrono::milliseconds GetLogDedup(FILE* fd) noexcept {
+  return Logger::instance().GetDedupWindow(fd);
+}
+
+void SetLogSanitized(FILE* fd, bool is_sanitized) {
+  Logger::instance().SetSanitized(fd, is_sanitized);
+}
+
+bool IsLogSanitized(FILE* fd) noexcept {
+  return Logger::instance().IsSanitized(fd);
+}
+
+int _ResolveLogSite(const LogSite* site, const char* format) {
+  return Logger::instance().ResolveSite(site, format);
+}
+
+std::size_t SetLogSiteMode(const LogSiteFilter& filter, LogSiteMode mode) {
+  return Logger::instance().SetSiteMode(filter, mode);
+}
+
+void ResetLogSiteModes() {
+  Logger::instance().ResetSiteModes();
+}
+
+std::vector<LogSiteInfo> GetLogSites(const LogSiteFilter& filter) {
+  return Logger::instance().GetSites(filter);
+}
+
+bool ApplyLogSiteControl(const std::string& commands) {
+  return Logger::instance().ApplySiteControl(commands);
+}
+
+bool SetLogSiteControlFile(const std::string& path) {
+  return Logger::instance().SetSiteControlFile(path);
+}
+
+void SetLogSiteProfiling(bool is_enabled) {
+  Logger::instance().SetSiteProfiling(is_enabled);
+}
+
+bool IsLogSiteProfiling() noexcept {
+  return Logger::instance().IsSiteProfiling();
+}
+
+std::vector<LogSiteProfile> GetLogSiteProfile() {
+  return SiteProfiler::instance().GetProfile();
+}
+
+void DumpSiteProfile(std::size_t count, FILE* fd) {
+  SiteProfiler::instance().Dump(count, fd);
+}
+
+bool ApplyLogConfig(const std::string& config) {
+  return Logger::instance().ApplyConfig(config);
+}
+
+bool SetLogConfigFile(const std::string& path) {
+  return Logger::instance().SetConfigFile(path);
+}
+
 void SetLogColored(bool is_colored) noexcept {
   Logger::instance().SetColored(is_colored);
 }
@@ -102,7 +262,11 @@ void ShutdownLog() {
 }
 
 void SimpleSignalHandler(int sig_num) {
-  DEBUG("caught %s: start flushing log...\n", SIGNAME.at(sig_num).c_str());
+  const char* name = "signal";
+  for (const auto& entry : SIGNAME) {
+    if (entry.num == sig_num) name = entry.name;
+  }
+  DEBUG("caught %s: start flushing log...\n", name);
   yeti::Logger::instance().Flush();
   if (g_old_handlers[sig_num]) g_old_handlers[sig_num](sig_num);
 }
@@ -115,7 +279,7 @@ void RegSignal(int sig_num) {
 
 void RegAllSignals() {
   for (const auto& entry : SIGNAME) {
-    RegSignal(entry.first);
+    RegSignal(entry.num);
   }
 }
 
@@ -123,95 +287,301 @@ void FlushLog() {
   yeti::Logger::instance().Flush();
 }
 
-std::size_t _GetMsgId() {
-  return yeti::Logger::instance().GetMsgId();
+void SetLogEngine(LogEngine engine) noexcept {
+  Logger::instance().SetEngine(engine);
 }
 
-void _IncMsgId() {
-  yeti::Logger::instance().IncMsgId();
+LogEngine GetLogEngine() noexcept {
+  return Logger::instance().GetEngine();
 }
 
-std::string _CreateLogStr(std::shared_ptr<const yeti::LogData> log_data) {
-  std::map<std::string, std::string> subs;
-  subs["%(LEVEL)"] = log_data->level;
-  subs["%(FILENAME)"] = log_data->filename;
-  subs["%(FUNCNAME)"] = log_data->funcname;
-  subs["%(MSG)"] = log_data->msg;
+void SetLogOutput(LogOutput output) noexcept {
+  Logger::instance().SetOutput(output);
+}
 
-  if (log_data->log_format.find("%(PID)") != std::string::npos) {
-    subs["%(PID)"] = std::to_string(log_data->pid);
-  }
+LogOutput GetLogOutput() noexcept {
+  return Logger::instance().GetOutput();
+}
 
-  if (log_data->log_format.find("%(TID)") != std::string::npos) {
-    std::hash<std::thread::id> hash_fn;
-    std::ostringstream oss;
-    oss << std::hex << std::uppercase << hash_fn(log_data->tid);
-    subs["%(TID)"] = oss.str();
-  }
+void SetLogTraceFile(FILE* fd) noexcept {
+  Logger::instance().SetTraceFile(fd);
+}
 
-  if (log_data->log_format.find("%(DATE)") != std::string::npos) {
-    using namespace std::chrono;
-    char date_buf[16] = { 0 };
-    auto sec = duration_cast<seconds>(log_data->time.time_since_epoch());
-    std::time_t t = sec.count();
-    std::strftime(date_buf, sizeof(date_buf), "%F", std::localtime(&t));
-    subs["%(DATE)"] = date_buf;
-  }
+FILE* GetLogTraceFile() noexcept {
+  return Logger::instance().GetTraceFile();
+}
 
-  if (log_data->log_format.find("%(TIME)") != std::string::npos) {
-    using namespace std::chrono;
-    char time_buf[32] = { 0 };
-    auto nanos = duration_cast<nanoseconds>(log_data->time.time_since_epoch());
-    auto sec = duration_cast<seconds>(log_data->time.time_since_epoch());
-    std::time_t t = sec.count();
-    std::size_t frac = nanos.count() % 1000000000;
-    std::strftime(time_buf, sizeof(time_buf), "%T", std::localtime(&t));
-    std::string time_str = std::string(time_buf) + "." + std::to_string(frac);
-    subs["%(TIME)"] = time_str;
-  }
+std::size_t _NextMsgId() {
+  return yeti::Logger::instance().NextMsgId();
+}
 
-  if (log_data->log_format.find("%(LINE)") != std::string::npos) {
-    subs["%(LINE)"] = std::to_string(log_data->line);
+std::string _CreateLogStr(const LogRecord& record, const char* msg) {
+  std::string result;
+  for (const LogFormatPiece& piece : record.config->format) {
+    switch (piece.field) {
+      case LogFormatPiece::kText:
+        result.append(piece.text);
+        break;
+      case LogFormatPiece::kLevel:
+        result.append(record.site->level_name);
+        break;
+      case LogFormatPiece::kFilename:
+        result.append(record.site->filename);
+        break;
+      case LogFormatPiece::kFuncname:
+        result.append(record.site->funcname);
+        break;
+      case LogFormatPiece::kCategory:
+        if (record.site->category != nullptr) {
+          result.append(record.site->category->GetName());
+        }
+        break;
+      case LogFormatPiece::kMsg:
+        result.append(msg);
+        break;
+      case LogFormatPiece::kContext: {
+        // value of key in context of thread (empty if there is none)
+        const std::string* value = record.context == nullptr ? nullptr
+            : record.context->Find(piece.text.data(), piece.text.size());
+        if (value == nullptr) break;
+        // context values are user text as message is, so they are escaped
+        // for sanitized sinks too
+        std::string escaped;
+        if (record.config->IsSanitized(record.fd) &&
+            SanitizeMessage(value->data(), value->size(), &escaped) !=
+                nullptr) {
+          result.append(escaped);
+        } else {
+          result.append(*value);
+        }
+        break;
+      }
+      case LogFormatPiece::kPid:
+        result.append(std::to_string(record.pid));
+        break;
+      case LogFormatPiece::kTid: {
+        std::hash<std::thread::id> hash_fn;
+        char tid_buf[32];
+        result.append(tid_buf, std::snprintf(tid_buf, sizeof(tid_buf), "%llX",
+            static_cast<unsigned long long>(hash_fn(record.tid))));
+        break;
+      }
+      case LogFormatPiece::kDate: {
+        using namespace std::chrono;
+        char date_buf[16] = { 0 };
+        auto sec = duration_cast<seconds>(record.time.time_since_epoch());
+        std::time_t t = sec.count();
+        // every logger formats records on its own backend thread
+        std::tm tm;
+        localtime_r(&t, &tm);
+        std::strftime(date_buf, sizeof(date_buf), "%F", &tm);
+        result.append(date_buf);
+        break;
+      }
+      case LogFormatPiece::kTime: {
+        using namespace std::chrono;
+        char time_buf[32] = { 0 };
+        auto nanos =
+            duration_cast<nanoseconds>(record.time.time_since_epoch());
+        auto sec = duration_cast<seconds>(record.time.time_since_epoch());
+        std::time_t t = sec.count();
+        std::size_t frac = nanos.count() % 1000000000;
+        std::tm tm;
+        localtime_r(&t, &tm);
+        std::strftime(time_buf, sizeof(time_buf), "%T", &tm);
+        result.append(time_buf);
+        result.push_back('.');
+        result.append(std::to_string(frac));
+        break;
+      }
+      case LogFormatPiece::kLine:
+        result.append(std::to_string(record.site->line));
+        break;
+      case LogFormatPiece::kMsgId:
+        result.append(std::to_string(record.msg_id));
+        break;
+    }
   }
+  return result;
+}
+
+void AppendJsonString(const char* str, std::string* out) {
+  _FmtAppendJson(str, std::strlen(str), out);
+}
 
-  if (log_data->log_format.find("%(MSG_ID)") != std::string::npos) {
-    subs["%(MSG_ID)"] = std::to_string(log_data->msg_id);
+// appends UTC time as YYYY-MM-DDTHH:MM:SS.nnnnnnnnnZ
+void AppendJsonTime(std::chrono::high_resolution_clock::time_point time,
+                    std::string* out) {
+  using namespace std::chrono;
+  // date and time of day are formatted once per second by every backend
+  static thread_local std::time_t cached_sec = -1;
+  static thread_local char cached_buf[32];
+  auto nanos = duration_cast<nanoseconds>(time.time_since_epoch()).count();
+  std::time_t sec = nanos / 1000000000;
+  if (sec != cached_sec) {
+    std::tm tm;
+    gmtime_r(&sec, &tm);
+    std::strftime(cached_buf, sizeof(cached_buf), "%Y-%m-%dT%H:%M:%S", &tm);
+    cached_sec = sec;
   }
+  char frac[16];
+  std::snprintf(frac, sizeof(frac), ".%09lldZ",
+                static_cast<long long>(nanos % 1000000000));
+  out->append(cached_buf);
+  out->append(frac);
+}
 
-  std::string result = log_data->log_format;
-  size_t pos = 0;
-  for (const auto& entry : subs) {
-    while ((pos = result.find(entry.first)) != std::string::npos) {
-      result.replace(pos, entry.first.length(), entry.second);
+std::size_t WriteJsonRecord(const LogRecord& record, FILE* fd,
+                            const char* msg, const char* fields) {
+  static thread_local std::string json;  // reused by backends
+  json.clear();
+  json.append("{\"level\":");
+  AppendJsonString(record.site->level_name, &json);
+  json.append(",\"ts\":\"");
+  AppendJsonTime(record.time, &json);
+  json.append("\",\"file\":");
+  AppendJsonString(record.site->filename, &json);
+  json.append(",\"line\":");
+  _FmtAppend(static_cast<std::int64_t>(record.site->line), &json);
+  json.append(",\"func\":");
+  AppendJsonString(record.site->funcname, &json);
+  if (record.site->category != nullptr) {
+    json.append(",\"category\":");
+    AppendJsonString(record.site->category->GetName(), &json);
+  }
+  json.append(",\"pid\":");
+  _FmtAppend(static_cast<std::int64_t>(record.pid), &json);
+  json.append(",\"tid\":\"");
+  std::hash<std::thread::id> hash_fn;
+  char tid_buf[32];
+  json.append(tid_buf, std::snprintf(tid_buf, sizeof(tid_buf), "%llX",
+      static_cast<unsigned long long>(hash_fn(record.tid))));
+  json.append("\",\"msg_id\":");
+  _FmtAppend(static_cast<std::uint64_t>(record.msg_id), &json);
+  json.append(",\"msg\":");
+  AppendJsonString(msg, &json);
+  if (record.context != nullptr) {
+    for (const auto& entry : record.context->entries) {
+      json.push_back(',');
+      _FmtAppendJson(entry.first.data(), entry.first.size(), &json);
+      json.push_back(':');
+      _FmtAppendJson(entry.second.data(), entry.second.size(), &json);
     }
   }
-  return result;
+  json.append(fields);
+  json.append("}\n");
+  return std::fwrite(json.data(), 1, json.size(), fd);
 }
 
-void _EnqueueLogTask(std::shared_ptr<LogData> log_data) {
-  log_data->log_format = yeti::Logger::instance().GetFormatStr();
-  log_data->time = std::chrono::high_resolution_clock::now();
-  log_data->pid = getpid();
-  log_data->tid = std::this_thread::get_id();
-  log_data->fd = yeti::Logger::instance().GetFileDesc();
-  bool is_colored = yeti::Logger::instance().IsColored();
+std::size_t WriteLogRecord(const LogRecord& record, FILE* fd,
+                           const char* msg, const char* fields) {
+  if (record.config->output == LogOutput::LOG_OUTPUT_JSON) {
+    return WriteJsonRecord(record, fd, msg, fields);
+  }
 
-  auto print_func = [log_data, is_colored] {
-    std::string log_str = _CreateLogStr(log_data) + "\n";
+  std::string log_str = _CreateLogStr(record, msg) + "\n";
 
 // To colorize stdout and stderr in Windows cmd.exe it is necessary
 // to include windows.h and use SetConsoleTextAttribute().
 // It is terrible, so I decided to disable coloring on WIN32 platform.
 #ifndef _WIN32
-    if (isatty(fileno(log_data->fd)) != 0 && is_colored) {
-      log_str = log_data->color + log_str + std::string(YETI_RESET);
-    }
+  if (isatty(fileno(fd)) != 0 && record.config->is_colored) {
+    log_str = record.site->color + log_str + std::string(YETI_RESET);
+  }
 #endif  // _WIN32
 
-    std::fprintf(log_data->fd, log_str.c_str());
+  return std::fwrite(log_str.data(), 1, log_str.size(), fd);
+}
+
+// returns logger to write record into: records of the default one write
+// records captured into backtrace ring of thread before them if needed
+Logger& PrepareLogger(Logger* logger, const LogSite* site) {
+  if (logger != nullptr) return *logger;
+  Logger& default_logger = Logger::instance();
+  if (site->level <= default_logger.GetBacktraceTriggerLevel()) {
+    _FlushBacktrace(site);
+  }
+  return default_logger;
+}
+
+void VLogPrintf(Logger* logger, const LogSite* site,
+                std::uint64_t suppressed, const char* fmt, va_list args) {
+  Logger& target = PrepareLogger(logger, site);
+  std::size_t msg_id = target.NextMsgId();
+  auto time = std::chrono::high_resolution_clock::now();
+
+  char suffix[32];
+  int suffix_len = 0;
+  if (suppressed > 0) {
+    suffix_len = std::snprintf(suffix, sizeof(suffix), " [%llu suppressed]",
+                               static_cast<unsigned long long>(suppressed));
+  }
+
+  // message may be formatted twice, so every pass gets its own copy of args
+  auto format = [&](char* msg, std::size_t size) {
+    va_list args_copy;
+    va_copy(args_copy, args);
+    int len = std::vsnprintf(msg, size, fmt, args_copy);
+    va_end(args_copy);
+    if (len >= 0 && suffix_len > 0) {
+      if (static_cast<std::size_t>(len + suffix_len) < size) {
+        std::memcpy(msg + len, suffix, suffix_len + 1);
+      }
+      len += suffix_len;
+    }
+    return len;
   };
+  target.EnqueueFormatted(site, msg_id, time, format);
+  target.AccountCall(site, time);
+}
+
+void _LogPrintf(const LogSite* site, const char* fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  VLogPrintf(nullptr, site, 0, fmt, args);
+  va_end(args);
+}
+
+void _LogPrintfTo(Logger* logger, const LogSite* site, const char* fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  VLogPrintf(logger, site, 0, fmt, args);
+  va_end(args);
+}
+
+void _EnqueueEncodedLog(Logger* logger, const LogSite* site, const char* args,
+                        std::size_t size) {
+  Logger& target = PrepareLogger(logger, site);
+  std::size_t msg_id = target.NextMsgId();
+  auto time = std::chrono::high_resolution_clock::now();
+  target.EnqueueRecord(site, msg_id, time, args, size, true);
+  target.AccountCall(site, time);
+}
+
+char* _ReserveEncodedLog(Logger* logger, const LogSite* site, std::size_t size,
+                         LogRecord** record) {
+  Logger& target = PrepareLogger(logger, site);
+  std::size_t msg_id = target.NextMsgId();
+  auto time = std::chrono::high_resolution_clock::now();
+  *record = target.ReserveRecord(site, msg_id, time, size, true);
+  return (*record)->msg();
+}
+
+void _CommitEncodedLog(Logger* logger, LogRecord* record) {
+  Logger& target = logger != nullptr ? *logger : Logger::instance();
+  // record may be written and released as soon as it is committed
+  const LogSite* site = record->site;
+  const auto time = record->time;
+  target.CommitRecord(record);
+  target.AccountCall(site, time);
+}
 
-  yeti::Logger::instance().EnqueueTask(print_func);
+void _LogLimitedPrintf(const LogSite* site, std::uint64_t suppressed,
+                       const char* fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  VLogPrintf(nullptr, site, suppressed, fmt, args);
+  va_end(args);
 }
 
 }  // namespace yeti
@@ -0,0 +1,100 @@
+// Copyright (c) 2014-2015, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+
+#ifndef TESTS_GATE_STREAM_H_
+#define TESTS_GATE_STREAM_H_
+
+#include <cstdio>
+
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Stream which blocks writes until it is opened.
+ *
+ * It allows tests to stop backend on the first record and build up backlog
+ * in log queue.
+ */
+class GateStream {
+ public:
+  GateStream() {
+    cookie_io_functions_t funcs = { nullptr, &GateStream::Write,
+                                    nullptr, nullptr };
+    fd_ = fopencookie(this, "w", funcs);
+    setvbuf(fd_, nullptr, _IONBF, 0);
+  }
+  ~GateStream() { std::fclose(fd_); }
+
+  FILE* fd() const { return fd_; }
+
+  /** @brief Waits until backend is blocked in write. */
+  void WaitWriting() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return is_writing_; });
+  }
+
+  /** @brief Allows all writes. */
+  void Open() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_open_ = true;
+    cv_.notify_all();
+  }
+
+  std::vector<std::string> GetLines() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> lines;
+    std::istringstream iss(data_);
+    for (std::string line; std::getline(iss, line); ) {
+      lines.push_back(line);
+    }
+    return lines;
+  }
+
+ private:
+  static ssize_t Write(void* cookie, const char* buf, size_t size) {
+    auto gate = static_cast<GateStream*>(cookie);
+    std::unique_lock<std::mutex> lock(gate->mutex_);
+    gate->is_writing_ = true;
+    gate->cv_.notify_all();
+    gate->cv_.wait(lock, [gate] { return gate->is_open_; });
+    gate->data_.append(buf, size);
+    return size;
+  }
+
+  FILE* fd_ = nullptr;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool is_open_ = false;
+  bool is_writing_ = false;
+  std::string data_;
+};
+
+#endif  // TESTS_GATE_STREAM_H_
@@ -0,0 +1,124 @@
+// Copyright (c) 2014-2015, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+
+#include <cstdio>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <yeti/yeti.h>
+
+#include "gate_stream.h"
+#include "test_util.h"
+
+
+TEST(YETI, BACKTRACE) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogFormatStr("%(LEVEL) %(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogBacktrace(3, yeti::LOG_LEVEL_DEBUG);
+  EXPECT_EQ(3u, yeti::GetLogBacktraceSize());
+
+  for (int i = 0; i < 5; ++i) {
+    // string argument is destroyed right after capturing
+    DEBUG("debug msg %d: %s", i, std::to_string(i * 10).c_str());
+    TRACE("trace msg %d", i);
+  }
+  INFO("info msg");
+  yeti::FlushLog();
+  auto lines = ReadLines(fd);
+  ASSERT_EQ(1u, lines.size());
+  EXPECT_EQ("INF info msg", lines[0]);
+
+  ERROR("error msg");
+  ERROR("error msg without backtrace");
+  yeti::FlushLog();
+  lines = ReadLines(fd);
+  ASSERT_EQ(6u, lines.size());
+  EXPECT_EQ("DBG debug msg 2: 20", lines[1]);
+  EXPECT_EQ("DBG debug msg 3: 30", lines[2]);
+  EXPECT_EQ("DBG debug msg 4: 40", lines[3]);
+  EXPECT_EQ("ERR error msg", lines[4]);
+  EXPECT_EQ("ERR error msg without backtrace", lines[5]);
+
+  yeti::SetLogBacktrace(0);
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
+
+TEST(YETI, BACKTRACE_PER_THREAD) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogFormatStr("%(LEVEL) %(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogBacktrace(10);
+
+  std::thread([] { DEBUG("debug msg from other thread"); }).join();
+  const std::string long_str(1024, 'x');
+  DEBUG("long debug msg %s", long_str.c_str());
+  ERROR("error msg");
+  yeti::FlushLog();
+
+  auto lines = ReadLines(fd);
+  ASSERT_EQ(2u, lines.size());
+  // arguments didn't fit into ring, so message was formatted and truncated
+  EXPECT_EQ(0u, lines[0].find("DBG long debug msg xxx"));
+  EXPECT_EQ("ERR error msg", lines[1]);
+
+  yeti::SetLogBacktrace(0);
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
+
+TEST(YETI, BACKTRACE_BEHIND_BACKLOG) {
+  GateStream gate;
+  yeti::SetLogFileDesc(gate.fd());
+  yeti::SetLogFormatStr("%(LEVEL) %(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogBacktrace(10);
+
+  // backend is blocked, so urgent lane is drained first once it's free
+  WRN("slow msg");
+  gate.WaitWriting();
+  DEBUG("debug msg");
+  ERROR("error msg");
+  gate.Open();
+  yeti::FlushLog();
+
+  auto lines = gate.GetLines();
+  ASSERT_EQ(3u, lines.size());
+  EXPECT_EQ("WRN slow msg", lines[0]);
+  EXPECT_EQ("DBG debug msg", lines[1]);
+  EXPECT_EQ("ERR error msg", lines[2]);
+
+  yeti::SetLogBacktrace(0);
+  yeti::SetLogFileDesc(stderr);
+}
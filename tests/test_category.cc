@@ -0,0 +1,123 @@
+// Copyright (c) 2014-2015, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+
+#include <cstdio>
+
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+#include <yeti/yeti.h>
+
+#include "test_util.h"
+
+
+yeti::LogCategory g_net_log("net");
+yeti::LogCategory g_tcp_log("net.tcp");
+yeti::LogCategory g_pool_log("db.pool");
+yeti::LogCategory g_app_log("app");
+
+
+TEST(YETI, CATEGORY_LEVELS) {
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevels("wrn, net=dbg ,db.*=trc");
+  EXPECT_EQ(yeti::LOG_LEVEL_WARNING, yeti::GetLogLevel());
+  EXPECT_EQ(yeti::LOG_LEVEL_DEBUG, g_net_log.GetLevel());
+  EXPECT_EQ(yeti::LOG_LEVEL_DEBUG, g_tcp_log.GetLevel());
+  EXPECT_EQ(yeti::LOG_LEVEL_TRACE, g_pool_log.GetLevel());
+  EXPECT_EQ(yeti::LOG_LEVEL_WARNING, g_app_log.GetLevel());
+  EXPECT_EQ(yeti::LOG_LEVEL_DEBUG, yeti::GetLogCategoryLevel("net.udp.v6"));
+
+  EXPECT_EQ("net\npool 1\ntcp\n", Capture([] {
+    DBG("global");
+    DBG_CAT(g_net_log, "net");
+    TRC_CAT(g_tcp_log, "tcp trace");
+    TRC_FMT_CAT(g_pool_log, "pool {}", 1);
+    DBG_CAT(g_app_log, "app");
+    YETI_LOG_CAT(DBG, g_tcp_log) << "tcp";
+  }));
+
+  // the most specific pattern wins
+  yeti::SetLogCategoryLevel("net.tcp", yeti::LOG_LEVEL_ERROR);
+  EXPECT_EQ(yeti::LOG_LEVEL_ERROR, g_tcp_log.GetLevel());
+  EXPECT_EQ(yeti::LOG_LEVEL_DEBUG, g_net_log.GetLevel());
+  EXPECT_EQ(yeti::LOG_LEVEL_ERROR, yeti::GetLogCategoryLevel("net.tcp.tls"));
+  EXPECT_EQ("net\n", Capture([] {
+    DBG_CAT(g_net_log, "net");
+    WRN_CAT(g_tcp_log, "tcp");
+  }));
+
+  // categories without levels follow the global level
+  yeti::ResetLogCategoryLevels();
+  yeti::SetLogLevel(yeti::LOG_LEVEL_DEBUG);
+  EXPECT_EQ(yeti::LOG_LEVEL_DEBUG, g_tcp_log.GetLevel());
+  EXPECT_EQ("tcp\n", Capture([] {
+    DBG_CAT(g_tcp_log, "tcp");
+    TRC_CAT(g_tcp_log, "tcp trace");
+  }));
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+}
+
+TEST(YETI, CATEGORY_OUTPUT) {
+  yeti::SetLogFormatStr("[%(CATEGORY)] %(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  EXPECT_EQ("[net] net\n[] global\n", Capture([] {
+    INF_CAT(g_net_log, "net");
+    INF("global");
+  }));
+
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogOutput(yeti::LOG_OUTPUT_JSON);
+  std::string json = Capture([] { INF_CAT(g_pool_log, "pool"); });
+  yeti::SetLogOutput(yeti::LOG_OUTPUT_TEXT);
+  EXPECT_NE(std::string::npos, json.find(",\"category\":\"db.pool\","));
+
+  yeti::LogSiteFilter filter;
+  filter.format = "pool";
+  std::vector<yeti::LogSiteInfo> sites = yeti::GetLogSites(filter);
+  ASSERT_EQ(1u, sites.size());
+  EXPECT_EQ("db.pool", sites[0].category);
+}
+
+TEST(YETI, CATEGORY_THREAD_LEVEL) {
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogCategoryLevel("app", yeti::LOG_LEVEL_ERROR);
+
+  // level of thread overrides level of category
+  EXPECT_EQ("worker\n", Capture([] {
+    std::thread worker([] {
+      yeti::SetThreadLogLevel(yeti::LOG_LEVEL_DEBUG);
+      DBG_CAT(g_app_log, "worker");
+      yeti::ResetThreadLogLevel();
+    });
+    worker.join();
+    WRN_CAT(g_app_log, "main");
+  }));
+  yeti::ResetLogCategoryLevels();
+}
@@ -0,0 +1,210 @@
+// Copyright (c) 2014-2015, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+
+#include <unistd.h>
+#include <cstdio>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <yeti/yeti.h>
+
+#include "test_util.h"
+
+
+TEST(YETI, CONFIG_SNAPSHOT) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogFormatStr("%(MSG)");
+  EXPECT_EQ("%(MSG)", yeti::GetLogFormatStr());
+
+  // records are written with settings they were enqueued with
+  INF("first");
+  yeti::SetLogFormatStr("<%(LEVEL)> %(FOO) %(MSG) %(LINE");
+  INF("second %s", "%(LEVEL)");
+  FILE* other_fd = std::tmpfile();
+  yeti::SetLogFileDesc(other_fd);
+  INF("third");
+  yeti::FlushLog();
+
+  auto lines = ReadLines(fd);
+  ASSERT_EQ(2u, lines.size());
+  EXPECT_EQ("first", lines[0]);
+  // unknown keywords are written as is, keywords in message aren't replaced
+  EXPECT_EQ("<INF> %(FOO) second %(LEVEL) %(LINE", lines[1]);
+  lines = ReadLines(other_fd);
+  ASSERT_EQ(1u, lines.size());
+  EXPECT_EQ("<INF> %(FOO) third %(LINE", lines[0]);
+
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+  std::fclose(other_fd);
+}
+
+TEST(YETI, CONFIG_CONCURRENT_CHANGES) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogDedup(fd, std::chrono::milliseconds(60000));
+
+  const int kThreads = 4;
+  const int kRecords = 2000;
+  std::atomic<bool> is_done(false);
+  std::thread setter([&is_done] {
+    for (int i = 0; !is_done; ++i) {
+      yeti::SetLogFormatStr(i % 2 == 0 ? "%(MSG)" : "%(LEVEL) %(MSG)");
+      yeti::SetLogColored(i % 3 == 0);
+    }
+  });
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back([i] {
+      for (int j = 0; j < kRecords; ++j) {
+        INF("record %d of thread %d", j, i);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  // run of repeated records outlives settings it was started with
+  for (int i = 0; i < 10; ++i) {
+    INF("repeated");
+  }
+  is_done = true;
+  setter.join();
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogDedup(fd, std::chrono::milliseconds(0));
+  yeti::FlushLog();
+
+  auto lines = ReadLines(fd);
+  ASSERT_EQ(kThreads * kRecords + 2u, lines.size());
+  for (int i = 0; i < kThreads * kRecords; ++i) {
+    EXPECT_NE(std::string::npos, lines[i].find("record "));
+  }
+  EXPECT_NE(std::string::npos, lines.back().find("repeated 9 times"));
+
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
+
+TEST(YETI, CONFIG_APPLY) {
+  char path[] = "/tmp/yeti_sink_XXXXXX";
+  int file_desc = mkstemp(path);
+  ASSERT_NE(-1, file_desc);
+  close(file_desc);
+
+  EXPECT_TRUE(yeti::ApplyLogConfig(
+      "# comment\n"
+      "\n"
+      "level = warn, cfg.* = dbg\n"
+      "format = %(LEVEL) %(MSG)\n"
+      "colored = off\n"
+      "file = " + std::string(path) + "\n"
+      "dedup = 60000\n"));
+  EXPECT_EQ(yeti::LOG_LEVEL_WARNING, yeti::GetLogLevel());
+  EXPECT_EQ(yeti::LOG_LEVEL_DEBUG, yeti::GetLogCategoryLevel("cfg.test"));
+  EXPECT_EQ("%(LEVEL) %(MSG)", yeti::GetLogFormatStr());
+  EXPECT_FALSE(yeti::IsLogColored());
+  FILE* fd = yeti::GetLogFileDesc();
+  EXPECT_NE(stderr, fd);
+  EXPECT_EQ(60000, yeti::GetLogDedup(fd).count());
+
+  INF("filtered");
+  for (int i = 0; i < 2; ++i) {
+    WRN("written");
+  }
+  // missing keys keep their values, invalid lines are skipped
+  EXPECT_FALSE(yeti::ApplyLogConfig("output = xml\nunknown = 1\nlevel\n"
+                                    "dedup = 0\n"));
+  EXPECT_EQ(yeti::LOG_LEVEL_WARNING, yeti::GetLogLevel());
+  EXPECT_EQ(fd, yeti::GetLogFileDesc());
+  EXPECT_EQ(yeti::LOG_OUTPUT_TEXT, yeti::GetLogOutput());
+
+  // file opened by config is closed when config switches to another one
+  EXPECT_TRUE(yeti::ApplyLogConfig("file = stderr\nlevel = info\n"
+                                   "format = %(MSG)\ncolored = on\n"));
+  EXPECT_EQ(stderr, yeti::GetLogFileDesc());
+  yeti::ResetLogCategoryLevels();
+  yeti::FlushLog();
+
+  std::ifstream input(path);
+  std::string line;
+  ASSERT_TRUE(static_cast<bool>(std::getline(input, line)));
+  EXPECT_EQ("WRN written", line);
+  ASSERT_TRUE(static_cast<bool>(std::getline(input, line)));
+  EXPECT_EQ(0u, line.find("WRN last message repeated 1 times in "));
+  EXPECT_FALSE(static_cast<bool>(std::getline(input, line)));
+  std::remove(path);
+}
+
+TEST(YETI, CONFIG_FILE) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogFormatStr("%(MSG)");
+
+  char path[] = "/tmp/yeti_config_XXXXXX";
+  int file_desc = mkstemp(path);
+  ASSERT_NE(-1, file_desc);
+  close(file_desc);
+  std::ofstream(path) << "level = err\n";
+  EXPECT_TRUE(yeti::SetLogConfigFile(path));
+  EXPECT_EQ(yeti::LOG_LEVEL_ERROR, yeti::GetLogLevel());
+
+  // modified file is applied by backend
+  std::ofstream(path) << "level = dbg\nformat = <%(MSG)>\n";
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (yeti::GetLogLevel() != yeti::LOG_LEVEL_DEBUG &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+  EXPECT_EQ(yeti::LOG_LEVEL_DEBUG, yeti::GetLogLevel());
+  DBG("reloaded");
+  yeti::FlushLog();
+  auto lines = ReadLines(fd);
+  ASSERT_EQ(1u, lines.size());
+  EXPECT_EQ("<reloaded>", lines[0]);
+
+  EXPECT_TRUE(yeti::SetLogConfigFile(""));
+  EXPECT_FALSE(yeti::SetLogConfigFile("/nonexistent/yeti.conf"));
+  EXPECT_TRUE(yeti::SetLogConfigFile(""));
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+  std::remove(path);
+}
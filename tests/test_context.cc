@@ -0,0 +1,158 @@
+// Copyright (c) 2014-2015, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+
+#include <cstdio>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <yeti/yeti.h>
+
+#include "test_util.h"
+
+
+TEST(YETI, CONTEXT) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogFormatStr("<%(CTX:req)|%(CTX:tenant)> %(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+
+  INF("no context");
+  {
+    YETI_CONTEXT("req", "r1");
+    INF("outer");
+    {
+      YETI_CONTEXT("tenant", std::string("acme"));
+      YETI_CONTEXT("req", "r2");
+      INF_FMT("inner {}", 1);
+      std::thread([] { INF("other thread"); }).join();
+      yeti::FlushLog();
+    }
+    INF("outer again");
+  }
+  INF("done");
+  yeti::FlushLog();
+
+  std::vector<std::string> lines = ReadLines(fd);
+  ASSERT_EQ(6u, lines.size());
+  EXPECT_EQ("<|> no context", lines[0]);
+  EXPECT_EQ("<r1|> outer", lines[1]);
+  EXPECT_EQ("<r2|acme> inner 1", lines[2]);
+  EXPECT_EQ("<|> other thread", lines[3]);
+  EXPECT_EQ("<r1|> outer again", lines[4]);
+  EXPECT_EQ("<|> done", lines[5]);
+
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
+
+TEST(YETI, CONTEXT_OVERFLOW) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogFormatStr("<%(CTX:k0)|%(CTX:last)> %(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+
+  {
+    std::vector<std::unique_ptr<yeti::LogContext>> contexts;
+    for (std::size_t i = 0; i < yeti::kLogContextCapacity; ++i) {
+      contexts.emplace_back(
+          new yeti::LogContext(("k" + std::to_string(i)).c_str(), "v"));
+    }
+    YETI_CONTEXT("last", "lost");
+    INF("full");
+  }
+  YETI_CONTEXT("last", "kept");
+  INF("empty");
+  yeti::FlushLog();
+
+  std::vector<std::string> lines = ReadLines(fd);
+  ASSERT_EQ(2u, lines.size());
+  EXPECT_EQ("<v|> full", lines[0]);
+  EXPECT_EQ("<|kept> empty", lines[1]);
+
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
+
+TEST(YETI, CONTEXT_JSON) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogOutput(yeti::LOG_OUTPUT_JSON);
+
+  {
+    YETI_CONTEXT("req", "r\"1");
+    INF_FMT("hello", yeti::KV("n", 1));
+  }
+  yeti::FlushLog();
+
+  std::vector<std::string> lines = ReadLines(fd);
+  ASSERT_EQ(1u, lines.size());
+  EXPECT_NE(std::string::npos,
+            lines[0].find("\"msg\":\"hello\",\"req\":\"r\\\"1\",\"n\":1}"))
+      << lines[0];
+
+  yeti::SetLogOutput(yeti::LOG_OUTPUT_TEXT);
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
+
+TEST(YETI, CONTEXT_BACKTRACE) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogFormatStr("<%(CTX:req)> %(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogBacktrace(10);
+
+  // captured records keep context of requests which they belong to
+  {
+    YETI_CONTEXT("req", "r1");
+    DBG("step of r1");
+  }
+  {
+    YETI_CONTEXT("req", "r2");
+    DBG_FMT("step of {}", "r2");
+    YETI_LOG(DBG) << "stream step of r2";
+    ERR("r2 failed");
+  }
+  yeti::FlushLog();
+
+  std::vector<std::string> lines = ReadLines(fd);
+  ASSERT_EQ(4u, lines.size());
+  EXPECT_EQ("<r1> step of r1", lines[0]);
+  EXPECT_EQ("<r2> step of r2", lines[1]);
+  EXPECT_EQ("<r2> stream step of r2", lines[2]);
+  EXPECT_EQ("<r2> r2 failed", lines[3]);
+
+  yeti::SetLogBacktrace(0);
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
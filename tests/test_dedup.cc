@@ -0,0 +1,116 @@
+// Copyright (c) 2014-2015, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+
+#include <cstdio>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <yeti/yeti.h>
+
+#include "test_util.h"
+
+
+void LogRepeated(int count, int value) {
+  for (int i = 0; i < count; ++i) {
+    INFO("value is %d", value);
+  }
+}
+
+
+TEST(YETI, DEDUP) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogDedup(fd, std::chrono::milliseconds(60000));
+  EXPECT_EQ(60000, yeti::GetLogDedup(fd).count());
+  EXPECT_EQ(0, yeti::GetLogDedup(stderr).count());
+
+  LogRepeated(100, 1);
+  LogRepeated(1, 2);
+  LogRepeated(1, 2);
+  INFO("value is %d", 2);  // same message from another call site
+  yeti::FlushLog();
+
+  auto lines = ReadLines(fd);
+  ASSERT_EQ(5u, lines.size());
+  EXPECT_EQ("value is 1", lines[0]);
+  EXPECT_EQ(0u, lines[1].find("last message repeated 99 times in "));
+  EXPECT_EQ("value is 2", lines[2]);
+  EXPECT_EQ(0u, lines[3].find("last message repeated 1 times in "));
+  EXPECT_EQ("value is 2", lines[4]);
+
+  yeti::SetLogDedup(fd, std::chrono::milliseconds(0));
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
+
+TEST(YETI, DEDUP_WINDOW) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogDedup(fd, std::chrono::milliseconds(1));
+
+  LogRepeated(1, 1);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  LogRepeated(1, 1);
+  yeti::SetLogDedup(fd, std::chrono::milliseconds(0));
+  LogRepeated(2, 1);
+  yeti::FlushLog();
+
+  EXPECT_EQ(4u, ReadLines(fd).size());
+
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
+
+TEST(YETI, DEDUP_SILENCE) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogDedup(fd, std::chrono::milliseconds(20));
+
+  // summary of burst is written when window passes, without next record
+  LogRepeated(10, 1);
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  auto lines = ReadLines(fd);
+  ASSERT_EQ(2u, lines.size());
+  EXPECT_EQ("value is 1", lines[0]);
+  EXPECT_EQ(0u, lines[1].find("last message repeated 9 times in "));
+
+  yeti::SetLogDedup(fd, std::chrono::milliseconds(0));
+  yeti::SetLogFileDesc(stderr);
+  yeti::FlushLog();
+  std::fclose(fd);
+}
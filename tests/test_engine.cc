@@ -0,0 +1,135 @@
+// Copyright (c) 2014-2015, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+
+#include <cstdio>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <yeti/yeti.h>
+
+#include "gate_stream.h"
+
+
+int CountLines(FILE* fd) {
+  std::fflush(fd);
+  std::rewind(fd);
+  int count = 0;
+  for (int c = std::fgetc(fd); c != EOF; c = std::fgetc(fd)) {
+    if (c == '\n') ++count;
+  }
+  return count;
+}
+
+void WriteFromThreads(int thread_count, int msg_count) {
+  std::vector<std::thread> threads;
+  for (int i = 0; i < thread_count; ++i) {
+    threads.emplace_back([i, msg_count] {
+      for (int j = 0; j < msg_count; ++j) {
+        INFO("thread %d: msg %d", i, j);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+}
+
+
+TEST(YETI, COMBINING_ENGINE) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogEngine(yeti::LOG_ENGINE_COMBINING);
+  EXPECT_EQ(yeti::LOG_ENGINE_COMBINING, yeti::GetLogEngine());
+
+  WriteFromThreads(8, 1000);
+  yeti::FlushLog();
+  EXPECT_EQ(8 * 1000, CountLines(fd));
+
+  // timer has to write records left by the last combiner without any flush
+  INFO("single msg");
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(8 * 1000 + 1, CountLines(fd));
+
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
+
+TEST(YETI, SWITCH_ENGINE) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+
+  int expected_count = 0;
+  for (int i = 0; i < 4; ++i) {
+    yeti::SetLogEngine(i % 2 ? yeti::LOG_ENGINE_THREAD
+                             : yeti::LOG_ENGINE_COMBINING);
+    WriteFromThreads(4, 500);
+    expected_count += 4 * 500;
+  }
+  yeti::FlushLog();
+  EXPECT_EQ(expected_count, CountLines(fd));
+
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
+
+TEST(YETI, SWITCH_ENGINE_TIMER) {
+  yeti::SetLogEngine(yeti::LOG_ENGINE_THREAD);
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::FlushLog();
+  // let backend go to sleep waiting for records
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  GateStream gate;
+  yeti::SetLogFileDesc(gate.fd());
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogEngine(yeti::LOG_ENGINE_COMBINING);
+
+  // the second record is enqueued while the first one is being written by
+  // combiner, so it's left for timer of backend
+  std::thread combiner([] { INFO("first msg"); });
+  gate.WaitWriting();
+  INFO("second msg");
+  gate.Open();
+  combiner.join();
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  auto lines = gate.GetLines();
+  ASSERT_EQ(2u, lines.size());
+  EXPECT_EQ("first msg", lines[0]);
+  EXPECT_EQ("second msg", lines[1]);
+
+  yeti::SetLogFileDesc(stderr);
+  yeti::FlushLog();
+  yeti::SetLogEngine(yeti::LOG_ENGINE_THREAD);
+}
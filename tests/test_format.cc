@@ -0,0 +1,147 @@
+// Copyright (c) 2014-2015, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+
+#include <cstdio>
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <yeti/yeti.h>
+
+#include "test_util.h"
+
+
+struct Point {
+  int x;
+  int y;
+};
+
+template <> struct yeti::Formatter<Point> {
+  static void Format(const Point& point, std::string* out) {
+    *out += "(" + std::to_string(point.x) + ", " + std::to_string(point.y) + ")";
+  }
+};
+
+
+TEST(YETI, FORMAT) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+
+  const std::string name = "db";
+  const char* null_str = nullptr;
+  int value = 42;
+  INF_FMT("no arguments");
+  INF_FMT("{} = {}, {}", name, -17, std::numeric_limits<std::uint64_t>::max());
+  INF_FMT("{} {} {} {}", 0.1, 1.5f, true, 'c');
+  INF_FMT("{}:{}:{}", "literal", null_str, std::string("temporary"));
+  INF_FMT("{{}} {{{}}}", value);
+  INF_FMT("point {}", Point{1, 2});
+  INF_FMT("{}", static_cast<const void*>(nullptr));
+  DBG_FMT("not written {}", value);
+  yeti::FlushLog();
+
+  auto lines = ReadLines(fd);
+  ASSERT_EQ(7u, lines.size());
+  EXPECT_EQ("no arguments", lines[0]);
+  EXPECT_EQ("db = -17, 18446744073709551615", lines[1]);
+  EXPECT_EQ("0.1 1.5 true c", lines[2]);
+  EXPECT_EQ("literal:(null):temporary", lines[3]);
+  EXPECT_EQ("{} {42}", lines[4]);
+  EXPECT_EQ("point (1, 2)", lines[5]);
+  EXPECT_EQ("0x0", lines[6]);
+
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
+
+TEST(YETI, FORMAT_LONG_ARGS) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+
+  const std::string payload(1000, 'x');
+  INF_FMT("[{}] {}", payload.size(), payload);
+  yeti::FlushLog();
+
+  auto lines = ReadLines(fd);
+  ASSERT_EQ(1u, lines.size());
+  EXPECT_EQ("[1000] " + payload, lines[0]);
+
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
+
+TEST(YETI, FORMAT_LONG_LITERAL) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+
+#define X64 "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
+#define X1K X64 X64 X64 X64 X64 X64 X64 X64 X64 X64 X64 X64 X64 X64 X64 X64
+  // parsing of format isn't limited by depth of constexpr evaluation
+  INF_FMT("{} " X1K " {{{}}} " X1K X1K " {}", 1, 2, 3);
+#undef X1K
+#undef X64
+  yeti::FlushLog();
+
+  const std::string x1k(1024, 'x');
+  auto lines = ReadLines(fd);
+  ASSERT_EQ(1u, lines.size());
+  EXPECT_EQ("1 " + x1k + " {2} " + x1k + x1k + " 3", lines[0]);
+
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
+
+TEST(YETI, FORMAT_BACKTRACE) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogBacktrace(4);
+
+  DBG_FMT("step {} of {}", 1, std::string("request"));
+  ERR_FMT("failed");
+  yeti::FlushLog();
+
+  auto lines = ReadLines(fd);
+  ASSERT_EQ(2u, lines.size());
+  EXPECT_EQ("step 1 of request", lines[0]);
+  EXPECT_EQ("failed", lines[1]);
+
+  yeti::SetLogBacktrace(0);
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
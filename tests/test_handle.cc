@@ -0,0 +1,180 @@
+// Copyright (c) 2014-2015, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+
+#include <cstdio>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <yeti/yeti.h>
+
+#include "test_util.h"
+
+
+std::size_t CountLines(const std::string& content) {
+  std::size_t count = 0;
+  for (char c : content) {
+    if (c == '\n') ++count;
+  }
+  return count;
+}
+
+
+TEST(YETI, HANDLE) {
+  FILE* default_fd = std::tmpfile();
+  yeti::SetLogFileDesc(default_fd);
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  EXPECT_EQ(yeti::GetLogLevel(), yeti::LogHandle::Default().GetLevel());
+
+  FILE* fd = std::tmpfile();
+  yeti::LogHandleOptions options;
+  options.fd = fd;
+  options.format_str = "%(LEVEL) %(MSG)";
+  yeti::LogHandle handle(options);
+  EXPECT_EQ(yeti::LOG_LEVEL_INFO, handle.GetLevel());
+  EXPECT_EQ(fd, handle.GetFileDesc());
+
+  INF("default");
+  INF_TO(handle, "printf %d", 1);
+  INF_FMT_TO(handle, "fmt {}", 2);
+  YETI_LOG_TO(INF, handle) << "stream " << 3;
+  DBG_TO(handle, "filtered");
+  handle.Flush();
+  yeti::FlushLog();
+  EXPECT_EQ("INF printf 1\nINF fmt 2\nINF stream 3\n", ReadAll(fd));
+  EXPECT_EQ("default\n", ReadAll(default_fd));
+
+  // level of handle doesn't affect the default logger and vice versa
+  handle.SetLevel(yeti::LOG_LEVEL_DEBUG);
+  yeti::SetLogLevel(yeti::LOG_LEVEL_ERROR);
+  DBG_TO(handle, "debug");
+  INF("filtered");
+  handle.Flush();
+  yeti::FlushLog();
+  EXPECT_EQ("INF printf 1\nINF fmt 2\nINF stream 3\nDBG debug\n",
+            ReadAll(fd));
+  EXPECT_EQ("default\n", ReadAll(default_fd));
+
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(default_fd);
+  std::fclose(fd);
+}
+
+TEST(YETI, HANDLE_SHARED_WORKER) {
+  FILE* fd = std::tmpfile();
+  yeti::LogHandleOptions options;
+  options.fd = fd;
+  options.format_str = "%(MSG)";
+  {
+    yeti::LogHandle worker(options);
+    options.worker = &worker;
+    yeti::LogHandle shared(options);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+      threads.emplace_back([&] {
+        for (int j = 0; j < 1000; ++j) {
+          INF_TO(shared, "shared %d", j);
+          INF_TO(worker, "worker %d", j);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    shared.Flush();
+    worker.Flush();
+    EXPECT_EQ(8000u, CountLines(ReadAll(fd)));
+  }
+
+  // queued records are written when handle is destroyed, and instance
+  // sharing thread of destroyed worker drains its queue by itself
+  options.worker = nullptr;
+  std::unique_ptr<yeti::LogHandle> worker(new yeti::LogHandle(options));
+  options.worker = worker.get();
+  std::unique_ptr<yeti::LogHandle> shared(new yeti::LogHandle(options));
+  INF_TO(*shared, "before");
+  worker.reset();
+  INF_TO(*shared, "after");
+  shared.reset();
+  EXPECT_EQ(8002u, CountLines(ReadAll(fd)));
+  std::fclose(fd);
+}
+
+TEST(YETI, HANDLE_COMBINING) {
+  FILE* fd = std::tmpfile();
+  yeti::LogHandleOptions options;
+  options.fd = fd;
+  options.format_str = "%(MSG)";
+  options.engine = yeti::LOG_ENGINE_COMBINING;
+  yeti::LogHandle handle(options);
+
+  // producer writes its record by itself when nobody else combines
+  INF_TO(handle, "combined %d", 1);
+  EXPECT_EQ("combined 1\n", ReadAll(fd));
+
+  std::fclose(fd);
+}
+
+TEST(YETI, HANDLE_DIAGNOSTICS) {
+  FILE* default_fd = std::tmpfile();
+  yeti::SetLogFileDesc(default_fd);
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+
+  FILE* fd = std::tmpfile();
+  yeti::LogHandleOptions options;
+  options.fd = fd;
+  options.format_str = "%(MSG)";
+  yeti::LogHandle handle(options);
+  handle.SetStatsInterval(std::chrono::milliseconds(10));
+
+  // counters of instance are logged into instance, not the default logger
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  std::string content;
+  while (content.find("log stats: ") == std::string::npos &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    handle.Flush();
+    content = ReadAll(fd);
+  }
+  EXPECT_NE(std::string::npos, content.find("log stats: enqueued "));
+  handle.SetStatsInterval(std::chrono::milliseconds(0));
+  yeti::FlushLog();
+  EXPECT_EQ("", ReadAll(default_fd));
+
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(default_fd);
+  std::fclose(fd);
+}
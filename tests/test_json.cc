@@ -0,0 +1,130 @@
+// Copyright (c) 2014-2015, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+
+#include <cstdio>
+#include <cstring>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <yeti/yeti.h>
+
+#include "test_util.h"
+
+
+// returns JSON object without ts, pid and tid members which vary
+std::string StripVarying(const std::string& line) {
+  std::string result = line;
+  for (const char* key : {"\"ts\":\"", "\"tid\":\""}) {
+    std::size_t begin = result.find(key);
+    if (begin == std::string::npos) return "bad: " + line;
+    std::size_t end = result.find('"', begin + std::strlen(key));
+    result.erase(begin, end - begin + 2);
+  }
+  std::size_t begin = result.find("\"pid\":");
+  if (begin == std::string::npos) return "bad: " + line;
+  result.erase(begin, result.find(',', begin) - begin + 1);
+  begin = result.find("\"msg_id\":");
+  if (begin == std::string::npos) return "bad: " + line;
+  result.erase(begin, result.find(',', begin) - begin + 1);
+  return result;
+}
+
+
+TEST(YETI, JSON_OUTPUT) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogOutput(yeti::LOG_OUTPUT_JSON);
+  EXPECT_EQ(yeti::LOG_OUTPUT_JSON, yeti::GetLogOutput());
+
+  const std::string clean(40, 'a');
+  const std::string name = "b\"o\\b";
+  INF("plain %d", 1); const int plain_line = __LINE__;
+  INF_FMT("user {} logged in", name, yeti::KV("id", 42),
+          yeti::KV("ratio", 0.5), yeti::KV("ok", true),
+          yeti::KV("who", "it's \"me\""));
+  INF_FMT("{}\t{}\x01\xd0\xb9\xff", clean, clean);
+  INF_FMT("nan", yeti::KV("value", std::numeric_limits<double>::quiet_NaN()),
+          yeti::KV("c", '"'));
+  yeti::FlushLog();
+
+  std::vector<std::string> lines = ReadLines(fd);
+  ASSERT_EQ(4u, lines.size());
+
+  EXPECT_EQ(0u, lines[0].find("{\"level\":\"INF\",\"ts\":\"")) << lines[0];
+  std::size_t ts = lines[0].find("\"ts\":\"") + 6;
+  std::string time = lines[0].substr(ts, lines[0].find('"', ts) - ts);
+  EXPECT_EQ(30u, time.size()) << time;
+  EXPECT_EQ('T', time[10]);
+  EXPECT_EQ('.', time[19]);
+  EXPECT_EQ('Z', time.back());
+
+  EXPECT_EQ("{\"level\":\"INF\",\"file\":\"" __FILE__ "\",\"line\":" +
+            std::to_string(plain_line) + ",\"func\":\"TestBody\","
+            "\"msg\":\"plain 1\"}",
+            StripVarying(lines[0]));
+  EXPECT_NE(std::string::npos,
+            lines[1].find("\"msg\":\"user b\\\"o\\\\b logged in\","
+                          "\"id\":42,\"ratio\":0.5,\"ok\":true,"
+                          "\"who\":\"it's \\\"me\\\"\"}"))
+      << lines[1];
+  EXPECT_NE(std::string::npos,
+            lines[2].find("\"msg\":\"" + clean + "\\t" + clean +
+                          "\\u0001\xd0\xb9\\ufffd\"}"))
+      << lines[2];
+  EXPECT_NE(std::string::npos,
+            lines[3].find("\"msg\":\"nan\",\"value\":\"nan\",\"c\":\"\\\"\"}"))
+      << lines[3];
+
+  yeti::SetLogOutput(yeti::LOG_OUTPUT_TEXT);
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
+
+TEST(YETI, TEXT_FIELDS) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+
+  INF_FMT("request {} done", 7, yeti::KV("ms", 12.5),
+          yeti::KV("user", std::string("bob")));
+  INF_FMT("{} {}", yeti::KV("first", 1u), "a", 'b');
+  yeti::FlushLog();
+
+  std::vector<std::string> lines = ReadLines(fd);
+  ASSERT_EQ(2u, lines.size());
+  EXPECT_EQ("request 7 done ms=12.5 user=bob", lines[0]);
+  EXPECT_EQ("a b first=1", lines[1]);
+
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
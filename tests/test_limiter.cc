@@ -0,0 +1,107 @@
+// Copyright (c) 2014-2015, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <yeti/yeti.h>
+
+#include "test_util.h"
+
+
+class LimiterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    fd_ = std::tmpfile();
+    yeti::SetLogFileDesc(fd_);
+    yeti::SetLogFormatStr("%(MSG)");
+    yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  }
+
+  void TearDown() override {
+    yeti::SetLogFileDesc(stderr);
+    std::fclose(fd_);
+  }
+
+  std::vector<std::string> GetLines() {
+    yeti::FlushLog();
+    return ReadLines(fd_);
+  }
+
+  FILE* fd_ = nullptr;
+};
+
+
+TEST_F(LimiterTest, EVERY_N) {
+  for (int i = 0; i < 100; ++i) {
+    INF_EVERY_N(10, "msg %d", i);
+    DBG_EVERY_N(10, "filtered msg %d", i);
+  }
+  auto lines = GetLines();
+  ASSERT_EQ(10u, lines.size());
+  EXPECT_EQ("msg 0", lines[0]);
+  EXPECT_EQ("msg 10 [9 suppressed]", lines[1]);
+  EXPECT_EQ("msg 90 [9 suppressed]", lines[9]);
+}
+
+TEST_F(LimiterTest, EVERY_MS) {
+  for (int i = 0; i < 100; ++i) {
+    WRN_EVERY_MS(60000, "msg %d", i);
+  }
+  auto lines = GetLines();
+  ASSERT_EQ(1u, lines.size());
+  EXPECT_EQ("msg 0", lines[0]);
+}
+
+TEST_F(LimiterTest, FIRST_N) {
+  for (int i = 0; i < 100; ++i) {
+    ERR_FIRST_N(3, "msg %d", i);
+  }
+  auto lines = GetLines();
+  ASSERT_EQ(3u, lines.size());
+  EXPECT_EQ("msg 2", lines[2]);
+}
+
+TEST_F(LimiterTest, SAMPLED) {
+  const int count = 10000;
+  for (int i = 0; i < count; ++i) {
+    INF_SAMPLED(0.0, "never %d", i);
+    INF_SAMPLED(1.0, "always %d", i);
+  }
+  EXPECT_EQ(static_cast<std::size_t>(count), GetLines().size());
+
+  for (int i = 0; i < count; ++i) {
+    CRT_SAMPLED(0.5, "sampled %d", i);
+  }
+  auto sampled = GetLines().size() - count;
+  EXPECT_LT(count * 0.4, sampled);
+  EXPECT_GT(count * 0.6, sampled);
+}
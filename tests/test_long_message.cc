@@ -0,0 +1,89 @@
+// Copyright (c) 2014-2015, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <yeti/yeti.h>
+
+#include "test_util.h"
+
+
+std::vector<std::string> MakeMessages() {
+  // lengths around slot boundaries, several slots and more than a chunk
+  std::vector<std::string> msgs;
+  for (std::size_t len : {0, 1, 100, 150, 160, 170, 200, 255, 256, 512, 513,
+                          4096, 100000}) {
+    std::string msg;
+    for (std::size_t i = 0; i < len; ++i) {
+      msg.push_back('a' + i % 26);
+    }
+    msgs.push_back(msg);
+  }
+  return msgs;
+}
+
+void CheckLongMessages(yeti::LogEngine engine) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogEngine(engine);
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+
+  auto msgs = MakeMessages();
+  for (int pass = 0; pass < 20; ++pass) {
+    for (const auto& msg : msgs) {
+      INFO("%s", msg.c_str());
+    }
+  }
+  INF_EVERY_N(1, "%s", msgs.back().c_str());
+  yeti::FlushLog();
+
+  auto lines = ReadLines(fd);
+  ASSERT_EQ(20 * msgs.size() + 1, lines.size());
+  for (std::size_t i = 0; i + 1 < lines.size(); ++i) {
+    EXPECT_EQ(msgs[i % msgs.size()], lines[i]);
+  }
+  EXPECT_EQ(msgs.back(), lines.back());
+
+  yeti::SetLogFileDesc(stderr);
+  yeti::SetLogEngine(yeti::LOG_ENGINE_THREAD);
+  std::fclose(fd);
+}
+
+
+TEST(YETI, LONG_MESSAGE) {
+  CheckLongMessages(yeti::LOG_ENGINE_THREAD);
+}
+
+TEST(YETI, LONG_MESSAGE_COMBINING) {
+  CheckLongMessages(yeti::LOG_ENGINE_COMBINING);
+}
@@ -41,7 +41,9 @@ void ShowSimpleTestMsg() {
 }
 
 
-TEST(YETI, PERFORMANCE_TEST) {
+void MeasureEngine(yeti::LogEngine engine) {
+  yeti::SetLogEngine(engine);
+
   std::chrono::time_point<std::chrono::system_clock> start, end;
   start = std::chrono::system_clock::now();
 
@@ -56,3 +58,12 @@ TEST(YETI, PERFORMANCE_TEST) {
   std::cerr << "elapsed time to print " << logged_msg << ": "
             << elapsed_time.count() << " sec" << std::endl;
 }
+
+
+TEST(YETI, PERFORMANCE_TEST) {
+  MeasureEngine(yeti::LOG_ENGINE_THREAD);
+}
+
+TEST(YETI, PERFORMANCE_TEST_COMBINING) {
+  MeasureEngine(yeti::LOG_ENGINE_COMBINING);
+}
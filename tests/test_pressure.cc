@@ -0,0 +1,91 @@
+// Copyright (c) 2014-2015, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+#include <yeti/yeti.h>
+
+#include "gate_stream.h"
+
+
+bool WaitDegraded(bool is_degraded) {
+  for (int i = 0; i < 1000 && yeti::IsLogDegraded() != is_degraded; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return yeti::IsLogDegraded() == is_degraded;
+}
+
+int CountLines(const std::vector<std::string>& lines, const std::string& str) {
+  int count = 0;
+  for (const auto& line : lines) {
+    if (line.find(str) != std::string::npos) ++count;
+  }
+  return count;
+}
+
+
+TEST(YETI, DEGRADE_LEVEL_BY_QUEUE_DEPTH) {
+  GateStream gate;
+  yeti::SetLogFileDesc(gate.fd());
+  yeti::SetLogLevel(yeti::LOG_LEVEL_TRACE);
+  yeti::SetLogPressureLimits({100, 10, std::chrono::milliseconds(0),
+                              std::chrono::milliseconds(0),
+                              yeti::LOG_LEVEL_INFO});
+  EXPECT_EQ(100u, yeti::GetLogPressureLimits().queue_high_water);
+
+  // block backend on the first record and build up backlog
+  INFO("first msg");
+  gate.WaitWriting();
+  for (int i = 0; i < 1000; ++i) {
+    DEBUG("queued debug msg %d", i);
+  }
+  gate.Open();
+
+  ASSERT_TRUE(WaitDegraded(true));
+  EXPECT_EQ(yeti::LOG_LEVEL_TRACE, yeti::GetLogLevel());
+  DEBUG("dropped debug msg");
+  INFO("passed info msg");
+
+  yeti::FlushLog();
+  ASSERT_TRUE(WaitDegraded(false));
+  DEBUG("restored debug msg");
+  yeti::FlushLog();
+
+  auto lines = gate.GetLines();
+  EXPECT_EQ(1000, CountLines(lines, "queued debug msg"));
+  EXPECT_EQ(0, CountLines(lines, "dropped debug msg"));
+  EXPECT_EQ(1, CountLines(lines, "passed info msg"));
+  EXPECT_EQ(1, CountLines(lines, "restored debug msg"));
+  EXPECT_EQ(1, CountLines(lines, "logging level is degraded to INFO"));
+  EXPECT_EQ(1, CountLines(lines, "logging level is restored to TRACE"));
+
+  yeti::SetLogFileDesc(stderr);
+}
@@ -0,0 +1,86 @@
+// Copyright (c) 2014-2015, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <string>
+
+#include <gtest/gtest.h>
+#include <yeti/yeti.h>
+
+#include "gate_stream.h"
+
+
+TEST(YETI, PRIORITY_LANES) {
+  GateStream gate;
+  yeti::SetLogFileDesc(gate.fd());
+  yeti::SetLogLevel(yeti::LOG_LEVEL_TRACE);
+  yeti::SetLogFormatStr("%(MSG_ID) %(LEVEL) %(MSG)");
+
+  // block backend thread on the first record
+  INFO("first msg");
+  gate.WaitWriting();
+
+  const int trace_count = 1000;
+  for (int i = 0; i < trace_count; ++i) {
+    TRACE("trace msg %d", i);
+  }
+  ERROR("error msg");
+
+  gate.Open();
+  yeti::FlushLog();
+
+  auto lines = gate.GetLines();
+  ASSERT_EQ(trace_count + 2u, lines.size());
+  EXPECT_NE(std::string::npos, lines[0].find("first msg"));
+  // error record bypasses queued trace records but keeps its message ID
+  EXPECT_NE(std::string::npos, lines[1].find("error msg"));
+  EXPECT_EQ(trace_count + 1, std::atoi(lines[1].c_str()));
+  EXPECT_NE(std::string::npos, lines.back().find("trace msg"));
+
+  yeti::SetLogFileDesc(stderr);
+}
+
+TEST(YETI, CONTROL_TASK_ORDER) {
+  FILE* fd = std::tmpfile();
+  FILE* new_fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogLevel(yeti::LOG_LEVEL_TRACE);
+  for (int i = 0; i < 1000; ++i) {
+    TRACE("trace msg %d", i);
+  }
+  // closing is executed only after all records to closed descriptor
+  yeti::SetLogFileDesc(new_fd);
+  yeti::CloseLogFileDesc(fd);
+  ERROR("error msg");
+  yeti::FlushLog();
+
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(new_fd);
+}
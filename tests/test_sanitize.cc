@@ -0,0 +1,138 @@
+// Copyright (c) 2014-2015, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <yeti/yeti.h>
+
+#include "test_util.h"
+
+
+TEST(YETI, SANITIZE) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogSanitized(fd, true);
+  EXPECT_TRUE(yeti::IsLogSanitized(fd));
+  EXPECT_FALSE(yeti::IsLogSanitized(stderr));
+
+  // unsafe bytes at different offsets of vectorized scan
+  const std::string clean(40, 'a');
+  INF("%s", clean.c_str());
+  INF("line1\nline2\ttab\r");
+  INF("%s\033[31mred%s", clean.c_str(), clean.c_str());
+  INF("utf-8: \xd0\xb9\xe2\x82\xac\xf0\x9f\x98\x80, invalid: \xff\xc3(\xed\xa0\x80");
+  INF("100%% done %s", "%s%n");
+  INF_FMT("{}{}", std::string("a\0b", 3), clean);
+  yeti::FlushLog();
+
+  EXPECT_EQ(clean + "\n" +
+            "line1\\nline2\\ttab\\r\n" +
+            clean + "\\x1B[31mred" + clean + "\n" +
+            "utf-8: \xd0\xb9\xe2\x82\xac\xf0\x9f\x98\x80, "
+            "invalid: \\xFF\\xC3(\\xED\\xA0\\x80\n" +
+            "100% done %s%n\n" +
+            "a\\x00b" + clean + "\n",
+            ReadAll(fd));
+
+  yeti::SetLogSanitized(fd, false);
+  EXPECT_FALSE(yeti::IsLogSanitized(fd));
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
+
+TEST(YETI, SANITIZE_BACKSLASH) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogSanitized(fd, true);
+
+  // forged escape can't be told from real one unless backslash is escaped
+  const std::string clean(40, 'a');
+  INF("forged\\n real\n");
+  INF("%s\\x1B%s\\", clean.c_str(), clean.c_str());
+  yeti::FlushLog();
+
+  EXPECT_EQ("forged\\\\n real\\n\n" +
+            clean + "\\\\x1B" + clean + "\\\\\n",
+            ReadAll(fd));
+
+  yeti::SetLogSanitized(fd, false);
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
+
+TEST(YETI, NOT_SANITIZED) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+
+  INF("line1\nline2 %s", "%d");
+  yeti::FlushLog();
+
+  EXPECT_EQ("line1\nline2 %d\n", ReadAll(fd));
+
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
+
+TEST(YETI, SANITIZE_CONTEXT) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogFormatStr("<%(CTX:req)> %(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+
+  // context values are user text too
+  {
+    YETI_CONTEXT("req", "r1\nINF forged\033[0m");
+    INF("raw");
+    yeti::FlushLog();
+    yeti::SetLogSanitized(fd, true);
+    INF("escaped");
+    YETI_CONTEXT("req", "r2");
+    INF("clean");
+  }
+  yeti::FlushLog();
+
+  EXPECT_EQ("<r1\nINF forged\033[0m> raw\n"
+            "<r1\\nINF forged\\x1B[0m> escaped\n"
+            "<r2> clean\n",
+            ReadAll(fd));
+
+  yeti::SetLogSanitized(fd, false);
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
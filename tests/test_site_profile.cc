@@ -0,0 +1,188 @@
+// Copyright (c) 2014-2015, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+
+#include <cstdio>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <yeti/yeti.h>
+
+#include "test_util.h"
+
+
+yeti::LogSiteProfile GetSiteProfile(int line) {
+  for (const auto& site : yeti::GetLogSiteProfile()) {
+    if (site.line == line && site.file == __FILE__) return site;
+  }
+  yeti::LogSiteProfile site = yeti::LogSiteProfile();
+  site.line = line;
+  return site;
+}
+
+
+TEST(YETI, SITE_PROFILE) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogSiteProfiling(true);
+  EXPECT_TRUE(yeti::IsLogSiteProfiling());
+
+  int info_line = 0, debug_line = 0, fmt_line = 0, stream_line = 0,
+      limited_line = 0;
+  for (int i = 0; i < 100; ++i) {
+    INF("info %d", i); info_line = __LINE__;
+    DBG("debug %d", i); debug_line = __LINE__;
+    INF_FMT("fmt {}", i); fmt_line = __LINE__;
+    YETI_LOG(INF) << "stream " << i; stream_line = __LINE__;
+    INF_EVERY_N(10, "limited %d", i); limited_line = __LINE__;
+  }
+  yeti::FlushLog();
+  const std::string content = ReadAll(fd);
+
+  const yeti::LogSiteProfile info = GetSiteProfile(info_line);
+  EXPECT_EQ(yeti::LOG_LEVEL_INFO, info.level);
+  EXPECT_EQ(100u, info.calls);
+  EXPECT_EQ(100u, info.emitted);
+  EXPECT_EQ(0u, info.filtered);
+  EXPECT_EQ(std::string("info 0\n").size() * 10 +
+                std::string("info 10\n").size() * 90,
+            info.bytes);
+  EXPECT_GT(info.producer_time.count(), 0);
+
+  const yeti::LogSiteProfile debug = GetSiteProfile(debug_line);
+  EXPECT_EQ(100u, debug.calls);
+  EXPECT_EQ(0u, debug.emitted);
+  EXPECT_EQ(100u, debug.filtered);
+  EXPECT_EQ(0u, debug.bytes);
+
+  const yeti::LogSiteProfile fmt = GetSiteProfile(fmt_line);
+  EXPECT_EQ(100u, fmt.calls);
+  EXPECT_EQ(100u, fmt.emitted);
+  EXPECT_GT(fmt.bytes, 0u);
+
+  // stream checks level again when it's written
+  const yeti::LogSiteProfile stream = GetSiteProfile(stream_line);
+  EXPECT_EQ(100u, stream.calls);
+  EXPECT_EQ(100u, stream.emitted);
+
+  // suppressed calls are neither emitted nor filtered
+  const yeti::LogSiteProfile limited = GetSiteProfile(limited_line);
+  EXPECT_EQ(100u, limited.calls);
+  EXPECT_EQ(10u, limited.emitted);
+  EXPECT_EQ(0u, limited.filtered);
+
+  std::size_t bytes = 0;
+  for (const auto& site : yeti::GetLogSiteProfile()) {
+    if (site.file == __FILE__) bytes += site.bytes;
+  }
+  EXPECT_EQ(content.size(), bytes);
+
+  // counters are kept but not updated while profiling is off
+  yeti::SetLogSiteProfiling(false);
+  EXPECT_FALSE(yeti::IsLogSiteProfiling());
+  for (int i = 0; i < 10; ++i) {
+    INF("info %d", i); info_line = __LINE__;
+  }
+  yeti::FlushLog();
+  EXPECT_EQ(0u, GetSiteProfile(info_line).calls);
+  EXPECT_EQ(100u, GetSiteProfile(debug_line).calls);
+
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
+
+TEST(YETI, SITE_PROFILE_THREADS) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  ASSERT_TRUE(yeti::ApplyLogConfig("profile = on"));
+  EXPECT_TRUE(yeti::IsLogSiteProfiling());
+
+  // counters of finished threads are retired, of running ones are summed up
+  const int kThreads = 4;
+  int line = 0;
+  auto log = [&line](int thread) {
+    for (int i = 0; i < 1000; ++i) {
+      INF("thread %d msg %d", thread, i); line = __LINE__;
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back(log, i);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  log(kThreads);
+  yeti::FlushLog();
+
+  const yeti::LogSiteProfile site = GetSiteProfile(line);
+  EXPECT_EQ(1000u * (kThreads + 1), site.calls);
+  EXPECT_EQ(1000u * (kThreads + 1), site.emitted);
+  EXPECT_EQ(ReadAll(fd).size(), site.bytes);
+
+  ASSERT_TRUE(yeti::ApplyLogConfig("profile = off"));
+  EXPECT_FALSE(yeti::IsLogSiteProfiling());
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
+
+TEST(YETI, SITE_PROFILE_DUMP) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogSiteProfiling(true);
+  int line = 0;
+  for (int i = 0; i < 10; ++i) {
+    WRN("noisy warning %d", i); line = __LINE__;
+  }
+  yeti::FlushLog();
+  yeti::SetLogSiteProfiling(false);
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+
+  FILE* dump_fd = std::tmpfile();
+  yeti::DumpSiteProfile(1, dump_fd);
+  std::string dump = ReadAll(dump_fd);
+  EXPECT_EQ(0u, dump.find("log site profile: top 1 of "));
+  EXPECT_NE(std::string::npos, dump.find(" sites by bytes\n"));
+  EXPECT_NE(std::string::npos, dump.find(" sites by producer time\n"));
+  EXPECT_EQ(std::string::npos, dump.find("[WRN]"));
+  std::fclose(dump_fd);
+
+  dump_fd = std::tmpfile();
+  yeti::DumpSiteProfile(1000, dump_fd);
+  dump = ReadAll(dump_fd);
+  const std::string site =
+      std::string(__FILE__) + ":" + std::to_string(line) + " TestBody() [WRN]";
+  EXPECT_NE(std::string::npos, dump.find(site)) << dump;
+  std::fclose(dump_fd);
+}
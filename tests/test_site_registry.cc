@@ -0,0 +1,142 @@
+// Copyright (c) 2014-2015, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <yeti/yeti.h>
+
+#include "test_util.h"
+
+
+void Worker(int i) {
+  DBG("worker %d", i);
+}
+
+void Noisy(int i) {
+  INF_FMT("noisy {}", i);
+}
+
+void Later() {
+  YETI_LOG(TRC) << "later";
+}
+
+bool IsWorkerEnabled() {
+  yeti::LogSiteFilter filter;
+  filter.func = "Worker";
+  std::vector<yeti::LogSiteInfo> sites = yeti::GetLogSites(filter);
+  return sites.size() == 1 && sites[0].is_enabled;
+}
+
+
+TEST(YETI, SITE_MODE) {
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+
+  EXPECT_EQ("", Capture([] { Worker(1); }));
+
+  yeti::LogSiteFilter filter;
+  filter.file = "test_site_*.cc";
+  filter.format = "worker*";
+  EXPECT_EQ(1u, yeti::SetLogSiteMode(filter, yeti::LOG_SITE_ENABLED));
+  EXPECT_EQ("worker 2\n", Capture([] { Worker(2); }));
+
+  // sites are listed with their modes
+  std::vector<yeti::LogSiteInfo> sites = yeti::GetLogSites(filter);
+  ASSERT_EQ(1u, sites.size());
+  EXPECT_EQ("Worker", sites[0].func);
+  EXPECT_EQ("worker %d", sites[0].format);
+  EXPECT_EQ(yeti::LOG_LEVEL_DEBUG, sites[0].level);
+  EXPECT_EQ(yeti::LOG_SITE_ENABLED, sites[0].mode);
+  EXPECT_TRUE(sites[0].is_enabled);
+
+  // site is disabled by line range whatever logging level is
+  EXPECT_EQ("noisy 1\n", Capture([] { Noisy(1); }));
+  yeti::LogSiteFilter lines;
+  lines.first_line = yeti::GetLogSites(filter)[0].line;
+  lines.last_line = lines.first_line + 10;
+  EXPECT_EQ(2u, yeti::SetLogSiteMode(lines, yeti::LOG_SITE_DISABLED));
+  EXPECT_EQ("", Capture([] { Noisy(2); Worker(3); }));
+
+  // rules apply to sites registered later
+  filter = yeti::LogSiteFilter();
+  filter.func = "Later";
+  EXPECT_EQ(0u, yeti::SetLogSiteMode(filter, yeti::LOG_SITE_ENABLED));
+  EXPECT_EQ("later\n", Capture([] { Later(); }));
+
+  yeti::ResetLogSiteModes();
+  EXPECT_EQ("noisy 3\n", Capture([] { Noisy(3); Worker(4); Later(); }));
+  yeti::SetLogLevel(yeti::LOG_LEVEL_DEBUG);
+  EXPECT_EQ("worker 5\n", Capture([] { Worker(5); }));
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+}
+
+TEST(YETI, SITE_CONTROL) {
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  Worker(0);
+
+  EXPECT_TRUE(yeti::ApplyLogSiteControl(
+      "# comment\n\n  func Wor* format \"worker %d\" enable\n"));
+  EXPECT_TRUE(IsWorkerEnabled());
+  EXPECT_FALSE(yeti::ApplyLogSiteControl(
+      "func Worker speed 3 disable\nfunc Worker\nline 7-5 enable\n"));
+  EXPECT_TRUE(IsWorkerEnabled());
+  EXPECT_TRUE(yeti::ApplyLogSiteControl("func Worker line 1-100000 default"));
+  EXPECT_FALSE(IsWorkerEnabled());
+
+  char path[] = "/tmp/yeti_control_XXXXXX";
+  int file_desc = mkstemp(path);
+  ASSERT_NE(-1, file_desc);
+  close(file_desc);
+  std::ofstream(path) << "file test_site_registry.cc func Worker enable\n";
+  EXPECT_TRUE(yeti::SetLogSiteControlFile(path));
+  EXPECT_TRUE(IsWorkerEnabled());
+
+  // modified file is applied by backend
+  std::ofstream(path) << "func Worker disable\n";
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (IsWorkerEnabled() && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+  EXPECT_FALSE(IsWorkerEnabled());
+
+  EXPECT_TRUE(yeti::SetLogSiteControlFile(""));
+  EXPECT_FALSE(yeti::SetLogSiteControlFile("/nonexistent/yeti_control"));
+  EXPECT_TRUE(yeti::SetLogSiteControlFile(""));
+  yeti::ResetLogSiteModes();
+  std::remove(path);
+}
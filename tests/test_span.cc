@@ -0,0 +1,199 @@
+// Copyright (c) 2014-2015, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <yeti/yeti.h>
+
+#include "test_util.h"
+
+
+// returns number following key in line
+unsigned long long GetNumber(const std::string& line, const std::string& key) {
+  std::size_t pos = line.find(key);
+  if (pos == std::string::npos) return 0;
+  return std::strtoull(line.c_str() + pos + key.size(), nullptr, 10);
+}
+
+// returns events of trace file checking that they form JSON array
+std::vector<std::string> ParseTrace(FILE* fd) {
+  std::vector<std::string> lines = ReadLines(fd);
+  std::vector<std::string> events;
+  if (lines.empty() || lines[0] != "[") {
+    ADD_FAILURE() << "trace doesn't open array";
+    return events;
+  }
+  for (std::size_t i = 1; i < lines.size(); ++i) {
+    std::string event = lines[i];
+    const bool is_last = i + 1 == lines.size();
+    if (!is_last && !event.empty() && event.back() == ',') event.pop_back();
+    if (event.size() < 2 || event.front() != '{' || event.back() != '}') {
+      ADD_FAILURE() << "invalid element of trace: " << lines[i];
+      continue;
+    }
+    events.push_back(event);
+  }
+  return events;
+}
+
+
+TEST(YETI, SPAN) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+
+  {
+    YETI_SCOPE("outer");
+    {
+      YETI_SCOPE("inner");
+    }
+    YETI_SCOPE_AT(DBG, "filtered");
+  }
+  yeti::FlushLog();
+
+  std::vector<std::string> lines = ReadLines(fd);
+  ASSERT_EQ(2u, lines.size());
+  EXPECT_EQ(0u, lines[0].find("inner took ")) << lines[0];
+  EXPECT_EQ(0u, lines[1].find("outer took ")) << lines[1];
+  EXPECT_NE(std::string::npos, lines[0].find(" us depth=1 span_id="));
+  EXPECT_NE(std::string::npos, lines[1].find(" us depth=0 span_id="));
+
+  unsigned long long outer_id = GetNumber(lines[1], "span_id=");
+  EXPECT_NE(0u, outer_id);
+  EXPECT_EQ(0u, GetNumber(lines[1], "parent_id="));
+  EXPECT_EQ(outer_id, GetNumber(lines[0], "parent_id="));
+  EXPECT_NE(outer_id, GetNumber(lines[0], "span_id="));
+
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
+
+TEST(YETI, SPAN_TRACE) {
+  FILE* fd = std::tmpfile();
+  FILE* trace_fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogTraceFile(trace_fd);
+  EXPECT_EQ(trace_fd, yeti::GetLogTraceFile());
+
+  {
+    YETI_SCOPE("request");
+    YETI_CONTEXT("req", "r1");
+    YETI_SCOPE("parse \"body\"");
+    INF("plain record");
+  }
+  yeti::FlushLog();
+  yeti::SetLogTraceFile(nullptr);
+
+  EXPECT_EQ("plain record\n", ReadAll(fd));
+  std::vector<std::string> events = ReadLines(trace_fd);
+  ASSERT_EQ(3u, events.size());
+  EXPECT_EQ("[", events[0]);
+  EXPECT_EQ(0u, events[1].find("{\"name\":\"parse \\\"body\\\"\",\"cat\":\"yeti\","
+                               "\"ph\":\"X\",\"ts\":"))
+      << events[1];
+  EXPECT_NE(std::string::npos,
+            events[1].find(",\"depth\":1,\"req\":\"r1\"}},")) << events[1];
+  EXPECT_EQ(0u, events[2].find("{\"name\":\"request\",")) << events[2];
+  EXPECT_NE(std::string::npos, events[2].find(",\"tid\":1,")) << events[2];
+  EXPECT_EQ('}', events[2].back());
+
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+  std::fclose(trace_fd);
+}
+
+TEST(YETI, SPAN_TRACE_SWITCH) {
+  FILE* first_fd = std::tmpfile();
+  FILE* second_fd = std::tmpfile();
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+
+  // every trace file opens its own array
+  yeti::SetLogTraceFile(first_fd);
+  { YETI_SCOPE("first"); }
+  { YETI_SCOPE("first again"); }
+  yeti::SetLogTraceFile(second_fd);
+  { YETI_SCOPE("second"); }
+  yeti::FlushLog();
+  yeti::SetLogTraceFile(nullptr);
+
+  std::vector<std::string> events = ParseTrace(first_fd);
+  ASSERT_EQ(2u, events.size());
+  EXPECT_EQ(0u, events[0].find("{\"name\":\"first\",")) << events[0];
+  EXPECT_EQ(0u, events[1].find("{\"name\":\"first again\",")) << events[1];
+  events = ParseTrace(second_fd);
+  ASSERT_EQ(1u, events.size());
+  EXPECT_EQ(0u, events[0].find("{\"name\":\"second\",")) << events[0];
+  EXPECT_NE(std::string::npos, events[0].find(",\"tid\":1,")) << events[0];
+
+  // new file may get address of closed one
+  std::fclose(second_fd);
+  FILE* third_fd = std::tmpfile();
+  yeti::SetLogTraceFile(third_fd);
+  { YETI_SCOPE("third"); }
+  yeti::FlushLog();
+  yeti::SetLogTraceFile(nullptr);
+  events = ParseTrace(third_fd);
+  ASSERT_EQ(1u, events.size());
+  EXPECT_EQ(0u, events[0].find("{\"name\":\"third\",")) << events[0];
+
+  std::fclose(first_fd);
+  std::fclose(third_fd);
+}
+
+TEST(YETI, SPAN_JSON) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogOutput(yeti::LOG_OUTPUT_JSON);
+
+  {
+    YETI_SCOPE("work");
+  }
+  yeti::FlushLog();
+
+  std::vector<std::string> lines = ReadLines(fd);
+  ASSERT_EQ(1u, lines.size());
+  EXPECT_NE(std::string::npos, lines[0].find("\"msg\":\"work took "))
+      << lines[0];
+  EXPECT_NE(std::string::npos,
+            lines[0].find(",\"span\":\"work\",\"dur_ns\":")) << lines[0];
+  EXPECT_NE(std::string::npos, lines[0].find(",\"depth\":0,\"span_id\":"))
+      << lines[0];
+
+  yeti::SetLogOutput(yeti::LOG_OUTPUT_TEXT);
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
@@ -0,0 +1,161 @@
+// Copyright (c) 2014-2015, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+
+#include <cstdio>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <yeti/yeti.h>
+
+#include "gate_stream.h"
+#include "test_util.h"
+
+
+yeti::LogSinkStats GetSinkStats(FILE* fd) {
+  for (const auto& sink : yeti::GetLogStats().sinks) {
+    if (sink.fd == fd) return sink;
+  }
+  yeti::LogSinkStats sink = yeti::LogSinkStats();
+  sink.fd = fd;
+  return sink;
+}
+
+bool HasLine(const std::vector<std::string>& lines, const std::string& text) {
+  for (const auto& line : lines) {
+    if (line.find(text) != std::string::npos) return true;
+  }
+  return false;
+}
+
+// stalls sink of gate by blocking the first write for stall_time
+void StallSink(GateStream* gate, std::chrono::milliseconds stall_time) {
+  WRN("slow msg");
+  gate->WaitWriting();
+  std::this_thread::sleep_for(stall_time);
+  gate->Open();
+  yeti::FlushLog();
+}
+
+yeti::LogStallPolicy MakePolicy(std::chrono::milliseconds probe_interval,
+                                FILE* fallback) {
+  return yeti::LogStallPolicy{std::chrono::milliseconds(20), probe_interval,
+                              fallback, yeti::LOG_LEVEL_WARNING};
+}
+
+
+TEST(YETI, STALL_FALLBACK) {
+  GateStream gate;
+  FILE* fallback = std::tmpfile();
+  yeti::SetLogFileDesc(gate.fd());
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogStallPolicy(MakePolicy(std::chrono::hours(1), fallback));
+  EXPECT_EQ(20, yeti::GetLogStallPolicy().threshold.count());
+  EXPECT_EQ(fallback, yeti::GetLogStallPolicy().fallback);
+
+  StallSink(&gate, std::chrono::milliseconds(50));
+  yeti::LogSinkStats sink = GetSinkStats(gate.fd());
+  EXPECT_TRUE(sink.is_stalled);
+  EXPECT_EQ(1u, sink.stalls);
+
+  // records of stalled sink are rerouted, warning about stall too
+  for (int i = 0; i < 10; ++i) {
+    INF("rerouted msg %d", i);
+  }
+  yeti::FlushLog();
+  std::string content = ReadAll(fallback);
+  EXPECT_NE(std::string::npos, content.find(" stalled (write took "));
+  EXPECT_NE(std::string::npos, content.find("rerouted msg 9\n"));
+  sink = GetSinkStats(gate.fd());
+  EXPECT_EQ(11u, sink.rerouted);
+  EXPECT_EQ(1u, GetSinkStats(gate.fd()).stalls);
+  EXPECT_FALSE(HasLine(gate.GetLines(), "rerouted msg"));
+
+  // probe finds sink fast again
+  yeti::SetLogStallPolicy(MakePolicy(std::chrono::milliseconds(0), fallback));
+  INF("probe msg");
+  yeti::FlushLog();
+  EXPECT_FALSE(GetSinkStats(gate.fd()).is_stalled);
+  const std::vector<std::string> lines = gate.GetLines();
+  EXPECT_TRUE(HasLine(lines, "probe msg"));
+  EXPECT_TRUE(HasLine(lines, " recovered (write took "));
+
+  yeti::SetLogStallPolicy(yeti::LogStallPolicy{
+      std::chrono::milliseconds(0), std::chrono::milliseconds(1000), nullptr,
+      yeti::LOG_LEVEL_WARNING});
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fallback);
+}
+
+TEST(YETI, STALL_DROP) {
+  GateStream gate;
+  yeti::SetLogFileDesc(gate.fd());
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogStallPolicy(MakePolicy(std::chrono::hours(1), nullptr));
+  const int info = yeti::LOG_LEVEL_INFO;
+  const yeti::LogStats before = yeti::GetLogStats();
+
+  StallSink(&gate, std::chrono::milliseconds(50));
+  EXPECT_TRUE(GetSinkStats(gate.fd()).is_stalled);
+
+  // low levels are dropped, severe ones are still written
+  for (int i = 0; i < 10; ++i) {
+    INF("dropped msg %d", i);
+  }
+  ERR("kept msg");
+  yeti::FlushLog();
+  const yeti::LogStats after = yeti::GetLogStats();
+  const yeti::LogSinkStats sink = GetSinkStats(gate.fd());
+  EXPECT_EQ(10u, sink.discarded);
+  EXPECT_EQ(10u, after.dropped[info] - before.dropped[info]);
+  EXPECT_EQ(0u, after.written[info] - before.written[info]);
+  std::vector<std::string> lines = gate.GetLines();
+  EXPECT_FALSE(HasLine(lines, "dropped msg"));
+  EXPECT_TRUE(HasLine(lines, "kept msg"));
+  EXPECT_TRUE(HasLine(lines, " stalled (write took "));
+  // only probe recovers sink: buffered writes are fast anyway
+  EXPECT_TRUE(sink.is_stalled);
+
+  yeti::SetLogStallPolicy(MakePolicy(std::chrono::milliseconds(0), nullptr));
+  INF("probe msg");
+  yeti::FlushLog();
+  EXPECT_FALSE(GetSinkStats(gate.fd()).is_stalled);
+  lines = gate.GetLines();
+  EXPECT_TRUE(HasLine(lines, "probe msg"));
+  EXPECT_TRUE(HasLine(lines, " recovered (write took "));
+
+  yeti::SetLogStallPolicy(yeti::LogStallPolicy{
+      std::chrono::milliseconds(0), std::chrono::milliseconds(1000), nullptr,
+      yeti::LOG_LEVEL_WARNING});
+  yeti::SetLogFileDesc(stderr);
+}
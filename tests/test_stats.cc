@@ -0,0 +1,188 @@
+// Copyright (c) 2014-2015, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+
+#include <cstdio>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <yeti/yeti.h>
+
+#include "gate_stream.h"
+#include "test_util.h"
+
+
+yeti::LogSinkStats GetSinkStats(const yeti::LogStats& stats, FILE* fd) {
+  for (const auto& sink : stats.sinks) {
+    if (sink.fd == fd) return sink;
+  }
+  return yeti::LogSinkStats{fd, 0, 0};
+}
+
+
+TEST(YETI, STATS) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::FlushLog();
+  const yeti::LogStats before = yeti::GetLogStats();
+
+  for (int i = 0; i < 10; ++i) {
+    INF("info %d", i);
+  }
+  for (int i = 0; i < 5; ++i) {
+    WRN("warning %d", i);
+  }
+  DBG("filtered");
+  yeti::SetLogDedup(fd, std::chrono::milliseconds(60000));
+  for (int i = 0; i < 5; ++i) {
+    ERR("repeated");
+  }
+  yeti::SetLogDedup(fd, std::chrono::milliseconds(0));
+  yeti::FlushLog();
+
+  const yeti::LogStats after = yeti::GetLogStats();
+  const int info = yeti::LOG_LEVEL_INFO;
+  const int warning = yeti::LOG_LEVEL_WARNING;
+  const int error = yeti::LOG_LEVEL_ERROR;
+  const int debug = yeti::LOG_LEVEL_DEBUG;
+  EXPECT_EQ(10u, after.enqueued[info] - before.enqueued[info]);
+  EXPECT_EQ(10u, after.written[info] - before.written[info]);
+  EXPECT_EQ(5u, after.enqueued[warning] - before.enqueued[warning]);
+  EXPECT_EQ(5u, after.written[warning] - before.written[warning]);
+  EXPECT_EQ(0u, after.enqueued[debug] - before.enqueued[debug]);
+  EXPECT_EQ(5u, after.enqueued[error] - before.enqueued[error]);
+  EXPECT_EQ(1u, after.written[error] - before.written[error]);
+  EXPECT_EQ(4u, after.dropped[error] - before.dropped[error]);
+
+  // summary of repeated records is written into sink too
+  const yeti::LogSinkStats sink = GetSinkStats(after, fd);
+  EXPECT_EQ(17u, sink.records);
+  EXPECT_EQ(ReadAll(fd).size(), sink.bytes);
+  EXPECT_EQ(0u, after.queue_depth);
+  EXPECT_GT(after.batches, before.batches);
+  EXPECT_GE(after.batched_tasks - before.batched_tasks, 20u);
+  EXPECT_GE(after.max_batch_size, 1u);
+  EXPECT_GE(after.busy_time.count(), before.busy_time.count());
+
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
+
+TEST(YETI, STATS_QUEUE_DEPTH) {
+  GateStream gate;
+  yeti::SetLogFileDesc(gate.fd());
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+
+  // block backend thread on the first record
+  INF("first msg");
+  gate.WaitWriting();
+  for (int i = 0; i < 100; ++i) {
+    INF("queued msg %d", i);
+  }
+  yeti::LogStats stats = yeti::GetLogStats();
+  EXPECT_EQ(100u, stats.queue_depth);
+  EXPECT_GE(stats.peak_queue_depth, 100u);
+
+  gate.Open();
+  yeti::FlushLog();
+  stats = yeti::GetLogStats();
+  EXPECT_EQ(0u, stats.queue_depth);
+  EXPECT_GE(stats.peak_queue_depth, 100u);
+  EXPECT_GT(stats.idle_time.count(), 0);
+  yeti::SetLogFileDesc(stderr);
+}
+
+TEST(YETI, STATS_LATENCY) {
+  GateStream gate;
+  yeti::SetLogFileDesc(gate.fd());
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::FlushLog();
+  const int warning = yeti::LOG_LEVEL_WARNING;
+  const yeti::LogStats before = yeti::GetLogStats();
+
+  // records wait in queue while backend is blocked
+  WRN("first msg");
+  gate.WaitWriting();
+  for (int i = 0; i < 200; ++i) {
+    WRN("queued msg %d", i);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  gate.Open();
+  yeti::FlushLog();
+
+  const yeti::LogStats after = yeti::GetLogStats();
+  const yeti::LogLatency& latency = after.write_latency[warning];
+  EXPECT_EQ(201u, latency.count - before.write_latency[warning].count);
+  EXPECT_LE(latency.p50.count(), latency.p99.count());
+  EXPECT_LE(latency.p99.count(), latency.p999.count());
+  EXPECT_LE(latency.p999.count(), latency.max.count());
+  EXPECT_GE(latency.p99, std::chrono::milliseconds(50));
+  EXPECT_GE(latency.max, std::chrono::milliseconds(50));
+
+  // address of closed sink may be reused by the gate, so diff its counters
+  const yeti::LogSinkStats sink = GetSinkStats(after, gate.fd());
+  EXPECT_EQ(201u, sink.write_latency.count -
+                      GetSinkStats(before, gate.fd()).write_latency.count);
+  EXPECT_GE(sink.write_latency.max, std::chrono::milliseconds(50));
+
+  // every 64th call of thread is sampled
+  const yeti::LogLatency& call = after.call_latency[warning];
+  EXPECT_GE(call.count - before.call_latency[warning].count, 3u);
+  EXPECT_GT(call.max.count(), 0);
+  EXPECT_LT(call.p50, latency.p50);
+  yeti::SetLogFileDesc(stderr);
+}
+
+TEST(YETI, STATS_INTERVAL) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogStatsInterval(std::chrono::milliseconds(20));
+  EXPECT_EQ(20, yeti::GetLogStatsInterval().count());
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  std::string content;
+  while (content.find("log stats: ") == std::string::npos &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    yeti::FlushLog();
+    content = ReadAll(fd);
+  }
+  EXPECT_NE(std::string::npos, content.find("log stats: enqueued "));
+
+  yeti::SetLogStatsInterval(std::chrono::milliseconds(0));
+  yeti::FlushLog();
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
@@ -0,0 +1,150 @@
+// Copyright (c) 2014-2015, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+
+#include <cstdio>
+
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <yeti/yeti.h>
+
+#include "test_util.h"
+
+
+struct Point {
+  int x;
+  int y;
+};
+
+std::ostream& operator<<(std::ostream& os, const Point& point) {
+  return os << "(" << point.x << ", " << point.y << ")";
+}
+
+struct Noisy {};
+
+std::ostream& operator<<(std::ostream& os, const Noisy&) {
+  // record logged while another one is being written
+  YETI_LOG(INF) << "nested";
+  return os << "noisy";
+}
+
+// turns off all call sites of function while record is being written
+struct SiteSwitch {
+  const char* func;
+};
+
+std::ostream& operator<<(std::ostream& os, const SiteSwitch& site_switch) {
+  yeti::LogSiteFilter filter;
+  filter.func = site_switch.func;
+  yeti::SetLogSiteMode(filter, yeti::LOG_SITE_DISABLED);
+  return os;
+}
+
+int CountCall(int* count) {
+  return ++*count;
+}
+
+
+TEST(YETI, STREAM) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+
+  int count = 0;
+  YETI_LOG(INF) << "point " << Point{1, 2} << ", hex " << std::hex << 255;
+  YETI_LOG(INF) << 255 << " " << std::setw(4) << 7;  // format is reset
+  YETI_LOG(DBG) << "not written " << CountCall(&count);
+  YETI_LOG(INF) << Noisy();
+  const std::string payload(5000, 'x');
+  YETI_LOG(INF) << payload;
+  if (count == 0)
+    YETI_LOG(INF) << "in if";
+  else
+    YETI_LOG(INF) << "in else";
+  yeti::FlushLog();
+
+  EXPECT_EQ(0, count);
+  auto lines = ReadLines(fd);
+  ASSERT_EQ(6u, lines.size());
+  EXPECT_EQ("point (1, 2), hex ff", lines[0]);
+  EXPECT_EQ("255    7", lines[1]);
+  EXPECT_EQ("nested", lines[2]);
+  EXPECT_EQ("noisy", lines[3]);
+  EXPECT_EQ(payload, lines[4]);
+  EXPECT_EQ("in if", lines[5]);
+
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
+
+TEST(YETI, STREAM_BACKTRACE) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogBacktrace(4);
+
+  YETI_LOG(DBG) << "step " << 1;
+  YETI_LOG(ERR) << "failed";
+  yeti::FlushLog();
+
+  auto lines = ReadLines(fd);
+  ASSERT_EQ(2u, lines.size());
+  EXPECT_EQ("step 1", lines[0]);
+  EXPECT_EQ("failed", lines[1]);
+
+  yeti::SetLogBacktrace(0);
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
+
+TEST(YETI, STREAM_SITE_TURNED_OFF) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  yeti::SetLogBacktrace(4);
+
+  // record of site turned off after macro has checked it isn't captured
+  YETI_LOG(DBG) << "dropped " << SiteSwitch{__func__};
+  yeti::ResetLogSiteModes();
+  YETI_LOG(ERR) << "failed";
+  yeti::FlushLog();
+
+  auto lines = ReadLines(fd);
+  ASSERT_EQ(1u, lines.size());
+  EXPECT_EQ("failed", lines[0]);
+
+  yeti::SetLogBacktrace(0);
+  yeti::SetLogFileDesc(stderr);
+  std::fclose(fd);
+}
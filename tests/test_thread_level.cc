@@ -0,0 +1,119 @@
+// Copyright (c) 2014-2015, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+
+#include <cstdio>
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+#include <yeti/yeti.h>
+
+#include "test_util.h"
+
+
+void Debug(const char* name) {
+  DBG("%s", name);
+}
+
+void Info(const char* name) {
+  INF("%s", name);
+}
+
+
+TEST(YETI, THREAD_LEVEL) {
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+  EXPECT_EQ(yeti::LOG_LEVEL_INFO, yeti::GetThreadLogLevel());
+
+  // override of thread does not affect other threads
+  EXPECT_EQ("worker\n", Capture([] {
+    std::thread worker([] {
+      yeti::SetThreadLogLevel(yeti::LOG_LEVEL_DEBUG);
+      EXPECT_EQ(yeti::LOG_LEVEL_DEBUG, yeti::GetThreadLogLevel());
+      Debug("worker");
+      yeti::ResetThreadLogLevel();
+      Debug("worker reset");
+    });
+    worker.join();
+    Debug("main");
+  }));
+  EXPECT_EQ(yeti::LOG_LEVEL_INFO, yeti::GetThreadLogLevel());
+
+  // lowered level of thread suppresses records of thread only
+  EXPECT_EQ("main\n", Capture([] {
+    std::thread worker([] {
+      yeti::SetThreadLogLevel(yeti::LOG_LEVEL_WARNING);
+      Info("worker");
+      yeti::ResetThreadLogLevel();
+    });
+    worker.join();
+    Info("main");
+  }));
+
+  // global level changes are seen by threads with cached levels
+  EXPECT_EQ("main\n", Capture([] {
+    yeti::SetThreadLogLevel(yeti::LOG_LEVEL_DEBUG);
+    Debug("main");
+    yeti::SetThreadLogLevel(yeti::LOG_LEVEL_INFO);
+    Debug("main off");
+  }));
+  yeti::ResetThreadLogLevel();
+}
+
+TEST(YETI, THREAD_LEVEL_BY_ID) {
+  yeti::SetLogFormatStr("%(MSG)");
+  yeti::SetLogLevel(yeti::LOG_LEVEL_INFO);
+
+  std::atomic<int> step(0);
+  auto wait_for = [&step](int value) {
+    while (step.load() != value) std::this_thread::yield();
+  };
+  std::string content = Capture([&] {
+    std::thread worker([&] {
+      Debug("before");
+      step = 1;
+      wait_for(2);
+      Debug("after");
+      step = 3;
+      wait_for(4);
+      Debug("reset");
+    });
+    wait_for(1);
+    EXPECT_EQ(yeti::LOG_LEVEL_INFO, yeti::GetThreadLogLevel(worker.get_id()));
+    yeti::SetThreadLogLevel(worker.get_id(), yeti::LOG_LEVEL_TRACE);
+    EXPECT_EQ(yeti::LOG_LEVEL_TRACE, yeti::GetThreadLogLevel(worker.get_id()));
+    step = 2;
+    wait_for(3);
+    yeti::ResetThreadLogLevel(worker.get_id());
+    step = 4;
+    worker.join();
+  });
+  EXPECT_EQ("after\n", content);
+}
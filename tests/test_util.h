@@ -0,0 +1,80 @@
+// Copyright (c) 2014-2015, Dmitry Senin (seninds@gmail.com)
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   1. Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//   2. Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// yeti - C++ lightweight threadsafe logging
+// URL: https://github.com/seninds/yeti.git
+
+
+#ifndef TESTS_TEST_UTIL_H_
+#define TESTS_TEST_UTIL_H_
+
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+#include <yeti/yeti.h>
+
+/** @brief Returns content of file written so far. */
+inline std::string ReadAll(FILE* fd) {
+  std::fflush(fd);
+  std::rewind(fd);
+  std::string content;
+  int c;
+  while ((c = std::fgetc(fd)) != EOF) {
+    content.push_back(static_cast<char>(c));
+  }
+  return content;
+}
+
+/**
+ * @brief Returns lines of file without line breaks (the last one may be not
+ * terminated).
+ */
+inline std::vector<std::string> ReadLines(FILE* fd) {
+  std::vector<std::string> lines;
+  std::string content = ReadAll(fd);
+  std::size_t begin = 0;
+  for (std::size_t end; (end = content.find('\n', begin)) != std::string::npos;
+       begin = end + 1) {
+    lines.push_back(content.substr(begin, end - begin));
+  }
+  if (begin < content.size()) lines.push_back(content.substr(begin));
+  return lines;
+}
+
+/** @brief Returns what is written by the default logger while f runs. */
+template <typename Func>
+std::string Capture(Func f) {
+  FILE* fd = std::tmpfile();
+  yeti::SetLogFileDesc(fd);
+  f();
+  yeti::FlushLog();
+  yeti::SetLogFileDesc(stderr);
+  std::string content = ReadAll(fd);
+  std::fclose(fd);
+  return content;
+}
+
+#endif  // TESTS_TEST_UTIL_H_